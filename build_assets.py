@@ -0,0 +1,211 @@
+# This script converts the PNG images in data/ into run-length encoded
+# blobs in the pixel format of their destination, so the pendant can draw
+# them without inflating PNGs at runtime.  See src/Assets.h for the format.
+#
+# It runs automatically as a "pre:" extra script before each build, and
+# can also be run by hand with "python build_assets.py".  Outputs are only
+# rewritten when a PNG is newer than them, or for the atlas, when icons
+# have been added or removed.  Blobs whose PNG is gone are deleted.
+#   icons.rle       - atlas of all images smaller than the canvas, RGB332
+#   <name>.rle      - full-canvas backgrounds, RGB332
+#   fluid_dial.rle  - the boot logo, RGB565, drawn directly on the panel
+
+import os
+import struct
+import zlib
+
+CANVAS_SIZE = 240
+PANEL_IMAGES = ["fluid_dial.png"]
+ATLAS = "icons.rle"
+
+RGB332 = 1
+RGB565 = 2
+
+SKIP, RUN, LITERAL, BLEND = 0, 1, 2, 3
+MAX_COUNT = 64
+
+
+def read_png(path):
+    """Returns (width, height, rows) where rows are lists of (r, g, b, a)"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError(path + ": not a PNG file")
+    pos = 8
+    idat = b""
+    while pos < len(data):
+        length, kind = struct.unpack(">I4s", data[pos : pos + 8])
+        body = data[pos + 8 : pos + 8 + length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            width, height, depth, color_type, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif kind == b"IDAT":
+            idat += body
+        elif kind == b"IEND":
+            break
+    if depth != 8 or color_type not in (2, 6) or interlace:
+        raise ValueError(path + ": only 8-bit non-interlaced RGB/RGBA PNGs are supported")
+
+    bpp = 4 if color_type == 6 else 3
+    stride = width * bpp
+    raw = zlib.decompress(idat)
+    rows = []
+    prev = bytearray(stride)
+    for y in range(height):
+        start = y * (stride + 1)
+        filter_type = raw[start]
+        line = bytearray(raw[start + 1 : start + 1 + stride])
+        for i in range(stride):
+            a = line[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            if filter_type == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif filter_type == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif filter_type == 3:
+                line[i] = (line[i] + ((a + b) >> 1)) & 0xFF
+            elif filter_type == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                pred = a if pa <= pb and pa <= pc else (b if pb <= pc else c)
+                line[i] = (line[i] + pred) & 0xFF
+        prev = line
+        if bpp == 4:
+            rows.append([tuple(line[x * 4 : x * 4 + 4]) for x in range(width)])
+        else:
+            rows.append([tuple(line[x * 3 : x * 3 + 3]) + (255,) for x in range(width)])
+    return width, height, rows
+
+
+def pack_pixel(r, g, b, fmt):
+    if fmt == RGB332:
+        return bytes([(r & 0xE0) | ((g >> 3) & 0x1C) | (b >> 6)])
+    return struct.pack("<H", ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3))
+
+
+def encode(width, height, rows, fmt):
+    out = bytearray(b"FDI1" + struct.pack("<HHBB", width, height, fmt, 0))
+    for row in rows:
+        x = 0
+        while x < width:
+            r, g, b, a = row[x]
+            if a == 0:
+                n = 1
+                while x + n < width and n < MAX_COUNT and row[x + n][3] == 0:
+                    n += 1
+                out.append((SKIP << 6) | (n - 1))
+            elif a < 255:
+                n = 1
+                while x + n < width and n < MAX_COUNT and 0 < row[x + n][3] < 255:
+                    n += 1
+                out.append((BLEND << 6) | (n - 1))
+                for r, g, b, a in row[x : x + n]:
+                    out.append(a)
+                    out += pack_pixel(r, g, b, fmt)
+            else:
+                value = pack_pixel(r, g, b, fmt)
+
+                def same(i):
+                    p = row[i]
+                    return p[3] == 255 and pack_pixel(p[0], p[1], p[2], fmt) == value
+
+                n = 1
+                while x + n < width and n < MAX_COUNT and same(x + n):
+                    n += 1
+                if n > 1:
+                    out.append((RUN << 6) | (n - 1))
+                    out += value
+                else:
+                    # Extend the literal until a run of 3 or a non-opaque pixel
+                    n = 1
+                    while x + n < width and n < MAX_COUNT and row[x + n][3] == 255:
+                        p = row[x + n]
+                        v = pack_pixel(p[0], p[1], p[2], fmt)
+                        if x + n + 2 < width and all(
+                            row[x + n + k][3] == 255 and pack_pixel(*row[x + n + k][:3], fmt) == v for k in (1, 2)
+                        ):
+                            break
+                        n += 1
+                    out.append((LITERAL << 6) | (n - 1))
+                    for p in row[x : x + n]:
+                        out += pack_pixel(p[0], p[1], p[2], fmt)
+            x += n
+    return bytes(out)
+
+
+def newer(inputs, output):
+    if not os.path.exists(output):
+        return True
+    t = os.path.getmtime(output)
+    return any(os.path.getmtime(i) > t for i in inputs)
+
+
+def atlas_names(path):
+    """Returns the icon names in an existing atlas, or None if there is none"""
+    if not os.path.exists(path):
+        return None
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"FDA1":
+        return None
+    (count,) = struct.unpack("<H", data[4:6])
+    return [data[8 + 32 * i : 8 + 32 * i + 24].rstrip(b"\0").decode() for i in range(count)]
+
+
+def build_assets(data_dir):
+    icons = []
+    for name in sorted(os.listdir(data_dir)):
+        if not name.endswith(".png"):
+            continue
+        path = os.path.join(data_dir, name)
+        if name in PANEL_IMAGES:
+            fmt = RGB565
+        else:
+            fmt = RGB332
+            with open(path, "rb") as f:
+                width, height = struct.unpack(">II", f.read(24)[16:24])
+            if width < CANVAS_SIZE or height < CANVAS_SIZE:
+                icons.append(name)
+                continue
+        output = os.path.join(data_dir, name[:-4] + ".rle")
+        if newer([path], output):
+            blob = encode(*read_png(path), fmt)
+            with open(output, "wb") as f:
+                f.write(blob)
+            print("build_assets: %s -> %s (%d bytes)" % (name, os.path.basename(output), len(blob)))
+
+    # Blobs left over from PNGs that have been removed
+    for name in sorted(os.listdir(data_dir)):
+        if name.endswith(".rle") and name != ATLAS and not os.path.exists(os.path.join(data_dir, name[:-4] + ".png")):
+            os.remove(os.path.join(data_dir, name))
+            print("build_assets: removed %s" % name)
+
+    output = os.path.join(data_dir, ATLAS)
+    paths = [os.path.join(data_dir, name) for name in icons]
+    if not icons:
+        if os.path.exists(output):
+            os.remove(output)
+            print("build_assets: removed %s" % ATLAS)
+    elif newer(paths, output) or atlas_names(output) != icons:
+        blobs = [encode(*read_png(path), RGB332) for path in paths]
+        offset = 8 + 32 * len(icons)
+        atlas = bytearray(b"FDA1" + struct.pack("<HH", len(icons), 0))
+        for name, blob in zip(icons, blobs):
+            if len(name) >= 24:
+                raise ValueError(name + ": name too long for the icon atlas")
+            atlas += name.encode().ljust(24, b"\0") + struct.pack("<II", offset, len(blob))
+            offset += len(blob)
+        for blob in blobs:
+            atlas += blob
+        with open(output, "wb") as f:
+            f.write(atlas)
+        print("build_assets: %d icons -> %s (%d bytes)" % (len(icons), ATLAS, len(atlas)))
+
+
+try:
+    Import("env")
+    data_dir = env.subst("$PROJECT_DATA_DIR")
+except NameError:
+    data_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), "data")
+build_assets(data_dir)
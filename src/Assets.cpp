@@ -0,0 +1,377 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Assets.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+bool MemoryAssetReader::seek(size_t pos) {
+    if (pos > _len) {
+        return false;
+    }
+    _pos = pos;
+    return true;
+}
+size_t MemoryAssetReader::read(uint8_t* buf, size_t len) {
+    if (len > _len - _pos) {
+        len = _len - _pos;
+    }
+    memcpy(buf, _data + _pos, len);
+    _pos += len;
+    return len;
+}
+
+static uint16_t le16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+static uint32_t le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// A small read-ahead window so tokens can be fetched a byte at a time
+// without a call into the filesystem for each one.
+class AssetStream {
+private:
+    AssetReader& _in;
+    uint8_t      _buf[64];
+    size_t       _len = 0;
+    size_t       _pos = 0;
+
+public:
+    AssetStream(AssetReader& in) : _in(in) {}
+
+    bool get(uint8_t& c) {
+        if (_pos == _len) {
+            _len = _in.read(_buf, sizeof(_buf));
+            _pos = 0;
+            if (_len == 0) {
+                return false;
+            }
+        }
+        c = _buf[_pos++];
+        return true;
+    }
+    bool get(uint16_t& v, int bytes) {
+        uint8_t lo, hi = 0;
+        if (!get(lo) || (bytes == 2 && !get(hi))) {
+            return false;
+        }
+        v = lo | (hi << 8);
+        return true;
+    }
+};
+
+struct blob_header_t {
+    int     width;
+    int     height;
+    uint8_t format;
+};
+
+static bool read_header(AssetStream& in, blob_header_t& header) {
+    uint8_t h[10];
+    for (size_t i = 0; i < sizeof(h); ++i) {
+        if (!in.get(h[i])) {
+            return false;
+        }
+    }
+    if (memcmp(h, "FDI1", 4) != 0) {
+        return false;
+    }
+    header.width  = le16(h + 4);
+    header.height = le16(h + 6);
+    header.format = h[8];
+    return header.format == ASSET_RGB332 || header.format == ASSET_RGB565;
+}
+
+// Pixel format conversions
+
+struct rgb_t {
+    uint8_t r, g, b;
+};
+
+static rgb_t to_rgb(uint16_t v, uint8_t format) {
+    if (format == ASSET_RGB332) {
+        return { (uint8_t)(((v >> 5) & 7) * 255 / 7), (uint8_t)(((v >> 2) & 7) * 255 / 7), (uint8_t)((v & 3) * 255 / 3) };
+    }
+    return { (uint8_t)(((v >> 11) & 0x1f) * 255 / 31), (uint8_t)(((v >> 5) & 0x3f) * 255 / 63), (uint8_t)((v & 0x1f) * 255 / 31) };
+}
+static uint8_t to_rgb332(rgb_t c) {
+    return (c.r & 0xe0) | ((c.g >> 3) & 0x1c) | (c.b >> 6);
+}
+static uint16_t to_rgb565(rgb_t c) {
+    return ((c.r >> 3) << 11) | ((c.g >> 2) << 5) | (c.b >> 3);
+}
+static uint16_t to_rgb565(uint16_t v, uint8_t format) {
+    return format == ASSET_RGB565 ? v : to_rgb565(to_rgb(v, format));
+}
+static uint16_t swap16(uint16_t v) {
+    return (v >> 8) | (v << 8);
+}
+static rgb_t mix(rgb_t fg, rgb_t bg, int alpha) {
+    return { (uint8_t)((fg.r * alpha + bg.r * (255 - alpha)) / 255),
+             (uint8_t)((fg.g * alpha + bg.g * (255 - alpha)) / 255),
+             (uint8_t)((fg.b * alpha + bg.b * (255 - alpha)) / 255) };
+}
+
+// Writes pixels straight into the buffer of an 8-bit (RGB332) or
+// 16-bit (byte-swapped RGB565) sprite, clipping to the sprite bounds.
+// Other depths fall back to drawPixel().
+class SpriteSink {
+private:
+    LGFX_Sprite* _sprite;
+    uint8_t      _format;
+    int          _width;
+    int          _height;
+    int          _depth;
+    uint8_t*     _buf;
+
+    bool inside(int x, int y) { return x >= 0 && x < _width && y >= 0 && y < _height; }
+
+    void store(int x, int y, rgb_t c) {
+        if (_depth == 8) {
+            _buf[y * _width + x] = to_rgb332(c);
+        } else if (_depth == 16) {
+            reinterpret_cast<uint16_t*>(_buf)[y * _width + x] = swap16(to_rgb565(c));
+        } else {
+            _sprite->drawPixel(x, y, lgfx::color888(c.r, c.g, c.b));
+        }
+    }
+    rgb_t load(int x, int y) {
+        if (_depth == 8) {
+            return to_rgb(_buf[y * _width + x], ASSET_RGB332);
+        }
+        if (_depth == 16) {
+            return to_rgb(swap16(reinterpret_cast<uint16_t*>(_buf)[y * _width + x]), ASSET_RGB565);
+        }
+        auto c = _sprite->readPixelRGB(x, y);
+        return { c.r, c.g, c.b };
+    }
+
+public:
+    SpriteSink(LGFX_Sprite* sprite, uint8_t format) :
+        _sprite(sprite), _format(format), _width(sprite->width()), _height(sprite->height()),
+        _depth(sprite->getColorDepth() & 0xff), _buf(static_cast<uint8_t*>(sprite->getBuffer())) {}
+
+    void run(int x, int y, int n, uint16_t v) {
+        if (y < 0 || y >= _height) {
+            return;
+        }
+        int x0 = x < 0 ? 0 : x;
+        int x1 = (x + n) > _width ? _width : x + n;
+        if (_depth == 8 && _format == ASSET_RGB332) {
+            if (x1 > x0) {
+                memset(_buf + y * _width + x0, v, x1 - x0);
+            }
+            return;
+        }
+        rgb_t c = to_rgb(v, _format);
+        for (x = x0; x < x1; ++x) {
+            store(x, y, c);
+        }
+    }
+    void pixel(int x, int y, uint16_t v) {
+        if (!inside(x, y)) {
+            return;
+        }
+        if (_depth == 8 && _format == ASSET_RGB332) {
+            _buf[y * _width + x] = v;
+        } else if (_depth == 16) {
+            reinterpret_cast<uint16_t*>(_buf)[y * _width + x] = swap16(to_rgb565(v, _format));
+        } else {
+            store(x, y, to_rgb(v, _format));
+        }
+    }
+    void blend(int x, int y, uint16_t v, uint8_t alpha) {
+        if (inside(x, y)) {
+            store(x, y, mix(to_rgb(v, _format), load(x, y), alpha));
+        }
+    }
+    void flush() {}
+};
+
+// Sends pixels to the panel, batching each literal run into one pushImage()
+class PanelSink {
+private:
+    LGFX_Device* _panel;
+    uint8_t      _format;
+    uint16_t     _batch[64];
+    int          _batch_x = 0;
+    int          _batch_y = 0;
+    int          _batch_n = 0;
+
+public:
+    PanelSink(LGFX_Device* panel, uint8_t format) : _panel(panel), _format(format) {}
+
+    void flush() {
+        if (_batch_n) {
+            _panel->pushImage(_batch_x, _batch_y, _batch_n, 1, reinterpret_cast<lgfx::swap565_t*>(_batch));
+            _batch_n = 0;
+        }
+    }
+    void run(int x, int y, int n, uint16_t v) {
+        flush();
+        _panel->fillRect(x, y, n, 1, to_rgb565(v, _format));
+    }
+    void pixel(int x, int y, uint16_t v) {
+        if (_batch_n == 64 || (_batch_n && (y != _batch_y || x != _batch_x + _batch_n))) {
+            flush();
+        }
+        if (_batch_n == 0) {
+            _batch_x = x;
+            _batch_y = y;
+        }
+        _batch[_batch_n++] = swap16(to_rgb565(v, _format));
+    }
+    void blend(int x, int y, uint16_t v, uint8_t alpha) {
+        flush();
+        _panel->drawPixel(x, y, to_rgb565(mix(to_rgb(v, _format), { 0, 0, 0 }, alpha)));
+    }
+};
+
+template <class Sink>
+static bool decode(AssetStream& in, const blob_header_t& header, Sink& sink, int left, int top) {
+    int      bytes = header.format == ASSET_RGB565 ? 2 : 1;
+    uint8_t  token, alpha;
+    uint16_t v;
+    for (int row = 0; row < header.height; ++row) {
+        int y   = top + row;
+        int col = 0;
+        while (col < header.width) {
+            if (!in.get(token)) {
+                return false;
+            }
+            int n = (token & 0x3f) + 1;
+            int x = left + col;
+            switch (token >> 6) {
+                case ASSET_SKIP:
+                    break;
+                case ASSET_RUN:
+                    if (!in.get(v, bytes)) {
+                        return false;
+                    }
+                    sink.run(x, y, n, v);
+                    break;
+                case ASSET_LITERAL:
+                    for (int i = 0; i < n; ++i) {
+                        if (!in.get(v, bytes)) {
+                            return false;
+                        }
+                        sink.pixel(x + i, y, v);
+                    }
+                    break;
+                case ASSET_BLEND:
+                    for (int i = 0; i < n; ++i) {
+                        if (!in.get(alpha) || !in.get(v, bytes)) {
+                            return false;
+                        }
+                        sink.blend(x + i, y, v, alpha);
+                    }
+                    break;
+            }
+            col += n;
+        }
+    }
+    sink.flush();
+    return true;
+}
+
+bool drawAsset(AssetReader& in, LGFX_Sprite* sprite, int x, int y) {
+    AssetStream   stream(in);
+    blob_header_t header;
+    if (!read_header(stream, header)) {
+        return false;
+    }
+    SpriteSink sink(sprite, header.format);
+    int        left = sprite->width() / 2 + x - header.width / 2;
+    int        top  = sprite->height() / 2 - y - header.height / 2;
+    return decode(stream, header, sink, left, top);
+}
+
+bool drawAssetOnPanel(AssetReader& in, LGFX_Device* panel, int x, int y) {
+    AssetStream   stream(in);
+    blob_header_t header;
+    if (!read_header(stream, header)) {
+        return false;
+    }
+    PanelSink sink(panel, header.format);
+    panel->startWrite();
+    bool ok = decode(stream, header, sink, x - header.width / 2, y - header.height / 2);
+    panel->endWrite();
+    return ok;
+}
+
+bool drawPanelAsset(LGFX_Device* panel, const char* png_name, int x, int y) {
+    size_t       length;
+    AssetReader* asset = openAsset(png_name, length);
+    bool         drawn = asset && drawAssetOnPanel(*asset, panel, x, y);
+    delete asset;
+    return drawn;
+}
+
+// Icon atlas index, read once on first use
+
+static const char* atlas_file = "icons.rle";
+
+struct atlas_entry_t {
+    char     name[24];
+    uint32_t offset;
+    uint32_t length;
+};
+static std::vector<atlas_entry_t> atlas;
+static bool                       atlas_loaded = false;
+
+static void load_atlas() {
+    atlas_loaded    = true;
+    AssetReader* in = openAssetFile(atlas_file);
+    if (!in) {
+        return;
+    }
+    uint8_t header[8];
+    if (in->read(header, sizeof(header)) == sizeof(header) && memcmp(header, "FDA1", 4) == 0) {
+        int count = le16(header + 4);
+        for (int i = 0; i < count; ++i) {
+            uint8_t       raw[32];
+            atlas_entry_t entry;
+            if (in->read(raw, sizeof(raw)) != sizeof(raw)) {
+                atlas.clear();
+                break;
+            }
+            memcpy(entry.name, raw, sizeof(entry.name));
+            entry.name[sizeof(entry.name) - 1] = '\0';
+            entry.offset                       = le32(raw + 24);
+            entry.length                       = le32(raw + 28);
+            atlas.push_back(entry);
+        }
+    }
+    delete in;
+}
+
+AssetReader* openAsset(const char* png_name, size_t& length) {
+    if (!atlas_loaded) {
+        load_atlas();
+    }
+    for (auto const& entry : atlas) {
+        if (strcmp(entry.name, png_name) == 0) {
+            AssetReader* in = openAssetFile(atlas_file);
+            if (in && in->seek(entry.offset)) {
+                length = entry.length;
+                return in;
+            }
+            delete in;
+            return nullptr;
+        }
+    }
+
+    std::string rle_name(png_name);
+    size_t      dot = rle_name.rfind('.');
+    if (dot != std::string::npos) {
+        rle_name.erase(dot);
+    }
+    rle_name += ".rle";
+    AssetReader* in = openAssetFile(rle_name.c_str());
+    if (in) {
+        length = in->size();
+    }
+    return in;
+}
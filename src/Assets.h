@@ -0,0 +1,82 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Pre-converted image assets produced at build time by build_assets.py.
+// Each PNG in data/ is converted to a run-length encoded blob in the
+// pixel format of its destination, so drawing it is a streaming copy
+// with no inflate step and no decode buffer.
+//
+// Blob layout, little-endian:
+//   "FDI1"  u16 width  u16 height  u8 format  u8 reserved
+//   then, for each row, tokens until the row is complete.  A token byte
+//   holds a kind in the top two bits and a count-1 (1..64) in the rest:
+//     ASSET_SKIP     n transparent pixels
+//     ASSET_RUN      one pixel value repeated n times
+//     ASSET_LITERAL  n pixel values
+//     ASSET_BLEND    n pairs of (alpha byte, pixel value) for edge pixels
+//   Pixel values are one byte for RGB332 and two for RGB565.
+//
+// Menu icons are packed into one atlas file, icons.rle:
+//   "FDA1"  u16 count  u16 reserved
+//   count x { char name[24]; u32 offset; u32 length }, then the blobs.
+// Other images are stored one per file as <name>.rle.
+
+#pragma once
+
+#include "System.h"
+
+enum asset_format_t : uint8_t {
+    ASSET_RGB332 = 1,  // Native format of the 8-bit canvas
+    ASSET_RGB565 = 2,  // Native format of the panels, for drawing directly on the display
+};
+
+enum asset_token_t : uint8_t {
+    ASSET_SKIP    = 0,
+    ASSET_RUN     = 1,
+    ASSET_LITERAL = 2,
+    ASSET_BLEND   = 3,
+};
+
+// Sequential access to asset bytes, either from a file or from memory
+// such as the image cache or a memory-mapped flash partition.
+class AssetReader {
+public:
+    virtual ~AssetReader() {}
+    virtual bool   seek(size_t pos)               = 0;
+    virtual size_t read(uint8_t* buf, size_t len) = 0;
+    virtual size_t size()                         = 0;
+};
+
+class MemoryAssetReader : public AssetReader {
+private:
+    const uint8_t* _data;
+    size_t         _len;
+    size_t         _pos = 0;
+
+public:
+    MemoryAssetReader(const uint8_t* data, size_t len) : _data(data), _len(len) {}
+    bool   seek(size_t pos) override;
+    size_t read(uint8_t* buf, size_t len) override;
+    size_t size() override { return _len; }
+};
+
+// Platform-specific; returns nullptr if the file does not exist.
+// The caller deletes the reader.
+AssetReader* openAssetFile(const char* filename);
+
+// Finds the converted blob for a PNG file name such as "statustp.png",
+// in the icon atlas or in a separate .rle file.  On success the reader
+// is positioned at the start of the blob and length is its size.
+AssetReader* openAsset(const char* png_name, size_t& length);
+
+// Draws a blob, centered at x,y relative to the sprite center with +Y up
+// like drawPngFile(). Translucent pixels blend with the sprite contents.
+bool drawAsset(AssetReader& in, LGFX_Sprite* sprite, int x, int y);
+
+// Draws a blob directly on the panel, centered at x,y in panel coordinates.
+// Used for the boot logo, which is drawn on a cleared screen, so
+// translucent pixels are blended with black.
+bool drawAssetOnPanel(AssetReader& in, LGFX_Device* panel, int x, int y);
+
+// Convenience wrapper that finds the blob for png_name and draws it on the panel
+bool drawPanelAsset(LGFX_Device* panel, const char* png_name, int x, int y);
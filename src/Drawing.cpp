@@ -4,6 +4,11 @@
 #include "System.h"
 #include "Drawing.h"
 #include "alarm.h"
+#include "Scene.h"  // frame_rendered()
+#include "TileDiff.h"
+#include "Assets.h"
+#include "GlyphCache.h"
+#include "RenderProfile.h"
 #include <map>
 
 #ifdef USE_WIFI_PENDANT
@@ -69,14 +74,37 @@ void drawPngFile(const char* filename, Point xy) {
 void drawPngBackground(const char* filename) {
     drawPngFile(filename, 0, 0);
 }
+// The image drawBackground() last put under the scene, so retained
+// widgets can restore the part of it they cover
+static LGFX_Sprite* background_sprite = nullptr;
+
 void drawBackground(LGFX_Sprite* sprite) {
+    background_sprite = sprite;
     sprite->pushSprite(0, 0);
 }
+void forgetBackground() {
+    background_sprite = nullptr;
+}
+void restoreBackground(int x, int y, int width, int height) {
+    canvas.setClipRect(x, y, width, height);
+    system_background();
+    if (background_sprite) {
+        background_sprite->pushSprite(0, 0);
+    }
+    canvas.clearClipRect();
+}
 LGFX_Sprite* createPngBackground(const char* filename) {
     LGFX_Sprite* sprite = new LGFX_Sprite(&canvas);
     sprite->setColorDepth(canvas.getColorDepth());
     sprite->createSprite(canvas.width(), canvas.height());
-    drawPngFile(sprite, filename, 0, 0);
+    // This sprite is itself the cached copy, so bypass the image cache
+    const char*  name = filename[0] == '/' ? filename + 1 : filename;
+    size_t       length;
+    AssetReader* asset = openAsset(name, length);
+    if (!asset || !drawAsset(*asset, sprite, 0, 0)) {
+        decodePngFile(sprite, name, 0, 0);
+    }
+    delete asset;
     return sprite;
 }
 
@@ -218,10 +246,8 @@ void drawButtonLegends(const char* red, const char* green, const char* orange) {
 }
 
 void putDigit(int& n, int x, int y, int color) {
-    char txt[2] = { '\0', '\0' };
-    txt[0]      = "0123456789"[n % 10];
+    glyph_cache.draw("0123456789"[n % 10], x, y, color, MEDIUM, middle_right);
     n /= 10;
-    text(txt, x, y, color, MEDIUM, middle_right);
 }
 void fancyNumber(pos_t n, int n_decimals, int hl_digit, int x, int y, int text_color, int hl_text_color) {
     fontnum_t font     = SMALL;
@@ -257,7 +283,7 @@ void fancyNumber(pos_t n, int n_decimals, int hl_digit, int x, int y, int text_c
         x -= char_width;
     }
     if (n_decimals) {
-        text(".", x - 10, y, text_color, MEDIUM, middle_center);
+        glyph_cache.draw('.', x - 10, y, text_color, MEDIUM, middle_center);
         x -= char_width;
     }
     do {
@@ -265,25 +291,29 @@ void fancyNumber(pos_t n, int n_decimals, int hl_digit, int x, int y, int text_c
         x -= char_width;
     } while (ni || i <= hl_digit);
     if (isneg) {
-        text("-", x, y, text_color, MEDIUM, middle_right);
+        glyph_cache.draw('-', x, y, text_color, MEDIUM, middle_right);
     }
 }
 
 void DRO::drawHoming(int axis, bool highlight, bool homed) {
     text(axisNumToCStr(axis), text_left_x(), text_middle_y(), myLimitSwitches[axis] ? GREEN : YELLOW, MEDIUM, middle_left);
-    fancyNumber(myAxes[axis], num_digits(), -1, text_right_x(), text_middle_y(), highlight ? (homed ? GREEN : RED) : DARKGREY, RED);
+    fancyNumber(myAxes[axis], num_digits(axis), -1, text_right_x(), text_middle_y(), highlight ? (homed ? GREEN : RED) : DARKGREY, RED);
     advance();
 }
 
 void DRO::draw(int axis, int hl_digit, bool highlight) {
     text(axisNumToCStr(axis), text_left_x(), text_middle_y(), highlight ? GREEN : DARKGREY, MEDIUM, middle_left);
     fancyNumber(
-        myAxes[axis], num_digits(), hl_digit, text_right_x(), text_middle_y(), highlight ? WHITE : DARKGREY, highlight ? RED : DARKGREY);
+        myAxes[axis], num_digits(axis), hl_digit, text_right_x(), text_middle_y(), highlight ? WHITE : DARKGREY, highlight ? RED : DARKGREY);
     advance();
 }
 
 void DRO::draw(int axis, bool highlight) {
-    Stripe::draw(axisNumToChar(axis), pos_to_cstr(myAxes[axis], num_digits()), highlight, myLimitSwitches[axis] ? GREEN : WHITE);
+    char left[2] = { axisNumToChar(axis), '\0' };
+    drawOutlinedRect(widget_left_x(), _y, width(), height(), highlight ? BLUE : NAVY, WHITE);
+    text(left, text_left_x(), text_middle_y(), myLimitSwitches[axis] ? GREEN : WHITE, font(), middle_left);
+    number_text(pos_to_cstr(myAxes[axis], num_digits(axis)), text_right_x(), text_middle_y(), WHITE, font());
+    advance();
 }
 
 void LED::draw(bool highlighted) {
@@ -291,14 +321,68 @@ void LED::draw(bool highlighted) {
     _y += _gap;
 }
 
+void StripeWidget::draw(const char* left, const char* right, bool highlighted, int left_color) {
+    if (changed(WidgetKey().add(left).add(right).add(highlighted).add(left_color))) {
+        Stripe(_x, _y, _width, _height, _font).draw(left, right, highlighted, left_color);
+    }
+}
+
+void DROWidget::draw(int hl_digit, bool highlight) {
+    if (changed(WidgetKey().add(_axis).add(myAxes[_axis]).add(num_digits(_axis)).add(hl_digit).add(highlight))) {
+        // The digits are drawn without a stripe behind them
+        restoreBackground(_x, _y, _width, _height);
+        DRO(_x, _y, _width, _height).draw(_axis, hl_digit, highlight);
+    }
+}
+
+void LEDWidget::draw(bool highlighted) {
+    if (changed(WidgetKey().add(highlighted))) {
+        LED(_x + _radius, _y + _radius, _radius, 0).draw(highlighted);
+    }
+}
+
 void drawMenuTitle(const char* name) {
     centered_text(name, 12);
 }
 
+static TileDiff                  tile_diff;
+static std::vector<dirty_rect_t> dirty_rects;
+
+uint32_t last_refresh_pixels  = 0;
+uint64_t total_refresh_pixels = 0;
+
+// Call this after drawing directly on the panel or moving the canvas,
+// so the next refreshDisplay() sends the whole canvas.
+void invalidateDisplay() {
+    tile_diff.invalidate();
+}
+
+// Only the tiles that changed since the previous refresh are sent.
+// The clip rectangle limits pushSprite() to one dirty region, so each
+// region costs one setWindow and one contiguous pixel transfer.
 void refreshDisplay() {
-    display.startWrite();
-    canvas.pushSprite(sprite_offset.x, sprite_offset.y);
-    display.endWrite();
+    if (!tile_diff.ready()) {
+        tile_diff.begin(canvas.width(), canvas.height());
+    }
+    render_profile_hud();
+    {
+        RENDER_PHASE(RP_DIFF);
+        int bytes_per_pixel = (canvas.getColorDepth() & 0xff) / 8;
+        last_refresh_pixels = tile_diff.diff(
+            static_cast<const uint8_t*>(canvas.getBuffer()), canvas.width() * bytes_per_pixel, bytes_per_pixel, dirty_rects);
+        total_refresh_pixels += last_refresh_pixels;
+    }
+    {
+        RENDER_PHASE(RP_PUSH);
+        display.startWrite();
+        for (auto const& r : dirty_rects) {
+            display.setClipRect(sprite_offset.x + r.x, sprite_offset.y + r.y, r.w, r.h);
+            canvas.pushSprite(sprite_offset.x, sprite_offset.y);
+        }
+        display.clearClipRect();
+        display.endWrite();
+    }
+    frame_rendered();
 }
 
 void drawError() {
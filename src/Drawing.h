@@ -6,6 +6,7 @@
 #pragma once
 #include "FluidNCModel.h"
 #include "Text.h"
+#include "Widget.h"
 
 class Stripe {
 private:
@@ -18,11 +19,14 @@ private:
 protected:
     int _y;
 
-    int text_left_x() { return _x + _text_inset; }
-    int text_center_x() { return _x + _width / 2; }
-    int text_right_x() { return _x + _width - _text_inset; }
-    int text_middle_y() { return _y + _height / 2 + 2; }
-    int widget_left_x() { return _x; }
+    int       text_left_x() { return _x + _text_inset; }
+    int       text_center_x() { return _x + _width / 2; }
+    int       text_right_x() { return _x + _width - _text_inset; }
+    int       text_middle_y() { return _y + _height / 2 + 2; }
+    int       widget_left_x() { return _x; }
+    int       width() { return _width; }
+    int       height() { return _height; }
+    fontnum_t font() { return _font; }
 
 public:
     Stripe(int x, int y, int width, int height, fontnum_t font);
@@ -53,6 +57,37 @@ public:
     void drawHoming(int axis, bool highlight, bool homed);
 };
 
+// Retained versions of the above, which redraw only when their state changes
+
+class StripeWidget : public Widget {
+private:
+    fontnum_t _font;
+
+public:
+    StripeWidget(int x, int y, int width, int height, fontnum_t font) : Widget(x, y, width, height), _font(font) {}
+    void draw(const char* left, const char* right, bool highlighted, int left_color = WHITE);
+};
+
+class DROWidget : public Widget {
+private:
+    int _axis;
+
+public:
+    DROWidget(int x, int y, int width, int height, int axis) : Widget(x, y, width, height), _axis(axis) {}
+    void setAxis(int axis) { _axis = axis; }
+    int  axis() { return _axis; }
+    void draw(int hl_digit, bool highlight);
+};
+
+class LEDWidget : public Widget {
+private:
+    int _radius;
+
+public:
+    LEDWidget(int x, int y, int radius) : Widget(x - radius, y - radius, 2 * radius + 1, 2 * radius + 1), _radius(radius) {}
+    void draw(bool highlighted);
+};
+
 // draw stuff
 // Routines that take Point as an argument work in a coordinate
 // space where 0,0 is at the center of the display and +Y is up
@@ -61,6 +96,11 @@ LGFX_Sprite* createPngBackground(const char* filename);
 
 void drawBackground(LGFX_Sprite* sprite);
 void drawBackground(int color);
+// Repaints a rectangle with the system background and the image the
+// scene last drew with drawBackground(LGFX_Sprite*).  Scene::background()
+// calls forgetBackground() as each full redraw starts.
+void restoreBackground(int x, int y, int width, int height);
+void forgetBackground();
 void drawStatus();
 void drawStatusTiny(int y);
 void drawStatusSmall(int y);
@@ -92,6 +132,11 @@ void drawPngFile(const char* filename, Point xy);
 void drawPngBackground(const char* filename);
 
 void refreshDisplay();
+void invalidateDisplay();
+
+// Pixels sent to the panel by the most recent refreshDisplay() and in total
+extern uint32_t last_refresh_pixels;
+extern uint64_t total_refresh_pixels;
 
 void drawError();
 
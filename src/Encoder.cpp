@@ -1,8 +1,35 @@
 
 #include "Encoder.h"
+#include "EncoderStream.h"
 #include "sdkconfig.h"
 #include "driver/pcnt.h"
 #include "driver/gpio.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// The counter returns to 0 at these limits.  They are symmetric so the
+// sampler can undo the wrap with one modulus.
+static const int16_t pcnt_limit = 16384;
+
+// The sampler runs on the same core as the Arduino loop, at a higher
+// priority, so WiFi and comms work on the other core does not delay it
+static const BaseType_t  encoder_core     = 1;
+static const UBaseType_t encoder_priority = 10;
+
+static void encoder_task(void* arg) {
+    TickType_t wake   = xTaskGetTickCount();
+    TickType_t period = pdMS_TO_TICKS(ENCODER_SAMPLE_MS);
+    if (period == 0) {
+        period = 1;
+    }
+    while (true) {
+        int16_t count;
+        pcnt_get_counter_value(PCNT_UNIT_0, &count);
+        encoder_sampler.sample(count, (uint32_t)esp_timer_get_time());
+        vTaskDelayUntil(&wake, period);
+    }
+}
 
 /* clang-format: off */
 void init_encoder(int a_pin, int b_pin) {
@@ -15,8 +42,8 @@ void init_encoder(int a_pin, int b_pin) {
         .pos_mode   = PCNT_COUNT_INC,     // Count Only On Rising-Edges
         .neg_mode   = PCNT_COUNT_DEC,     // Discard Falling-Edge
 
-        .counter_h_lim = INT16_MAX,
-        .counter_l_lim = INT16_MIN,
+        .counter_h_lim = pcnt_limit,
+        .counter_l_lim = -pcnt_limit,
 
         .unit    = PCNT_UNIT_0,
         .channel = PCNT_CHANNEL_0,
@@ -40,10 +67,13 @@ void init_encoder(int a_pin, int b_pin) {
     pcnt_counter_pause(PCNT_UNIT_0);  // Initial PCNT init
     pcnt_counter_clear(PCNT_UNIT_0);
     pcnt_counter_resume(PCNT_UNIT_0);
+
+    encoder_sampler.setModulus(pcnt_limit);
+    xTaskCreatePinnedToCore(encoder_task, "encoder", 2048, nullptr, encoder_priority, nullptr, encoder_core);
 }
 
+// The unwrapped count, truncated so that differences of successive
+// values are still right
 int16_t get_encoder() {
-    int16_t count;
-    pcnt_get_counter_value(PCNT_UNIT_0, &count);
-    return count;
+    return (int16_t)encoder_sampler.position();
 }
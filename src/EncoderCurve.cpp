@@ -0,0 +1,44 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "EncoderCurve.h"
+
+void EncoderCurve::set(const encoder_curve_t& curve) {
+    _curve = curve;
+    reset();
+}
+
+int EncoderCurve::gain(int speed) const {
+    if (!enabled() || speed <= _curve.slow) {
+        return ONE;
+    }
+    if (speed >= _curve.fast) {
+        return _curve.gain * ONE;
+    }
+    return ONE + (_curve.gain - 1) * ONE * (speed - _curve.slow) / (_curve.fast - _curve.slow);
+}
+
+int EncoderCurve::apply(int detents, uint32_t now_us) {
+    if (!enabled() || detents == 0) {
+        return detents;
+    }
+    int      dir = detents > 0 ? 1 : -1;
+    uint32_t gap = now_us - _last_us;
+    int      speed = 0;
+    if (dir == _last_dir && gap < ENCODER_CURVE_IDLE_US) {
+        // Whole detents per second, so the result depends only on the
+        // event times
+        speed = (int)((uint64_t)(detents * dir) * 1000000 / (gap ? gap : 1));
+    } else {
+        // A reversal or a pause starts afresh, so a fraction left over
+        // from before cannot add to or cancel the first detent
+        _accum = 0;
+    }
+    _last_us  = now_us;
+    _last_dir = dir;
+
+    _accum += detents * gain(speed);
+    int steps = _accum / ONE;
+    _accum -= steps * ONE;
+    return steps;
+}
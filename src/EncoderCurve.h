@@ -0,0 +1,57 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Ballistic encoder scaling.  Turned slowly, each detent is one step,
+// so fine positioning is unchanged; turned fast, each detent is worth
+// up to gain steps, so long moves and long lists take a few turns
+// instead of hundreds of detents.  The gain ramps linearly between the
+// slow and fast speeds.  The speed comes from the time between detents
+// rather than the sampler's velocity estimate, since the edges within
+// one detent arrive together and would make a single click look fast.
+// Fractions of a step are carried in sixteenths so the result depends
+// only on the input.  This file has no hardware dependencies so it can
+// be tested on the host.
+
+#pragma once
+
+#include <cstdint>
+
+// A detent after a longer pause is taken as the start of a new turn
+#ifndef ENCODER_CURVE_IDLE_US
+#    define ENCODER_CURVE_IDLE_US 500000
+#endif
+
+// Speeds are in detents per second, after the scene's encoder scale
+struct encoder_curve_t {
+    int slow;  // At or below this speed the gain is 1
+    int fast;  // At or above this speed the gain is the maximum
+    int gain;  // Maximum steps per detent
+};
+
+class EncoderCurve {
+private:
+    encoder_curve_t _curve;
+    int             _accum   = 0;  // Sixteenths of a step not yet returned
+    uint32_t        _last_us = 0;  // Time of the previous detents
+    int             _last_dir = 0;  // Their direction, or 0 at the start of a turn
+
+public:
+    static const int ONE = 16;
+
+    EncoderCurve(const encoder_curve_t& curve = { 0, 0, 1 }) : _curve(curve) {}
+
+    void                   set(const encoder_curve_t& curve);
+    const encoder_curve_t& get() const { return _curve; }
+    bool                   enabled() const { return _curve.gain > 1 && _curve.fast > _curve.slow; }
+
+    // Gain in sixteenths at the given speed
+    int gain(int speed) const;
+
+    // Scales detents that arrived at now_us
+    int apply(int detents, uint32_t now_us);
+
+    void reset() {
+        _accum    = 0;
+        _last_dir = 0;
+    }
+};
@@ -0,0 +1,87 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "EncoderStream.h"
+
+EncoderSampler encoder_sampler;
+
+void EncoderSampler::sample(int32_t raw, uint32_t now_us) {
+    ++stats.samples;
+    if (!_started) {
+        _started  = true;
+        _last_raw = raw;
+        _last_us  = now_us;
+        return;
+    }
+
+    // Between samples the count moves by far less than half the
+    // modulus, so a larger jump is a wrap
+    int32_t delta = raw - _last_raw;
+    if (delta > _modulus / 2) {
+        delta -= _modulus;
+    } else if (delta < -_modulus / 2) {
+        delta += _modulus;
+    }
+    _last_raw = raw;
+
+    uint32_t gap = now_us - _last_us;
+    _last_us     = now_us;
+    if (gap > stats.max_gap_us) {
+        stats.max_gap_us = gap;
+    }
+
+    _pos += delta;
+    _position.store(_pos, std::memory_order_relaxed);
+    _lag -= delta;
+    track(gap * 1e-6f);
+
+    _carry += delta;
+    if (_carry == 0) {
+        return;
+    }
+    size_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) == ENCODER_RING_EVENTS) {
+        // Keep the counts for the next event rather than lose them
+        ++stats.merged;
+        return;
+    }
+    _ring[head & (ENCODER_RING_EVENTS - 1)] = { now_us, _carry };
+    _head.store(head + 1, std::memory_order_release);
+    _carry = 0;
+    ++stats.events;
+}
+
+// A second-order tracking loop, critically damped.  Its velocity
+// follows the count without the quantization noise of differencing,
+// and decays smoothly when the wheel stops.
+void EncoderSampler::track(float dt) {
+    if (dt <= 0) {
+        return;
+    }
+    float w = 2 * 3.14159265f * ENCODER_TRACK_HZ;
+    if (w * dt > 0.5f) {
+        w = 0.5f / dt;  // Keep the loop stable when samples are far apart
+    }
+    float err   = -_lag;
+    float accel = w * w * err;
+    _lag += (_v + 2 * w * err) * dt;
+    _v += accel * dt;
+
+    // The loop's own acceleration term is noisy; smooth it over about
+    // one loop time constant
+    float k = w * dt;
+    _a += (accel - _a) * k;
+
+    _velocity.store(_v, std::memory_order_relaxed);
+    _acceleration.store(_a, std::memory_order_relaxed);
+}
+
+bool EncoderSampler::read(encoder_event_t& event) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) {
+        return false;
+    }
+    event = _ring[tail & (ENCODER_RING_EVENTS - 1)];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Timestamped encoder input.  Reading the counter once per pass of the
+// event loop ties the sample rate to how long the last frame took and
+// loses the wheel speed.  Instead, a sampling task reads the counter at
+// a fixed rate and calls EncoderSampler::sample(), which unwraps the
+// hardware counter, pushes each change with its time into a lock-free
+// ring, and keeps velocity and acceleration estimates.  The event loop
+// drains the ring.  This file has no hardware dependencies so it can
+// be tested on the host.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Sampling period of the encoder task
+#ifndef ENCODER_SAMPLE_MS
+#    define ENCODER_SAMPLE_MS 1
+#endif
+
+// Must be a power of two.  At one event per sample this holds the
+// changes of a quarter second without a read.
+#ifndef ENCODER_RING_EVENTS
+#    define ENCODER_RING_EVENTS 256
+#endif
+
+// Bandwidth of the velocity tracking loop
+#ifndef ENCODER_TRACK_HZ
+#    define ENCODER_TRACK_HZ 10
+#endif
+
+struct encoder_event_t {
+    uint32_t us;     // When the change was seen
+    int32_t  delta;  // Counts since the previous event
+};
+
+struct encoder_stats_t {
+    uint32_t samples    = 0;
+    uint32_t events     = 0;
+    uint32_t merged     = 0;  // Events folded into a later one because the ring was full
+    uint32_t max_gap_us = 0;  // Longest time between samples
+};
+
+class EncoderSampler {
+    static_assert((ENCODER_RING_EVENTS & (ENCODER_RING_EVENTS - 1)) == 0, "ENCODER_RING_EVENTS must be a power of two");
+
+private:
+    // The hardware counter returns to 0 when it reaches +/- _modulus
+    int32_t _modulus;
+
+    encoder_event_t     _ring[ENCODER_RING_EVENTS];
+    std::atomic<size_t> _head { 0 };  // Written only by sample()
+    std::atomic<size_t> _tail { 0 };  // Written only by read()
+
+    // Producer state
+    bool     _started = false;
+    int32_t  _last_raw = 0;
+    uint32_t _last_us  = 0;
+    int32_t  _carry    = 0;  // Counts not yet in the ring
+    int32_t  _pos      = 0;
+    float    _lag      = 0;  // Tracked position less the count, kept small for float precision
+    float    _v        = 0;  // Tracked velocity and acceleration
+    float    _a        = 0;
+
+    std::atomic<int32_t> _position { 0 };
+    std::atomic<float>   _velocity { 0 };
+    std::atomic<float>   _acceleration { 0 };
+
+    void track(float dt);
+
+public:
+    encoder_stats_t stats;
+
+    // modulus is where the counter wraps: the PCNT limit, or 65536 for
+    // a free-running 16-bit count
+    EncoderSampler(int32_t modulus = 65536) : _modulus(modulus) {}
+    void setModulus(int32_t modulus) { _modulus = modulus; }
+
+    // Producer side, called at a fixed rate with the raw counter value
+    void sample(int32_t raw, uint32_t now_us);
+
+    // Consumer side.  Returns false when the ring is empty.
+    bool read(encoder_event_t& event);
+
+    // Unwrapped count, and estimates in counts per second and per
+    // second squared.  Any task can read these.
+    int32_t position() const { return _position.load(std::memory_order_relaxed); }
+    float   velocity() const { return _velocity.load(std::memory_order_relaxed); }
+    float   acceleration() const { return _acceleration.load(std::memory_order_relaxed); }
+};
+
+extern EncoderSampler encoder_sampler;
+
+// Time of the last event taken from the ring by dispatch_events()
+extern uint32_t encoder_event_us;
@@ -3,16 +3,19 @@
 
 #include "FileParser.h"
 
-#include "Scene.h"  // current_scene->reDisplay()
+#include "Scene.h"  // schedule_redisplay()
 #include "Menu.h"
 #include "GrblParserC.h"  // send_line()
 #include "HomingScene.h"  // set_axis_homed()
+#include "FluidNCModel.h"  // resync_lines()
 
 #include <JsonStreamingParser.h>
 #include <JsonListener.h>
 
 #include "MacroItem.h"
 
+#include <algorithm>
+
 extern Menu macroMenu;
 
 fileinfo              fileInfo;
@@ -426,7 +429,7 @@ public:
 } fileLinesListener;
 
 bool is_file(const char* str, const char* filename) {
-    char* s = strstr(str, filename);
+    const char* s = strstr(str, filename);
     return s && strlen(s) == strlen(filename);
 }
 
@@ -625,7 +628,7 @@ void handle_radio_mode(char* command, char* arguments) {
     wifi_mode = value;
     if (strcmp(value, "No Wifi") != 0) {
         parse_wifi(arguments);
-        current_scene->reDisplay();
+        schedule_redisplay();
     }
 }
 
@@ -634,7 +637,7 @@ extern "C" void handle_msg(char* command, char* arguments) {
         char c;
         while ((c = *arguments++) != '\0') {
             const char* letters = "XYZABCUVW";
-            char*       pos     = strchr(letters, c);
+            const char* pos     = strchr(letters, c);
             if (pos) {
                 set_axis_homed(pos - letters);
             }
@@ -642,6 +645,7 @@ extern "C" void handle_msg(char* command, char* arguments) {
     }
     if (strcmp(command, "RST") == 0) {
         dbg_println("FluidNC Reset");
+        resync_lines();  // The reset discarded any lines it had not answered
         state = Disconnected;
         act_on_state_change();
     }
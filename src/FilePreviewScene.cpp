@@ -71,7 +71,7 @@ public:
         }
     }
 
-    void onDROChange() { reDisplay(); }
+    void onDROChange() { schedule_redisplay(); }
 
     void onGreenButtonPress() {
         if (state == Idle) {
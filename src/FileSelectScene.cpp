@@ -33,15 +33,19 @@ private:
             int residue = size % 1000;
             snprintf(buffer, buflen, "%d.%03d KB", kb, residue);
         } else {
-            snprintf(buffer, buflen, "%d bytes", size);
+            snprintf(buffer, buflen, "%d bytes", (int)size);
         }
         return buffer;
     }
 
 public:
-    FileSelectScene() : Scene("Files", 4) {}
+    FileSelectScene() : Scene("Files", 4) {
+        // Up to 25 entries per detent for long file lists
+        setEncoderCurve({ 5, 20, 25 });
+    }
 
     void onEntry(void* arg) {
+        initPrefs();
         // a first time only thing, because files are already loaded
         if (prevSelect.size() == 0) {
             prevSelect.push_back(0);
@@ -310,7 +314,13 @@ public:
             }
         }
 #else
-        if (nextSelect < 0 || nextSelect > (int)(fileVector.size() - 1)) {
+        // A fast turn stops at the ends of the list
+        if (nextSelect < 0) {
+            nextSelect = 0;
+        } else if (nextSelect > (int)(fileVector.size() - 1)) {
+            nextSelect = (int)fileVector.size() - 1;
+        }
+        if (nextSelect == _selected_file || fileVector.empty()) {
             return;
         }
 #endif
@@ -5,10 +5,13 @@
 #include "ConfigItem.h"
 #include "FileParser.h"  // init_file_list()
 #include <map>
+#include <vector>
+#include <cstdarg>
 #include "System.h"
 #include "Scene.h"
 #include "e4math.h"
 #include "HomingScene.h"
+#include "LineCounter.h"
 #include "transport/transport.h"
 
 extern Scene statusScene;
@@ -40,6 +43,14 @@ int num_digits() {
     return inInches ? 3 : 2;
 }
 
+bool axisIsRotary(int axis) {
+    return axis >= 3;
+}
+
+int num_digits(int axis) {
+    return axisIsRotary(axis) ? 2 : num_digits();
+}
+
 // clang-format off
 // Maps the state strings in status reports to internal state enum values
 struct cmp_str {
@@ -78,7 +89,8 @@ bool decode_state_string(const char* state_string, state_t& state) {
 void set_disconnected_state() {
     state           = Disconnected;
     my_state_string = "N/C";
-    current_scene->reDisplay(); // Trigger redisplay to update connection status indicator
+    invalidate_status_snapshot();
+    schedule_redisplay();  // Update connection status indicator
 }
 
 // clang-format off
@@ -145,7 +157,7 @@ extern "C" void show_dro(const pos_t* axes, const pos_t* wco, bool isMpos, bool*
         if (isMpos) {
             axis_val -= wco[axis];
         }
-        myAxes[axis] = inInches ? e4_mm_to_inch(axis_val) : axis_val;
+        myAxes[axis] = inInches && !axisIsRotary(axis) ? e4_mm_to_inch(axis_val) : axis_val;
     }
 }
 #else
@@ -158,6 +170,10 @@ pos_t toMm(pos_t position) {
 
 extern "C" void show_dro(const pos_t* axes, const pos_t* wco, bool isMpos, bool* limits, size_t n_axis) {
     for (int axis = 0; axis < n_axis; axis++) {
+        if (axisIsRotary(axis)) {
+            myAxes[axis] = isMpos ? axes[axis] - wco[axis] : axes[axis];
+            continue;
+        }
         myAxes[axis] = fromMm(axes[axis]);
         if (isMpos) {
             myAxes[axis] -= fromMm(wco[axis]);
@@ -166,6 +182,28 @@ extern "C" void show_dro(const pos_t* axes, const pos_t* wco, bool isMpos, bool*
 }
 #endif
 
+static LineCounter line_counter;
+
+// Takes in the lines the transport has written since the last call
+static void count_lines() {
+    line_counter.update(transport, transport ? transport->linesSent() : 0, milliseconds());
+}
+
+uint32_t lines_sent() {
+    count_lines();
+    return line_counter.sent();
+}
+
+uint32_t line_replies() {
+    count_lines();
+    return line_counter.replies();
+}
+
+void resync_lines() {
+    count_lines();
+    line_counter.resync();
+}
+
 void send_line(const char* s, int timeout) {
     if (transport) {
         transport->sendLine(s, timeout);
@@ -175,10 +213,19 @@ void send_line(const char* s, int timeout) {
     }
     dbg_println(s);
 }
+// Formatted lines are built in place in a buffer that is reused for
+// every call and only grows if a line does not fit.
 static void vsend_linef(const char* fmt, va_list va) {
-    static char buf[128];
-    vsnprintf(buf, 128, fmt, va);
-    send_line(buf);
+    static std::vector<char> buf(128);
+    va_list                  retry;
+    va_copy(retry, va);
+    int len = vsnprintf(buf.data(), buf.size(), fmt, va);
+    if (len >= (int)buf.size()) {
+        buf.resize(len + 1);
+        vsnprintf(buf.data(), buf.size(), fmt, retry);
+    }
+    va_end(retry);
+    send_line(buf.data());
 }
 void send_linef(const char* fmt, ...) {
     va_list args;
@@ -215,6 +262,8 @@ extern "C" void show_state(const char* state_string) {
     state_t new_state;
     if (decode_state_string(state_string, new_state) && state != new_state) {
         if (state == Disconnected) {
+            // Nothing sent before the connection came back will be answered
+            resync_lines();
             if (transport) {
                 transport->sendRT((realtime_cmd_t)0x0c);  // Ctrl-L - echo off
             }
@@ -251,23 +300,106 @@ extern "C" void handle_other(char* line) {
 }
 
 extern "C" void show_error(int error) {
+    count_lines();
+    line_counter.reply();
     errorExpire = milliseconds() + 1000;
     lastError   = error;
-    current_scene->reDisplay();
+    schedule_redisplay();
 }
 
 extern "C" void show_timeout() {
     dbg_println("Timeout");
 }
-extern "C" void show_ok() {}
+extern "C" void show_ok() {
+    count_lines();
+    line_counter.reply();
+}
+
+// The values from the previous status report.  FluidNC keeps reporting
+// at the $RI interval while idle, so most reports repeat the previous
+// one and there is nothing to redraw.
+struct status_snapshot_t {
+    const char*        state_string;
+    int                n_axes;
+    pos_t              axes[6];
+    bool               limits[6];
+    bool               probe;
+    file_percent_t     percent;
+    override_percent_t fro;
+    override_percent_t sro;
+    uint32_t           feed;
+    uint32_t           speed;
+    char               ctrl_pins[16];
+};
+static status_snapshot_t last_status   = {};
+static bool              have_snapshot = false;
+
+uint32_t status_changed            = 0;
+uint32_t status_reports            = 0;
+uint32_t status_reports_suppressed = 0;
+
+static uint32_t diff_status() {
+    status_snapshot_t& last    = last_status;
+    uint32_t           changed = have_snapshot ? 0 : STATUS_ALL;
+
+    if (last.state_string != my_state_string) {
+        changed |= STATUS_STATE;
+    }
+    if (last.n_axes != n_axes || memcmp(last.axes, myAxes, sizeof(myAxes)) != 0) {
+        changed |= STATUS_DRO;
+    }
+    if (memcmp(last.limits, myLimitSwitches, sizeof(myLimitSwitches)) != 0 || last.probe != myProbeSwitch) {
+        changed |= STATUS_LIMITS;
+    }
+    if (last.percent != myPercent) {
+        changed |= STATUS_FILE;
+    }
+    if (last.fro != myFro || last.sro != mySro) {
+        changed |= STATUS_OVERRIDES;
+    }
+    if (last.feed != myFeed || last.speed != mySpeed) {
+        changed |= STATUS_FEED_SPINDLE;
+    }
+    if (strncmp(last.ctrl_pins, myCtrlPins, sizeof(last.ctrl_pins) - 1) != 0) {
+        changed |= STATUS_CTRL_PINS;
+    }
+
+    if (changed) {
+        last.state_string = my_state_string;
+        last.n_axes       = n_axes;
+        memcpy(last.axes, myAxes, sizeof(myAxes));
+        memcpy(last.limits, myLimitSwitches, sizeof(myLimitSwitches));
+        last.probe   = myProbeSwitch;
+        last.percent = myPercent;
+        last.fro     = myFro;
+        last.sro     = mySro;
+        last.feed    = myFeed;
+        last.speed   = mySpeed;
+        strncpy(last.ctrl_pins, myCtrlPins, sizeof(last.ctrl_pins) - 1);
+        have_snapshot = true;
+    }
+    return changed;
+}
+
+// Call this when something other than a status report, such as a
+// units change, alters how the reported values are displayed.
+void invalidate_status_snapshot() {
+    have_snapshot = false;
+}
 
 extern "C" void end_status_report() {
-    current_scene->onDROChange();
+    ++status_reports;
+    status_changed = diff_status();
+    if (status_changed) {
+        current_scene->onDROChange();
+    } else {
+        ++status_reports_suppressed;
+    }
 }
 
 extern "C" void show_alarm(int alarm) {
     lastAlarm = alarm;
-    current_scene->reDisplay();
+    schedule_redisplay();
 }
 
 extern "C" void show_gcode_modes(struct gcode_modes* modes) {
@@ -288,7 +420,8 @@ extern "C" void show_gcode_modes(struct gcode_modes* modes) {
     }
 
     mySelectedTool = modes->tool;
-    current_scene->reDisplay();
+    invalidate_status_snapshot();
+    schedule_redisplay();
 }
 
 int disconnect_ms = 0;
@@ -344,8 +477,6 @@ void update_rx_time() {
 
 #ifdef USE_WIFI_PENDANT
 void trigger_status_redraw() {
-    if (current_scene) {
-        current_scene->reDisplay();
-    }
+    schedule_redisplay();
 }
 #endif
@@ -46,6 +46,38 @@ extern uint32_t           mySelectedTool;
 
 int num_digits();
 
+// A, B and C are rotary axes, in degrees whatever the units mode
+bool axisIsRotary(int axis);
+int  num_digits(int axis);
+
+// Which parts of the model the most recent status report changed.
+// Repeated identical reports do not call the scene's onDROChange().
+enum status_field_t : uint32_t {
+    STATUS_STATE        = 1 << 0,
+    STATUS_DRO          = 1 << 1,
+    STATUS_LIMITS       = 1 << 2,  // Includes the probe switch
+    STATUS_FILE         = 1 << 3,
+    STATUS_OVERRIDES    = 1 << 4,
+    STATUS_FEED_SPINDLE = 1 << 5,
+    STATUS_CTRL_PINS    = 1 << 6,
+    STATUS_ALL          = (1 << 7) - 1,
+};
+extern uint32_t status_changed;
+extern uint32_t status_reports;
+extern uint32_t status_reports_suppressed;
+
+// Lines sent to FluidNC that it will reply to, and the replies (ok or
+// error) to them, for matching replies to lines in order.  The nth
+// reply answers the nth line.  Lines whose replies were lost, such as
+// when FluidNC resets, are counted as answered.
+uint32_t lines_sent();
+uint32_t line_replies();
+
+// Gives up on the replies to the lines sent so far
+void resync_lines();
+
+void invalidate_status_snapshot();
+
 void send_line(const char* s, int timeout = 2000);
 void send_linef(const char* fmt, ...);
 
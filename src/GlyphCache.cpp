@@ -0,0 +1,154 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "GlyphCache.h"
+#include <cstring>
+
+extern const GFXfont* font[];
+
+GlyphCache glyph_cache;
+
+static int glyph_index(char c) {
+    const char* p = c ? strchr(GLYPH_CACHE_CHARS, c) : nullptr;
+    return p ? p - GLYPH_CACHE_CHARS : -1;
+}
+
+GlyphCache::glyph_set_t* GlyphCache::find(fontnum_t fontnum, int color, int datum) {
+    for (auto& set : _sets) {
+        if (set.font == fontnum && set.color == color && set.datum == datum) {
+            return &set;
+        }
+    }
+    if (_sets.size() >= GLYPH_CACHE_SETS) {
+        auto lru = _sets.begin();
+        for (auto it = _sets.begin(); it != _sets.end(); ++it) {
+            if (it->last_used < lru->last_used) {
+                lru = it;
+            }
+        }
+        release(*lru);
+        _sets.erase(lru);
+    }
+    glyph_set_t set;
+    set.font        = fontnum;
+    set.color       = color;
+    set.datum       = datum;
+    set.transparent = color == BLACK ? WHITE : BLACK;
+    set.last_used   = 0;
+    memset(set.glyphs, 0, sizeof(set.glyphs));
+    _sets.push_back(set);
+    return &_sets.back();
+}
+
+// Draws the glyph with the requested datum in the middle of a scratch
+// sprite big enough for any datum, then keeps only the inked rectangle.
+bool GlyphCache::render(glyph_set_t& set, char c, glyph_t& glyph) {
+    char str[2] = { c, '\0' };
+    int  pad    = 4;
+    int  width  = 2 * canvas.textWidth(str, font[set.font]) + 2 * pad;
+    int  height = 2 * canvas.fontHeight(font[set.font]) + 2 * pad;
+
+    LGFX_Sprite scratch(&canvas);
+    scratch.setColorDepth(canvas.getColorDepth());
+    if (!scratch.createSprite(width, height)) {
+        return false;
+    }
+    scratch.fillSprite(set.transparent);
+    scratch.setFont(font[set.font]);
+    scratch.setTextDatum(set.datum);
+    scratch.setTextColor(set.color);
+    int ax = width / 2;
+    int ay = height / 2;
+    scratch.drawString(str, ax, ay);
+
+    uint32_t key  = scratch.readPixel(0, 0);
+    int      left = width, right = -1, top = height, bottom = -1;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (scratch.readPixel(x, y) != key) {
+                left   = x < left ? x : left;
+                right  = x > right ? x : right;
+                top    = y < top ? y : top;
+                bottom = y > bottom ? y : bottom;
+            }
+        }
+    }
+
+    glyph.rendered = true;
+    glyph.advance  = canvas.textWidth(str, font[set.font]);
+    glyph.sprite   = nullptr;
+    if (right < 0) {
+        return true;
+    }
+    auto sprite = new LGFX_Sprite(&canvas);
+    sprite->setColorDepth(canvas.getColorDepth());
+    if (!sprite->createSprite(right - left + 1, bottom - top + 1)) {
+        delete sprite;
+        glyph.rendered = false;
+        return false;
+    }
+    scratch.pushSprite(sprite, -left, -top);
+    glyph.sprite = sprite;
+    glyph.dx     = left - ax;
+    glyph.dy     = top - ay;
+    ++renders;
+    return true;
+}
+
+void GlyphCache::release(glyph_set_t& set) {
+    for (auto& glyph : set.glyphs) {
+        if (glyph.sprite) {
+            glyph.sprite->deleteSprite();
+            delete glyph.sprite;
+        }
+    }
+}
+
+bool GlyphCache::draw(char c, int x, int y, int color, fontnum_t fontnum, int datum) {
+    int index = glyph_index(c);
+    if (index < 0) {
+        return false;
+    }
+    glyph_set_t* set   = find(fontnum, color, datum);
+    glyph_t&     glyph = set->glyphs[index];
+    set->last_used     = ++_tick;
+    if (glyph.rendered) {
+        ++hits;
+    } else if (!render(*set, c, glyph)) {
+        return false;
+    }
+    if (glyph.sprite) {
+        glyph.sprite->pushSprite(&canvas, x + glyph.dx, y + glyph.dy, set->transparent);
+    }
+    return true;
+}
+
+int GlyphCache::advance(char c, fontnum_t fontnum) {
+    int index = glyph_index(c);
+    if (index >= 0) {
+        for (auto& set : _sets) {
+            if (set.font == fontnum && set.glyphs[index].rendered) {
+                return set.glyphs[index].advance;
+            }
+        }
+    }
+    char str[2] = { c, '\0' };
+    return canvas.textWidth(str, font[fontnum]);
+}
+
+void GlyphCache::clear() {
+    for (auto& set : _sets) {
+        release(set);
+    }
+    _sets.clear();
+}
+
+void number_text(const char* msg, int x, int y, int color, fontnum_t fontnum) {
+    for (const char* p = msg + strlen(msg); p-- > msg;) {
+        if (!glyph_cache.draw(*p, x, y, color, fontnum, middle_right)) {
+            char str[2] = { *p, '\0' };
+            text(str, x, y, color, fontnum, middle_right);
+        }
+        x -= glyph_cache.advance(*p, fontnum);
+    }
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Pre-rendered glyphs for the characters that appear in DRO numbers.
+// Drawing a digit with text() sets up the font and walks the GFX glyph
+// bitmap on every call; the DROs redraw every axis on every status
+// report, so instead each glyph is rasterized once per font, color and
+// datum into a small sprite cropped to its ink, and then blitted with
+// the background color as the transparent key.
+//
+// The GFX fonts are not antialiased, so a keyed blit produces exactly
+// the same pixels as drawString().
+
+#pragma once
+
+#include "Text.h"
+#include <vector>
+
+// Characters that are cached; anything else falls back to text()
+#define GLYPH_CACHE_CHARS "0123456789.-"
+
+// Number of font/color/datum combinations kept.  The DRO scenes use
+// about four colors; the oldest set is dropped when a new one is needed.
+#ifndef GLYPH_CACHE_SETS
+#    define GLYPH_CACHE_SETS 8
+#endif
+
+class GlyphCache {
+private:
+    struct glyph_t {
+        LGFX_Sprite* sprite;  // nullptr if the glyph has no ink, like ' '
+        int          dx;      // Offset from the datum point to the sprite corner
+        int          dy;
+        int          advance;
+        bool         rendered;
+    };
+    struct glyph_set_t {
+        fontnum_t font;
+        int       color;
+        int       datum;
+        int       transparent;
+        uint32_t  last_used;
+        glyph_t   glyphs[sizeof(GLYPH_CACHE_CHARS) - 1];
+    };
+
+    std::vector<glyph_set_t> _sets;
+    uint32_t                 _tick = 0;
+
+    glyph_set_t* find(fontnum_t font, int color, int datum);
+    bool         render(glyph_set_t& set, char c, glyph_t& glyph);
+    void         release(glyph_set_t& set);
+
+public:
+    uint32_t hits    = 0;
+    uint32_t renders = 0;
+
+    // Draws c like text() would; returns false if c is not cacheable.
+    bool draw(char c, int x, int y, int color, fontnum_t font, int datum);
+
+    // Horizontal advance of c in the given font, as used by textWidth()
+    int advance(char c, fontnum_t font);
+
+    void clear();
+};
+
+extern GlyphCache glyph_cache;
+
+// Like text() with datum middle_right, but draws each character from
+// the glyph cache.  Used for numbers in the DROs.
+void number_text(const char* msg, int x, int y, int color, fontnum_t fontnum);
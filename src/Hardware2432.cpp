@@ -15,6 +15,7 @@
 #include "Hardware2432.hpp"
 #include "Drawing.h"
 #include "NVS.h"
+#include "Assets.h"
 
 #include <driver/uart.h>
 #include "hal/uart_hal.h"
@@ -294,6 +295,7 @@ void  set_layout(int n) {
      layout = &layouts[n];
      display.setRotation(layout->rotation());
      sprite_offset = layout->spritePosition;
+     invalidateDisplay();
 }
 
 nvs_handle_t hw_nvs;
@@ -479,8 +481,10 @@ void redrawButtons() {
 
 void show_logo() {
     display.clear();
-    display.drawPngFile(
-        LittleFS, "/fluid_dial.png", sprite_offset.x, sprite_offset.y, sprite_wh, sprite_wh, 0, 0, 0.0f, 0.0f, datum_t::middle_center);
+    if (!drawPanelAsset(&display, "fluid_dial.png", sprite_offset.x + sprite_wh / 2, sprite_offset.y + sprite_wh / 2)) {
+        display.drawPngFile(
+            LittleFS, "/fluid_dial.png", sprite_offset.x, sprite_offset.y, sprite_wh, sprite_wh, 0, 0, 0.0f, 0.0f, datum_t::middle_center);
+    }
 }
 
 void base_display() {
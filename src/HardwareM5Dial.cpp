@@ -7,6 +7,7 @@
 #include "M5GFX.h"
 #include "Drawing.h"
 #include "HardwareM5Dial.hpp"
+#include "Assets.h"
 #ifdef USE_WIFI_PENDANT
 #include "net/net_config.h"
 #endif
@@ -61,11 +62,15 @@ void init_hardware() {
 Point sprite_offset { 0, 0 };
 
 void show_logo() {
-    display.drawPngFile(LittleFS, "/fluid_dial.png", 0, 0, display.width(), display.height(), 0, 0, 0.0f, 0.0f, datum_t::middle_center);
+    if (!drawPanelAsset(&display, "fluid_dial.png", display.width() / 2, display.height() / 2)) {
+        display.drawPngFile(
+            LittleFS, "/fluid_dial.png", 0, 0, display.width(), display.height(), 0, 0, 0.0f, 0.0f, datum_t::middle_center);
+    }
 }
 
 void base_display() {
     display.clear();
+    invalidateDisplay();
 }
 
 void next_layout(int delta) {}
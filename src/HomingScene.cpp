@@ -25,7 +25,7 @@ bool is_homed(int axis) {
 }
 void set_axis_homed(int axis) {
     homed_axes |= 1 << axis;
-    current_scene->reDisplay();
+    schedule_redisplay();
 }
 
 void detect_homing_info() {
@@ -111,7 +111,7 @@ public:
         increment_axis_to_home();
         reDisplay();
     }
-    void onDROChange() { reDisplay(); }  // also covers any status change
+    void onDROChange() { schedule_redisplay(); }  // also covers any status change
 
     void reDisplay() {
         background();
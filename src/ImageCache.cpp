@@ -0,0 +1,224 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "ImageCache.h"
+#include "Assets.h"
+#include "RenderProfile.h"
+#include <cstdlib>
+
+ImageCache image_cache;
+
+// Callers use both "foo.png" and "/foo.png" for the same file
+static const char* base_name(const char* filename) {
+    while (*filename == '/') {
+        ++filename;
+    }
+    return filename;
+}
+
+ImageCache::image_t* ImageCache::find(const char* name) {
+    for (auto& image : _images) {
+        if (image.name == name) {
+            return &image;
+        }
+    }
+    return nullptr;
+}
+
+void ImageCache::release(image_t& image) {
+    if (image.opaque) {
+        image.opaque->deleteSprite();
+        delete image.opaque;
+    }
+    free(image.pixels);
+    free(image.rle);
+    _used -= image.bytes;
+}
+
+static size_t default_budget() {
+#ifdef ARDUINO
+    if (ESP.getPsramSize() == 0) {
+        return IMAGE_CACHE_BYTES_NO_PSRAM;
+    }
+#endif
+    return IMAGE_CACHE_BYTES;
+}
+
+bool ImageCache::make_room(size_t bytes) {
+    if (_budget == 0) {
+        _budget = default_budget();
+        dbg_printf("ImageCache: %u byte budget\n", (unsigned)_budget);
+    }
+    if (bytes > _budget) {
+        return false;
+    }
+    while (_used + bytes > _budget && !_images.empty()) {
+        auto lru = _images.begin();
+        for (auto it = _images.begin(); it != _images.end(); ++it) {
+            if (it->last_used < lru->last_used) {
+                lru = it;
+            }
+        }
+        release(*lru);
+        _images.erase(lru);
+        ++evictions;
+    }
+    return true;
+}
+
+ImageCache::image_t* ImageCache::load(const char* name) {
+    image_t image = { name, 0, 0, nullptr, nullptr, nullptr, 0, 0 };
+
+    size_t       length;
+    AssetReader* asset = openAsset(name, length);
+    if (asset) {
+        uint8_t* rle = nullptr;
+        if (make_room(length) && (rle = static_cast<uint8_t*>(malloc(length))) != nullptr) {
+            if (asset->read(rle, length) != length) {
+                free(rle);
+                rle = nullptr;
+            }
+        }
+        delete asset;
+        if (!rle) {
+            return nullptr;
+        }
+        image.rle   = rle;
+        image.bytes = length;
+        _used += image.bytes;
+        _images.push_back(image);
+        return &_images.back();
+    }
+
+    int width, height;
+    if (!pngFileSize(name, width, height)) {
+        return nullptr;
+    }
+    image.width  = width;
+    image.height = height;
+
+    if (width >= canvas.width() && height >= canvas.height()) {
+        size_t bytes = width * height * ((canvas.getColorDepth() & 0xff) / 8);
+        if (!make_room(bytes)) {
+            return nullptr;
+        }
+        auto sprite = new LGFX_Sprite(&canvas);
+        sprite->setColorDepth(canvas.getColorDepth());
+        if (!sprite->createSprite(width, height)) {
+            delete sprite;
+            return nullptr;
+        }
+        sprite->fillSprite(TFT_BLACK);
+        decodePngFile(sprite, name, 0, 0);
+        image.opaque = sprite;
+        image.bytes  = bytes;
+    } else {
+        size_t n_pixels = width * height;
+        size_t bytes    = n_pixels * sizeof(lgfx::argb8888_t);
+        if (!make_room(bytes)) {
+            return nullptr;
+        }
+        LGFX_Sprite scratch(&canvas);
+        scratch.setColorDepth(24);
+        auto pixels = static_cast<lgfx::argb8888_t*>(malloc(bytes));
+        auto white  = static_cast<lgfx::rgb888_t*>(malloc(n_pixels * sizeof(lgfx::rgb888_t)));
+        if (!pixels || !white || !scratch.createSprite(width, height)) {
+            free(pixels);
+            free(white);
+            return nullptr;
+        }
+
+        scratch.fillSprite(TFT_WHITE);
+        decodePngFile(&scratch, name, 0, 0);
+        scratch.readRectRGB(0, 0, width, height, white);
+
+        // The black decode goes into the low three bytes of the output
+        // buffer, then is expanded in place from the end backwards.
+        auto black = reinterpret_cast<lgfx::rgb888_t*>(pixels);
+        scratch.fillSprite(TFT_BLACK);
+        decodePngFile(&scratch, name, 0, 0);
+        scratch.readRectRGB(0, 0, width, height, black);
+        scratch.deleteSprite();
+
+        // Over black a pixel is c*a; over white it is c*a + (1-a), so the
+        // difference gives the alpha and dividing by it gives the color.
+        for (size_t i = n_pixels; i-- > 0;) {
+            lgfx::rgb888_t b = black[i];
+            lgfx::rgb888_t w = white[i];
+            int            a = 255 - (w.g - b.g);
+            a                = a < 0 ? 0 : (a > 255 ? 255 : a);
+            auto& p          = pixels[i];
+            p.a              = a;
+            p.r              = a ? (b.r * 255 + a / 2) / a : 0;
+            p.g              = a ? (b.g * 255 + a / 2) / a : 0;
+            p.b              = a ? (b.b * 255 + a / 2) / a : 0;
+        }
+        free(white);
+
+        image.pixels = pixels;
+        image.bytes  = bytes;
+    }
+
+    _used += image.bytes;
+    _images.push_back(image);
+    return &_images.back();
+}
+
+bool ImageCache::draw(LGFX_Sprite* sprite, const char* filename, int x, int y) {
+    const char* name  = base_name(filename);
+    image_t*    image = find(name);
+    if (image) {
+        ++hits;
+    } else {
+        ++misses;
+        uint32_t start = microseconds();
+        image          = load(name);
+        uint32_t us    = microseconds() - start;
+        decode_us += us;
+        if (!image) {
+            return false;
+        }
+        dbg_printf("ImageCache: %s decoded in %u us, %u bytes used\n", name, us, (unsigned)_used);
+    }
+    image->last_used = ++_tick;
+
+    if (image->rle) {
+        MemoryAssetReader blob(image->rle, image->bytes);
+        return drawAsset(blob, sprite, x, y);
+    }
+
+    int left = sprite->width() / 2 + x - image->width / 2;
+    int top  = sprite->height() / 2 - y - image->height / 2;
+    if (image->opaque) {
+        image->opaque->pushSprite(sprite, left, top);
+    } else {
+        sprite->pushAlphaImage(left, top, image->width, image->height, image->pixels);
+    }
+    return true;
+}
+
+void ImageCache::clear() {
+    for (auto& image : _images) {
+        release(image);
+    }
+    _images.clear();
+}
+
+void drawPngFile(const char* filename, int x, int y) {
+    drawPngFile(&canvas, filename, x, y);
+}
+void drawPngFile(LGFX_Sprite* sprite, const char* filename, int x, int y) {
+    RENDER_PHASE(RP_IMAGE);
+    if (image_cache.draw(sprite, filename, x, y)) {
+        return;
+    }
+    // Too big for the cache, so stream the converted blob if there is one
+    const char*  name = base_name(filename);
+    size_t       length;
+    AssetReader* asset = openAsset(name, length);
+    bool         drawn = asset && drawAsset(*asset, sprite, x, y);
+    delete asset;
+    if (!drawn) {
+        decodePngFile(sprite, name, x, y);
+    }
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Cache of decoded PNG images, keyed by filename.  drawPngFile() goes
+// through this cache so menu icons and backgrounds are inflated once
+// and then blitted from RAM on every redraw.
+//
+// When build_assets.py has converted an image, the cache holds its
+// run-length encoded blob, which is much smaller than the decoded
+// pixels and is drawn by a streaming copy.  Otherwise the PNG is
+// decoded and kept as pixels.
+//
+// Images that fill the whole canvas are only used as backgrounds over
+// a cleared canvas, so they are decoded over black and kept at the
+// canvas color depth.  Smaller images such as menu icons are kept as
+// ARGB8888 with the alpha channel recovered from two decodes (over
+// black and over white) so they still blend with what is under them.
+
+#pragma once
+
+#include "System.h"
+#include <string>
+#include <vector>
+
+// RAM budget for decoded images.  The least recently used image is
+// evicted when a new one does not fit.
+#ifndef IMAGE_CACHE_BYTES
+#    define IMAGE_CACHE_BYTES (128 * 1024)
+#endif
+
+// Budget on boards without PSRAM, such as the CYD, where the canvas
+// sprite and the WiFi stack already take most of the heap.  RLE blobs
+// still fit; full-screen decoded backgrounds are drawn uncached.
+#ifndef IMAGE_CACHE_BYTES_NO_PSRAM
+#    define IMAGE_CACHE_BYTES_NO_PSRAM (32 * 1024)
+#endif
+
+class ImageCache {
+private:
+    struct image_t {
+        std::string       name;
+        int               width;
+        int               height;
+        LGFX_Sprite*      opaque;  // Canvas-depth copy of a background image
+        lgfx::argb8888_t* pixels;  // Straight-alpha copy of a translucent image
+        uint8_t*          rle;     // Pre-converted blob from build_assets.py
+        size_t            bytes;
+        uint32_t          last_used;
+    };
+
+    std::vector<image_t> _images;
+    size_t               _budget;
+    size_t               _used = 0;
+    uint32_t             _tick = 0;
+
+    image_t* find(const char* name);
+    image_t* load(const char* name);
+    bool     make_room(size_t bytes);
+    void     release(image_t& image);
+
+public:
+    uint32_t hits      = 0;
+    uint32_t misses    = 0;
+    uint32_t evictions = 0;
+    uint32_t decode_us = 0;  // Total time spent decoding on misses
+
+    // A budget of 0 is chosen at first use, once PSRAM has been found
+    ImageCache(size_t budget = 0) : _budget(budget) {}
+
+    // Draws the image centered at x,y relative to the sprite center, +Y up,
+    // like LovyanGFX drawPngFile() with datum middle_center.
+    // Returns false if the image could not be cached.
+    bool draw(LGFX_Sprite* sprite, const char* filename, int x, int y);
+
+    size_t used() { return _used; }
+    void   clear();
+};
+
+extern ImageCache image_cache;
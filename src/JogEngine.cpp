@@ -0,0 +1,133 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "JogEngine.h"
+#include <cmath>
+#include <cstdlib>
+
+void JogEngine::setAxes(const int32_t* step, int n_axes) {
+    if (n_axes > JOG_MAX_AXES) {
+        n_axes = JOG_MAX_AXES;
+    }
+    _n_axes     = n_axes;
+    double sum2 = 0;
+    for (int axis = 0; axis < JOG_MAX_AXES; ++axis) {
+        _step[axis] = axis < n_axes ? step[axis] : 0;
+        sum2 += (double)_step[axis] * _step[axis];
+    }
+    _count_len = (uint32_t)std::lround(std::sqrt(sum2));
+}
+
+uint32_t JogEngine::in_flight_ms(uint32_t now_ms) const {
+    if (_state != MOVING) {
+        return 0;
+    }
+    int32_t left = _busy_until - now_ms;
+    return left > 0 ? left : 0;
+}
+
+void JogEngine::encoder(int counts, uint32_t now_ms) {
+    if (counts == 0) {
+        return;
+    }
+    stats.counts += std::abs(counts);
+    if (_pending == 0) {
+        _window_start = now_ms;
+    }
+    _pending += counts;
+
+    // Turning back while the machine is still moving: stop it rather
+    // than queue the reverse move behind the rest of the forward one
+    if (_pending && in_flight_ms(now_ms) && (_pending > 0 ? 1 : -1) != _direction) {
+        _sink->cancel();
+        ++stats.cancels;
+        _state         = CANCELLING;
+        _cancel_at     = now_ms;
+        _cancel_report = _last_report;
+    }
+}
+
+void JogEngine::poll(uint32_t now_ms, bool jogging, uint32_t report) {
+    _last_report = report;
+    if (_state == CANCELLING) {
+        // Lines sent before the stop is confirmed could be flushed
+        // with the cancelled jog
+        bool confirmed = report != _cancel_report && !jogging;
+        if (!confirmed && (now_ms - _cancel_at) < JOG_CANCEL_TIMEOUT_MS) {
+            return;
+        }
+        _state     = IDLE;
+        _direction = 0;
+        if (_pending) {
+            _window_start = now_ms;
+        }
+        return;
+    }
+    if (_pending && (now_ms - _window_start) >= JOG_WINDOW_MS) {
+        flush(now_ms);
+    }
+    if (_state == MOVING && !in_flight_ms(now_ms)) {
+        _state = IDLE;
+    }
+}
+
+void JogEngine::flush(uint32_t now_ms) {
+    int      direction = _pending > 0 ? 1 : -1;
+    uint32_t counts    = std::abs(_pending);
+    _pending           = 0;
+    if (_count_len == 0) {
+        stats.dropped += counts;  // No axis selected
+        return;
+    }
+
+    // A segment at the wheel's speed lasts about one window, so the
+    // planner queue stays short while the wheel turns steadily
+    uint32_t elapsed  = now_ms - _window_start;
+    uint64_t distance = (uint64_t)counts * _count_len;
+    uint64_t feed     = distance * JOG_MS_PER_MIN / (elapsed > JOG_WINDOW_MS ? elapsed : JOG_WINDOW_MS);
+    if (feed > _max_feed) {
+        feed = _max_feed;
+    }
+    if (feed == 0) {
+        feed = 1;
+    }
+
+    // Keep the motion in flight within the lag bound.  At the maximum
+    // feed the wheel can outrun the machine; those counts are lost.
+    uint32_t busy = in_flight_ms(now_ms);
+    uint32_t room = busy < _max_lag_ms ? _max_lag_ms - busy : 0;
+    uint64_t ms   = (distance * JOG_MS_PER_MIN + feed - 1) / feed;
+    if (ms > room) {
+        uint32_t fit = (uint64_t)room * feed / ((uint64_t)_count_len * JOG_MS_PER_MIN);
+        stats.dropped += counts - fit;
+        counts   = fit;
+        distance = (uint64_t)counts * _count_len;
+        ms       = (distance * JOG_MS_PER_MIN + feed - 1) / feed;
+    }
+    if (counts == 0) {
+        return;
+    }
+
+    jog_segment_t seg;
+    seg.n_axes = _n_axes;
+    seg.feed   = feed;
+    for (int axis = 0; axis < JOG_MAX_AXES; ++axis) {
+        seg.distance[axis] = direction * (int32_t)counts * _step[axis];
+    }
+    _sink->jog(seg);
+    ++stats.segments;
+
+    _busy_until = now_ms + busy + ms;
+    _direction  = direction;
+    _state      = MOVING;
+}
+
+void JogEngine::reset() {
+    _pending   = 0;
+    _state     = IDLE;
+    _direction = 0;
+}
+
+bool JogEngine::idle(uint32_t now_ms) const {
+    return _pending == 0 && _state != CANCELLING && !in_flight_ms(now_ms);
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Handwheel (MPG) jogging.  Sending one $J line per encoder event
+// floods the jog planner with tiny segments when the wheel spins fast,
+// so the machine keeps moving long after the wheel stops.  JogEngine
+// instead collects encoder counts over a short window and sends them
+// as one segment, at the feed rate that the wheel speed implies.  The
+// motion in flight is estimated from the segments sent, and counts
+// that would push it past the lag bound are dropped, as a hardware MPG
+// does, so the machine stops soon after the wheel.  Turning the wheel
+// back while the machine is still moving cancels the jog and replans
+// from standstill.
+//
+// Distances are in e4 units (1/10000 mm or inch) and feeds in e4 units
+// per minute, so that slow feeds keep their fractions.  Times are passed in and the output goes through a
+// JogSink, so this file has no hardware dependencies and can be tested
+// on the host against a simulated planner.
+
+#pragma once
+
+#include <cstdint>
+
+// Counts are collected for this long before they are sent
+#ifndef JOG_WINDOW_MS
+#    define JOG_WINDOW_MS 50
+#endif
+
+// Most motion allowed in flight, as time at the segment feed rates
+#ifndef JOG_MAX_LAG_MS
+#    define JOG_MAX_LAG_MS 250
+#endif
+
+// Longest wait for a jog cancel to be confirmed by a status report
+#ifndef JOG_CANCEL_TIMEOUT_MS
+#    define JOG_CANCEL_TIMEOUT_MS 1000
+#endif
+
+#define JOG_MAX_AXES 6
+
+// A feed moves feed / JOG_MS_PER_MIN e4 units per ms
+#define JOG_MS_PER_MIN 60000
+
+struct jog_segment_t {
+    int32_t  distance[JOG_MAX_AXES];  // Relative move, e4 units
+    int      n_axes;
+    uint32_t feed;  // e4 units per minute
+};
+
+// Where the engine's output goes; the scene turns it into $J lines
+// and JogCancel
+class JogSink {
+public:
+    virtual ~JogSink()                         = default;
+    virtual void jog(const jog_segment_t& seg) = 0;
+    virtual void cancel()                      = 0;
+};
+
+struct jog_stats_t {
+    uint32_t counts   = 0;  // Encoder counts received
+    uint32_t dropped  = 0;  // Counts dropped to stay within the lag bound
+    uint32_t segments = 0;  // Jog lines sent
+    uint32_t cancels  = 0;  // Jog cancels for reversals
+};
+
+class JogEngine {
+public:
+    enum state_t {
+        IDLE,
+        MOVING,
+        CANCELLING,  // Waiting for a status report to show the stop
+    };
+
+private:
+    JogSink* _sink;
+    uint32_t _max_lag_ms;
+    int      _n_axes = 0;
+    int32_t  _step[JOG_MAX_AXES] {};  // Move per count, per axis
+    uint32_t _count_len = 0;          // Length of the move per count
+    uint32_t _max_feed  = 1000;
+
+    state_t  _state        = IDLE;
+    int32_t  _pending      = 0;  // Counts not yet sent
+    uint32_t _window_start = 0;
+    int      _direction    = 0;  // Sign of the motion in flight
+    uint32_t _busy_until   = 0;  // Estimated end of the motion in flight
+    uint32_t _cancel_at    = 0;
+    uint32_t _cancel_report = 0;
+    uint32_t _last_report   = 0;
+
+    uint32_t in_flight_ms(uint32_t now_ms) const;
+    void     flush(uint32_t now_ms);
+
+public:
+    jog_stats_t stats;
+
+    JogEngine(JogSink* sink, uint32_t max_lag_ms = JOG_MAX_LAG_MS) : _sink(sink), _max_lag_ms(max_lag_ms) {}
+
+    // Move per encoder count for each axis, 0 for axes that do not move
+    void setAxes(const int32_t* step, int n_axes);
+    void setMaxFeed(uint32_t feed) { _max_feed = feed ? feed : 1; }
+
+    void encoder(int counts, uint32_t now_ms);
+
+    // Call on every pass of the main loop.  jogging is whether the last
+    // status report showed the Jog state, and report is a count of
+    // status reports, so a cancel is only taken as finished by a report
+    // that came after it.
+    void poll(uint32_t now_ms, bool jogging, uint32_t report);
+
+    // Forgets pending counts and motion in flight, after the jog was
+    // cancelled some other way
+    void reset();
+
+    // Nothing is pending and the estimated motion has ended
+    bool    idle(uint32_t now_ms) const;
+    state_t state() const { return _state; }
+};
@@ -0,0 +1,117 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "JogStream.h"
+#include <cmath>
+
+void JogStream::start(const int32_t* direction, int n_axes, uint32_t feed, uint32_t now_ms) {
+    if (n_axes > JOG_MAX_AXES) {
+        n_axes = JOG_MAX_AXES;
+    }
+    _n_axes     = n_axes;
+    double sum2 = 0;
+    for (int axis = 0; axis < JOG_MAX_AXES; ++axis) {
+        _dir[axis] = axis < n_axes ? direction[axis] : 0;
+        sum2 += (double)_dir[axis] * _dir[axis];
+    }
+    _dir_len    = (uint32_t)std::lround(std::sqrt(sum2));
+    _feed       = feed ? feed : 1;
+    _streaming  = _dir_len != 0;
+    _stopping   = false;
+    _busy_until = now_ms;
+}
+
+uint32_t JogStream::in_flight_ms(uint32_t now_ms) const {
+    int32_t left = _busy_until - now_ms;
+    return left > 0 ? left : 0;
+}
+
+void JogStream::retire() {
+    for (int i = 1; i < _unacked; ++i) {
+        _sent_ms[i - 1] = _sent_ms[i];
+        _seq[i - 1]     = _seq[i];
+    }
+    --_unacked;
+}
+
+void JogStream::poll(uint32_t now_ms, uint32_t sent, uint32_t replies) {
+    // Replies come back in the order the lines were sent, so the line
+    // numbered seq has been answered once there are more than seq
+    // replies.  Replies to other lines are skipped over.
+    while (_unacked && (int32_t)(replies - _seq[0]) > 0) {
+        uint32_t ms = now_ms - _sent_ms[0];
+        retire();
+        ++stats.acks;
+        stats.latency_ms = (stats.latency_ms * 3 + ms) / 4;
+        if (ms > stats.max_latency_ms) {
+            stats.max_latency_ms = ms;
+        }
+    }
+
+    if (!_streaming) {
+        return;
+    }
+    _segment_ms = stats.latency_ms;
+    if (_segment_ms < JOG_STREAM_MIN_MS) {
+        _segment_ms = JOG_STREAM_MIN_MS;
+    } else if (_segment_ms > JOG_STREAM_MAX_MS) {
+        _segment_ms = JOG_STREAM_MAX_MS;
+    }
+    // Top up the queue when the machine is into its last segments.
+    // Whatever the controller holds when the sending stops is at most
+    // JOG_STREAM_DEPTH segments.
+    while (_unacked < JOG_STREAM_DEPTH && in_flight_ms(now_ms) < (JOG_STREAM_DEPTH - 1) * _segment_ms) {
+        send(now_ms, sent++);
+    }
+}
+
+void JogStream::send(uint32_t now_ms, uint32_t seq) {
+    uint64_t path = (uint64_t)_feed * _segment_ms / JOG_MS_PER_MIN;
+
+    jog_segment_t seg;
+    seg.n_axes = _n_axes;
+    seg.feed   = _feed;
+    for (int axis = 0; axis < JOG_MAX_AXES; ++axis) {
+        seg.distance[axis] = (int32_t)((int64_t)_dir[axis] * (int64_t)path / _dir_len);
+    }
+    _sink->jog(seg);
+    ++stats.segments;
+
+    _sent_ms[_unacked] = now_ms;
+    _seq[_unacked++]   = seq;
+    _busy_until          = now_ms + in_flight_ms(now_ms) + _segment_ms;
+}
+
+void JogStream::stop(uint32_t now_ms, const int32_t* pos, uint32_t report) {
+    if (!_streaming) {
+        return;
+    }
+    _streaming     = false;
+    _unacked       = 0;
+    stats.bound_e4 = (uint64_t)in_flight_ms(now_ms) * _feed / JOG_MS_PER_MIN;
+    ++stats.stops;
+    _busy_until = now_ms;
+
+    _stopping    = true;
+    _stop_report = report;
+    for (int axis = 0; axis < _n_axes; ++axis) {
+        _stop_pos[axis] = pos[axis];
+    }
+}
+
+bool JogStream::report(bool jogging, uint32_t report, const int32_t* pos) {
+    if (!_stopping || report == _stop_report || jogging) {
+        return false;
+    }
+    _stopping   = false;
+    double sum2 = 0;
+    for (int axis = 0; axis < _n_axes; ++axis) {
+        double d = (double)pos[axis] - _stop_pos[axis];
+        sum2 += d * d;
+    }
+    stats.stop_e4 = (uint32_t)std::lround(std::sqrt(sum2));
+    if (stats.stop_e4 > stats.max_stop_e4) {
+        stats.max_stop_e4 = stats.stop_e4;
+    }
+    return true;
+}
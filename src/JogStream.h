@@ -0,0 +1,109 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Continuous jogging while a button is held.  A single long jog that
+// relies on a JogCancel at release keeps the machine going if the
+// release is seen late or the cancel is lost.  JogStream instead sends
+// short jog segments of a fixed duration for as long as it is polled,
+// and keeps only a few of them queued in the controller, so the machine
+// stops within a bounded distance when segments stop arriving.  Each
+// segment lasts about one round trip on the link, measured from each
+// line to its ok, so the next one arrives before the queue runs dry.
+// Replies are matched to lines by their position in the stream of
+// lines sent, so the ok to some other command is not taken for one.
+//
+// Distances are in e4 units and feeds in e4 units per minute, as for
+// JogEngine.  This file has no hardware dependencies so it can be
+// tested on the host.
+
+#pragma once
+
+#include "JogEngine.h"
+
+// Shortest and longest segment duration
+#ifndef JOG_STREAM_MIN_MS
+#    define JOG_STREAM_MIN_MS 50
+#endif
+#ifndef JOG_STREAM_MAX_MS
+#    define JOG_STREAM_MAX_MS 250
+#endif
+
+// Segments queued ahead of the machine
+#ifndef JOG_STREAM_DEPTH
+#    define JOG_STREAM_DEPTH 3
+#endif
+
+// Round trip assumed until one has been measured
+#ifndef JOG_STREAM_LATENCY_MS
+#    define JOG_STREAM_LATENCY_MS 100
+#endif
+
+struct jog_stream_stats_t {
+    uint32_t segments       = 0;  // Jog lines sent
+    uint32_t acks           = 0;  // Replies matched to them
+    uint32_t latency_ms     = JOG_STREAM_LATENCY_MS;  // Smoothed round trip
+    uint32_t max_latency_ms = 0;
+    uint32_t stops          = 0;
+    uint32_t bound_e4       = 0;  // Motion queued when the last stop began
+    uint32_t stop_e4        = 0;  // Distance moved after the last stop began
+    uint32_t max_stop_e4    = 0;
+};
+
+class JogStream {
+private:
+    JogSink* _sink;
+
+    int      _n_axes = 0;
+    int32_t  _dir[JOG_MAX_AXES] {};  // Direction of travel, any length
+    uint32_t _dir_len = 0;
+    uint32_t _feed    = 0;
+
+    bool     _streaming  = false;
+    uint32_t _segment_ms = JOG_STREAM_MIN_MS;
+    uint32_t _busy_until = 0;  // Estimated end of the queued motion
+
+    // Send times and line numbers of segments not yet acknowledged
+    uint32_t _sent_ms[JOG_STREAM_DEPTH] {};
+    uint32_t _seq[JOG_STREAM_DEPTH] {};
+    int      _unacked = 0;
+
+    void     retire();
+
+    // Measuring the distance moved after a stop
+    bool     _stopping = false;
+    uint32_t _stop_report = 0;
+    int32_t  _stop_pos[JOG_MAX_AXES] {};
+
+    uint32_t in_flight_ms(uint32_t now_ms) const;
+    void     send(uint32_t now_ms, uint32_t seq);
+
+public:
+    jog_stream_stats_t stats;
+
+    JogStream(JogSink* sink) : _sink(sink) {}
+
+    // Starts streaming along direction, e.g. the selected axes' jog
+    // distances with the sign of the button, at feed
+    void start(const int32_t* direction, int n_axes, uint32_t feed, uint32_t now_ms);
+
+    // Call on every pass of the main loop.  sent is a count of the lines
+    // sent to the controller, and replies of the replies (ok or error)
+    // to them.  Each segment is one line.  Lines whose replies were lost
+    // must be counted as answered, as LineCounter does, or the stream
+    // stalls waiting for them.
+    void poll(uint32_t now_ms, uint32_t sent, uint32_t replies);
+
+    // Stops sending.  The caller cancels the jog, which may discard the
+    // segments still queued, so they are no longer waited for.  pos is
+    // the machine position when the stop began, and report the count of
+    // status reports so far.
+    void stop(uint32_t now_ms, const int32_t* pos, uint32_t report);
+
+    // Call with each status report while stopping.  Returns true when
+    // a report shows the machine stopped and the distance it went after
+    // the stop has been recorded.
+    bool report(bool jogging, uint32_t report, const int32_t* pos);
+
+    bool     streaming() const { return _streaming; }
+    uint32_t segmentMs() const { return _segment_ms; }
+};
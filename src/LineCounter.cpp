@@ -0,0 +1,38 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "LineCounter.h"
+
+void LineCounter::update(const void* source, uint32_t lines, uint32_t now_ms) {
+    // A new transport starts counting from zero
+    if (source != _source) {
+        _source       = source;
+        _source_lines = 0;
+        resync();
+    }
+    if ((int32_t)(lines - _source_lines) < 0) {
+        _source_lines = lines;
+        resync();
+    }
+    for (; _source_lines != lines; ++_source_lines) {
+        _sent_ms[_sent++ % n_times] = now_ms;
+    }
+    // Giving up on only the oldest line would let the replies to lines
+    // sent after it fill the places of the others lost with it
+    if (_replies != _sent && (now_ms - _sent_ms[_replies % n_times]) > LINE_REPLY_TIMEOUT_MS) {
+        resync();
+    }
+}
+
+void LineCounter::reply() {
+    if (_replies == _sent) {
+        ++stray;
+        return;
+    }
+    ++_replies;
+}
+
+void LineCounter::resync() {
+    lost += _sent - _replies;
+    _replies = _sent;
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Matches FluidNC's replies to the lines sent to it.  FluidNC answers
+// each line it receives with ok or error, in order, so the nth reply
+// answers the nth line.  The lines are counted by the transport as it
+// writes them, so lines dropped on the way are never waited for.
+//
+// The counts still drift apart when replies are lost, as when FluidNC
+// resets or the connection drops with lines in flight.  They are put
+// back in step, by giving up on every line still waiting, when the
+// transport changes, when resync() is called, and when the oldest line
+// has waited LINE_REPLY_TIMEOUT_MS for its reply.  A reply with no line
+// waiting for it is ignored.
+//
+// This file has no hardware dependencies so it can be tested on the
+// host.
+
+#pragma once
+
+#include <cstdint>
+
+#ifndef LINE_REPLY_TIMEOUT_MS
+#    define LINE_REPLY_TIMEOUT_MS 1000
+#endif
+
+class LineCounter {
+private:
+    static const int n_times = 16;
+
+    const void* _source       = nullptr;
+    uint32_t    _source_lines = 0;
+    uint32_t    _sent         = 0;
+    uint32_t    _replies      = 0;
+
+    // When each line was first counted, indexed by line number.  With
+    // more lines waiting than this, a later line's time stands in.
+    uint32_t _sent_ms[n_times] {};
+
+public:
+    uint32_t lost  = 0;  // Lines given up on, whose replies never came
+    uint32_t stray = 0;  // Replies with no line waiting
+
+    // Call before using the counts or counting a reply.  lines is the
+    // count of lines source has written; a different source is a new
+    // connection, on which nothing sent on the old one will be answered.
+    void update(const void* source, uint32_t lines, uint32_t now_ms);
+
+    // Counts a reply to the oldest line waiting for one
+    void reply();
+
+    // Gives up on every line still waiting, e.g. when FluidNC resets
+    void resync();
+
+    // Both counts only go up, so they can be compared with the line
+    // numbers taken from sent() earlier
+    uint32_t sent() const { return _sent; }
+    uint32_t replies() const { return _replies; }
+};
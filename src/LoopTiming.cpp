@@ -0,0 +1,94 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "LoopTiming.h"
+#include <cstdio>
+
+const char* LoopTimer::phase_name(loop_phase_t phase) {
+    static const char* names[] = { "wifi", "transport", "poll", "events", "flush" };
+    return phase < LP_COUNT ? names[phase] : "?";
+}
+
+void LoopTimer::start(uint32_t now_us) {
+    _start = now_us;
+    _mark  = now_us;
+    for (auto& us : _phase_us) {
+        us = 0;
+    }
+}
+
+void LoopTimer::mark(loop_phase_t phase, uint32_t now_us) {
+    uint32_t us = now_us - _mark;
+    _mark       = now_us;
+    _phase_us[phase] += us;
+    phases[phase].add(us);
+}
+
+const loop_stall_t* LoopTimer::finish(uint32_t now_us, uint32_t now_ms, const char* scene) {
+    uint32_t total = now_us - _start;
+    iterations.add(total);
+    if (total < _stall_us) {
+        return nullptr;
+    }
+    loop_phase_t longest = LP_WIFI;
+    for (int p = 1; p < LP_COUNT; ++p) {
+        if (_phase_us[p] > _phase_us[longest]) {
+            longest = (loop_phase_t)p;
+        }
+    }
+    loop_stall_t& s = _stalls[_next_stall];
+    s.when_ms       = now_ms;
+    s.total_us      = total;
+    s.phase         = longest;
+    s.phase_us      = _phase_us[longest];
+    s.scene         = scene ? scene : "";
+    _next_stall     = (_next_stall + 1) % LOOP_STALL_RECORDS;
+    ++stall_count;
+    return &s;
+}
+
+size_t LoopTimer::stalls() const {
+    return stall_count < LOOP_STALL_RECORDS ? stall_count : LOOP_STALL_RECORDS;
+}
+
+const loop_stall_t& LoopTimer::stall(size_t n) const {
+    return _stalls[(_next_stall + LOOP_STALL_RECORDS - 1 - n) % LOOP_STALL_RECORDS];
+}
+
+static void dump_histogram(void (*print)(const char*), const char* name, const LatencyHistogram& h) {
+    char line[120];
+    snprintf(line,
+             sizeof(line),
+             "%-10s n %u avg %u p99 %u max %u us\n",
+             name,
+             (unsigned)h.count,
+             (unsigned)h.average_us(),
+             (unsigned)h.percentile_us(99),
+             (unsigned)h.max_us);
+    print(line);
+}
+
+void LoopTimer::dump(void (*print)(const char* line)) const {
+    char line[120];
+    print("Main loop timing\n");
+    dump_histogram(print, "loop", iterations);
+    for (int p = 0; p < LP_COUNT; ++p) {
+        if (phases[p].count) {
+            dump_histogram(print, phase_name((loop_phase_t)p), phases[p]);
+        }
+    }
+    snprintf(line, sizeof(line), "%u stalls over %u ms, latest first\n", (unsigned)stall_count, (unsigned)(_stall_us / 1000));
+    print(line);
+    for (size_t i = 0; i < stalls(); ++i) {
+        const loop_stall_t& s = stall(i);
+        snprintf(line,
+                 sizeof(line),
+                 "  at %u ms: %u ms, %u ms in %s, scene %s\n",
+                 (unsigned)s.when_ms,
+                 (unsigned)(s.total_us / 1000),
+                 (unsigned)(s.phase_us / 1000),
+                 phase_name(s.phase),
+                 s.scene);
+        print(line);
+    }
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Timing of the main loop.  loop() marks the end of each of its
+// phases, which are counted in histograms.  An iteration that takes
+// longer than the stall threshold is a stall; the last few are kept
+// with the phase that took longest and the scene that was showing, so
+// freezes seen in the field can be traced to their cause.  This file
+// has no hardware dependencies so it can be tested on the host.
+
+#pragma once
+
+#include "transport/tx_lanes.h"  // LatencyHistogram
+#include <cstdint>
+#include <cstddef>
+
+#ifndef LOOP_STALL_MS
+#    define LOOP_STALL_MS 250
+#endif
+
+#ifndef LOOP_STALL_RECORDS
+#    define LOOP_STALL_RECORDS 16
+#endif
+
+enum loop_phase_t {
+    LP_WIFI,       // wifiReady() and init_wifi_transport()
+    LP_TRANSPORT,  // transport->loop()
+    LP_POLL,       // fnc_poll()
+    LP_EVENTS,     // dispatch_events()
+    LP_FLUSH,      // transport->flush()
+    LP_COUNT,
+};
+
+struct loop_stall_t {
+    uint32_t     when_ms;   // When the iteration ended
+    uint32_t     total_us;  // Length of the iteration
+    loop_phase_t phase;     // The longest phase
+    uint32_t     phase_us;
+    const char*  scene;
+};
+
+class LoopTimer {
+private:
+    uint32_t     _stall_us;
+    uint32_t     _start    = 0;
+    uint32_t     _mark     = 0;
+    uint32_t     _phase_us[LP_COUNT] {};
+    loop_stall_t _stalls[LOOP_STALL_RECORDS];
+    size_t       _next_stall = 0;
+
+public:
+    LatencyHistogram phases[LP_COUNT];
+    LatencyHistogram iterations;
+    uint32_t         stall_count = 0;
+
+    LoopTimer(uint32_t stall_ms = LOOP_STALL_MS) : _stall_us(stall_ms * 1000) {}
+
+    void start(uint32_t now_us);
+    void mark(loop_phase_t phase, uint32_t now_us);
+
+    // Ends the iteration.  Returns its stall record if it was a stall,
+    // otherwise nullptr.
+    const loop_stall_t* finish(uint32_t now_us, uint32_t now_ms, const char* scene);
+
+    // Stalls kept, up to LOOP_STALL_RECORDS; stall(0) is the latest
+    size_t              stalls() const;
+    const loop_stall_t& stall(size_t n) const;
+
+    // Writes the histograms and stalls as text lines
+    void dump(void (*print)(const char* line)) const;
+
+    static const char* phase_name(loop_phase_t phase);
+};
+
+extern LoopTimer loop_timer;
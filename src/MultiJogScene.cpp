@@ -5,6 +5,9 @@
 
 #include "Scene.h"
 #include "ConfirmScene.h"
+#include "JogEngine.h"
+#include "JogStream.h"
+#include "EncoderStream.h"
 #include "e4math.h"
 
 extern Scene helpScene;
@@ -20,27 +23,113 @@ static const char* jog_help_text[] = { "Jog Help",
                                        "Swipe left to exit",
                                        NULL };
 
+// Sends the handwheel jog engine's segments as jog lines
+class MpgJogSink : public JogSink {
+public:
+    void jog(const jog_segment_t& seg) override {
+        // FluidNC applies G20 to every axis, so a jog that moves a
+        // rotary axis goes out in G21 to keep its degrees as they are
+        bool rotary = false;
+        bool linear = false;
+        for (int axis = 0; axis < seg.n_axes; ++axis) {
+            if (seg.distance[axis]) {
+                if (axisIsRotary(axis)) {
+                    rotary = true;
+                } else {
+                    linear = true;
+                }
+            }
+        }
+        bool to_mm = inInches && rotary;
+
+        // e.g. $J=G91G21X-1.00F3000
+        std::string cmd("$J=G91");
+        cmd += inInches && !to_mm ? "G20" : "G21";
+        for (int axis = 0; axis < seg.n_axes; ++axis) {
+            if (seg.distance[axis]) {
+                e4_t distance = seg.distance[axis];
+                if (to_mm && !axisIsRotary(axis)) {
+                    distance = (int64_t)distance * 254 / 10;
+                }
+                cmd += axisNumToChar(axis);
+                // Full precision, as streamed segments can be short
+                cmd += e4_to_cstr(distance, 4);
+            }
+        }
+        cmd += "F";
+        e4_t feed = seg.feed;
+        if (to_mm && linear) {
+            feed = (int64_t)feed * 254 / 10;
+        }
+        cmd += e4_to_cstr(feed, 3);
+        send_line(cmd.c_str());
+    }
+    void cancel() override { fnc_realtime(JogCancel); }
+};
+
+// Rows of DROs on the screen.  With more axes than this, the rows show
+// a window onto the axes that follows the selection.
+static const int DRO_ROWS = 3;
+
 class MultiJogScene : public Scene {
 private:
-    int          _dist_index[3] = { 2, 2, 2 };
-    int          max_index() { return 6; }  // 10^3 = 1000;
-    int          min_index() { return 0; }  // 10^3 = 1000;
+    int          _dist_index[JOG_MAX_AXES] = { 2, 2, 2, 2, 2, 2 };
+    int          max_index(int axis) { return axisIsRotary(axis) ? 4 : 6; }  // 100 degrees at most
+    int          min_index() { return 0; }
     int          _selected_mask = 1 << 0;
-    const int    num_axes       = 3;
+    int          _first_row     = 0;  // Axis in the top row
     bool         _cancelling    = false;
     bool         _cancel_held   = false;
     bool         _continuous    = false;
     LGFX_Sprite* _bg_image      = nullptr;
 
+    MpgJogSink _mpg_sink;
+    JogEngine  _mpg { &_mpg_sink };
+    JogStream  _stream { &_mpg_sink };
+
+    // Fastest jog, in mm/min for linear axes and degrees/min for
+    // rotary ones.  The MaxFeed preference for an axis overrides it.
+    int _max_feed[JOG_MAX_AXES] = { 10000, 10000, 10000, 3600, 3600, 3600 };
+
+    // While jogging only the DRO values change, so they are retained.
+    // There is one widget per row, not per axis, so the cost of a frame
+    // does not depend on the number of axes.
+    WidgetTree _widgets;
+    DROWidget  _dros[DRO_ROWS] = { { 16, 68, 210, 32, 0 }, { 16, 101, 210, 32, 1 }, { 16, 134, 210, 32, 2 } };
+
+    // Everything the full redraw shows apart from the DROs
+    uint32_t layout() {
+        return WidgetKey()
+            .add(_bg_image)
+            .add(state)
+            .add(my_state_string)
+            .add(lastAlarm)
+            .add(_cancelling || _cancel_held)
+            .add(_continuous)
+            .add(_selected_mask)
+            .add(num_axes())
+            .add(_first_row);
+    }
+
 public:
-    MultiJogScene() : Scene("Jog", 4, jog_help_text) {}
+    MultiJogScene() : Scene("Jog", 4, jog_help_text) {
+        for (auto& dro : _dros) {
+            _widgets.add(dro);
+        }
+        // Up to ten times the selected distance when the wheel spins
+        setEncoderCurve({ 6, 30, 10 });
+    }
 
-    e4_t distance(int axis) { return e4_power10(_dist_index[axis] - num_digits()); }
+    // The axes that FluidNC reports, up to JOG_MAX_AXES
+    int num_axes() { return n_axes < 1 ? 1 : n_axes > JOG_MAX_AXES ? JOG_MAX_AXES : n_axes; }
+    int num_rows() { return num_axes() < DRO_ROWS ? num_axes() : DRO_ROWS; }
+
+    e4_t distance(int axis) { return e4_power10(_dist_index[axis] - num_digits(axis)); }
     void unselect_all() { _selected_mask = 0; }
     bool selected(int axis) { return _selected_mask & (1 << axis); }
     bool only(int axis) { return _selected_mask == (1 << axis); }
 
-    int  next(int axis) { return (axis < 2) ? axis + 1 : 0; }
+    int  next(int axis) { return (axis + 1 < num_axes()) ? axis + 1 : 0; }
     void select(int axis) { _selected_mask |= 1 << axis; }
     void unselect(int axis) { _selected_mask &= ~(1 << axis); }
 
@@ -48,7 +137,7 @@ public:
         if ((_selected_mask & (_selected_mask - 1)) != 0) {
             return -2;  // Multiple axes are selected
         }
-        for (size_t axis = 0; axis < num_axes; axis++) {
+        for (int axis = 0; axis < num_axes(); axis++) {
             if (selected(axis)) {
                 return axis;
             }
@@ -56,29 +145,80 @@ public:
         return -1;  // No axis is selected
     }
 
+    // Moves the window of rows so that axis is on the screen
+    void scroll_to(int axis) {
+        if (axis < _first_row) {
+            _first_row = axis;
+        } else if (axis >= _first_row + DRO_ROWS) {
+            _first_row = axis - DRO_ROWS + 1;
+        }
+    }
+    void fit_rows() {
+        int last = num_axes() - num_rows();
+        if (_first_row > last) {
+            _first_row = last;
+        }
+    }
+
+    void drawDROs() {
+        for (int row = 0; row < num_rows(); row++) {
+            int axis = _first_row + row;
+            _dros[row].setAxis(axis);
+            _dros[row].draw(_dist_index[axis], selected(axis));
+        }
+    }
+
+    // e.g. "X Y [Z A B] C", with the axes on the screen in brackets
+    void drawAxisWindow() {
+        if (num_axes() <= DRO_ROWS) {
+            return;
+        }
+        std::string window;
+        for (int axis = 0; axis < num_axes(); axis++) {
+            if (axis) {
+                window += ' ';
+            }
+            if (axis == _first_row) {
+                window += '[';
+            }
+            window += axisNumToChar(axis);
+            if (axis == _first_row + DRO_ROWS - 1) {
+                window += ']';
+            }
+        }
+        centered_text(window.c_str(), 176, DARKGREY, TINY);
+    }
+
     void reDisplay() {
+        if (state != Jog && _cancelling) {
+            _cancelling = false;
+        }
+        fit_rows();
+        if (_widgets.retained(layout())) {
+            if (!(_cancelling || _cancel_held)) {
+                drawDROs();
+            }
+            refreshDisplay();
+            return;
+        }
+
         background();
         drawBackground(_bg_image);
         drawMenuTitle(current_scene->name());
         drawStatus();
 
-        if (state != Jog && _cancelling) {
-            _cancelling = false;
-        }
         if (_cancelling || _cancel_held) {
             centered_text("Jog Canceled", 120, RED, MEDIUM);
         } else {
-            DRO dro(16, 68, 210, 32);
-            for (size_t axis = 0; axis < num_axes; axis++) {
-                dro.draw(axis, _dist_index[axis], selected(axis));
-            }
+            drawDROs();
+            drawAxisWindow();
             if (state == Jog) {
                 if (!_continuous) {
-                    centered_text("Touch to cancel jog", 185, YELLOW, TINY);
+                    centered_text("Touch to cancel jog", 192, YELLOW, TINY);
                 }
             } else {
                 std::string dialLegend("Zero");
-                for (int axis = 0; axis < num_axes; axis++) {
+                for (int axis = 0; axis < num_axes(); axis++) {
                     if (selected(axis)) {
                         dialLegend += axisNumToChar(axis);
                     }
@@ -90,7 +230,7 @@ public:
     }
     void zero_axes() {
         std::string cmd = "G10L20P0";
-        for (int axis = 0; axis < num_axes; axis++) {
+        for (int axis = 0; axis < num_axes(); axis++) {
             if (selected(axis)) {
                 cmd += axisNumToChar(axis);
                 cmd += "0";
@@ -104,23 +244,24 @@ public:
         }
         if (initPrefs()) {
             _bg_image = createPngBackground("/jogbg.png");
-            for (size_t axis = 0; axis < 3; axis++) {
+            for (int axis = 0; axis < JOG_MAX_AXES; axis++) {
                 getPref("DistanceDigit", axis, &_dist_index[axis]);
+                getPref("MaxFeed", axis, &_max_feed[axis]);
             }
         }
     }
 
+    // The axis in the row at y, or -1 for an empty row
     int which(int x, int y) {
-        if (y > 130) {
-            return 2;
-        }
-        return y > 90 ? 1 : 0;
+        int row  = y > 130 ? 2 : y > 90 ? 1 : 0;
+        int axis = _first_row + row;
+        return row < num_rows() ? axis : -1;
     }
 
     void confirm_zero_axes() {
         std::string confirmMsg("Zero ");
 
-        for (int axis = 0; axis < num_axes; axis++) {
+        for (int axis = 0; axis < num_axes(); axis++) {
             if (selected(axis)) {
                 confirmMsg += axisNumToChar(axis);
             }
@@ -135,12 +276,12 @@ public:
     }
 
     void increment_distance(int axis) {
-        if (_dist_index[axis] < max_index()) {
+        if (_dist_index[axis] < max_index(axis)) {
             set_dist_index(axis, _dist_index[axis] + 1);
         }
     }
     void increment_distance() {
-        for (int axis = 0; axis < num_axes; axis++) {
+        for (int axis = 0; axis < num_axes(); axis++) {
             if (selected(axis)) {
                 increment_distance(axis);
             }
@@ -153,24 +294,37 @@ public:
     }
 
     void decrement_distance() {
-        for (int axis = 0; axis < num_axes; axis++) {
+        for (int axis = 0; axis < num_axes(); axis++) {
             if (selected(axis)) {
                 decrement_distance(axis);
             }
         }
     }
     void rotate_distance() {
-        for (int axis = 0; axis < num_axes; axis++) {
+        for (int axis = 0; axis < num_axes(); axis++) {
             if (selected(axis)) {
-                if (++_dist_index[axis] >= max_index()) {
+                if (++_dist_index[axis] >= max_index(axis)) {
                     _dist_index[axis] = min_index();
                 }
             }
         }
     }
+    void positions(int32_t* pos) {
+        for (int axis = 0; axis < num_axes(); ++axis) {
+            pos[axis] = myAxes[axis];
+        }
+    }
     void cancel_jog() {
-        if (state == Jog) {
-            fnc_realtime(JogCancel);
+        _mpg.reset();
+        bool streaming = _stream.streaming();
+        if (streaming) {
+            int32_t pos[JOG_MAX_AXES];
+            positions(pos);
+            _stream.stop(milliseconds(), pos, status_reports);
+        }
+        // A streamed jog may not have shown up in a report yet
+        if (state == Jog || streaming) {
+            _mpg_sink.cancel();
             _continuous = false;
             _cancelling = true;
         }
@@ -179,15 +333,15 @@ public:
         int the_axis = the_selected_axis();
         if (the_axis == -2) {
             unselect_all();
-            select(num_axes - 1);
+            select(num_axes() - 1);
             return;
         }
         if (the_axis == -1) {
-            select(num_axes - 1);
+            select(num_axes() - 1);
             return;
         }
         unselect(the_axis);
-        if (++the_axis == num_axes) {
+        if (++the_axis == num_axes()) {
             the_axis = 0;
         }
         select(the_axis);
@@ -205,16 +359,18 @@ public:
         }
         unselect(the_axis);
         if (--the_axis < 0) {
-            the_axis = num_axes - 1;
+            the_axis = num_axes() - 1;
         }
         select(the_axis);
     }
     void touch_top() {
         prev_axis();
+        scroll_to(the_selected_axis() >= 0 ? the_selected_axis() : 0);
         reDisplay();
     }
     void touch_bottom() {
         next_axis();
+        scroll_to(the_selected_axis() >= 0 ? the_selected_axis() : num_axes() - 1);
         reDisplay();
     }
     void touch_left() {
@@ -275,6 +431,9 @@ public:
         // Select multiple axes
         if (touchX < 80) {
             int axis = which(touchX, touchY);
+            if (axis < 0) {
+                return;
+            }
             if (selected(axis) && !only(axis)) {
                 unselect(axis);
             } else {
@@ -298,53 +457,56 @@ public:
         zero_axes();
     }
 
+    // The lowest limit of the selected axes, in e4 units per minute in
+    // the units of the jog
+    uint32_t max_feed() {
+        uint32_t feed = 0;
+        for (int axis = 0; axis < num_axes(); ++axis) {
+            if (selected(axis)) {
+                uint32_t limit = _max_feed[axis] * 10000;
+                if (inInches && !axisIsRotary(axis)) {
+                    limit = (uint64_t)limit * 10 / 254;
+                }
+                if (feed == 0 || limit < feed) {
+                    feed = limit;
+                }
+            }
+        }
+        return feed;
+    }
+
     void start_mpg_jog(int delta) {
-        // e.g. $J=G91 G21 X-10000 F10000
-        std::string cmd("$J=G91");
-        cmd += inInches ? "G20" : "G21";
-        for (int axis = 0; axis < num_axes; ++axis) {
+        int32_t steps[JOG_MAX_AXES] = {};
+        for (int axis = 0; axis < num_axes(); ++axis) {
             if (selected(axis)) {
-                cmd += axisNumToChar(axis);
-                cmd += e4_to_cstr(delta * distance(axis), inInches ? 3 : 2);
+                steps[axis] = distance(axis);
             }
         }
-        cmd += "F";
-        cmd += inInches ? "400" : "10000";
-        send_line(cmd.c_str());
+        _mpg.setAxes(steps, num_axes());
+        _mpg.setMaxFeed(max_feed());
+        // The time the counts were sampled, not when this pass got to them
+        uint32_t age_ms = (microseconds() - encoder_event_us) / 1000;
+        _mpg.encoder(delta, milliseconds() - age_ms);
     }
     void start_button_jog(bool negative) {
-        // e.g. $J=G91F1000X-10000
-        e4_t total_distance = 0;
-        int  n_axes         = 0;
-        for (int axis = 0; axis < num_axes; ++axis) {
+        // Short segments along the selected axes for as long as the
+        // button is held, in proportion to their jog distances
+        int32_t direction[JOG_MAX_AXES] = {};
+        e4_t    total_distance          = 0;
+        for (int axis = 0; axis < num_axes(); ++axis) {
             if (selected(axis)) {
-                total_distance = e4_magnitude(total_distance, distance(axis));
-                ++n_axes;
+                direction[axis] = negative ? -distance(axis) : distance(axis);
+                total_distance  = e4_magnitude(total_distance, distance(axis));
             }
         }
 
-        e4_t feedrate = total_distance * 300;  // go 5x the highlighted distance in 1 second
-
-        std::string cmd("$J=G91");
-        cmd += inInches ? "G20" : "G21";
-        cmd += "F";
-        cmd += e4_to_cstr(feedrate, 3);
-        for (int axis = 0; axis < num_axes; ++axis) {
-            if (selected(axis)) {
-                e4_t axis_distance;
-                if (n_axes == 1) {
-                    axis_distance = e4_from_int(inInches ? 200 : 5000);
-                } else {
-                    axis_distance = distance(axis) * 20;
-                }
-                if (negative) {
-                    axis_distance = -axis_distance;
-                }
-                cmd += axisNumToChar(axis);
-                cmd += e4_to_cstr(axis_distance, 0);
-            }
+        // go 5x the highlighted distance in 1 second
+        uint64_t feed  = (uint64_t)total_distance * 300;
+        uint32_t limit = max_feed();
+        if (feed > limit) {
+            feed = limit;
         }
-        send_line(cmd.c_str());
+        _stream.start(direction, num_axes(), feed, milliseconds());
         _continuous = true;
     }
 
@@ -371,8 +533,27 @@ public:
         }
     }
 
+    void onTick() override {
+        // Sends the counts collected over the last window
+        _mpg.poll(milliseconds(), state == Jog, status_reports);
+
+        // Tops up the button jog while it is held
+        _stream.poll(milliseconds(), lines_sent(), line_replies());
+        int32_t pos[JOG_MAX_AXES];
+        positions(pos);
+        if (_stream.report(state == Jog, status_reports, pos)) {
+            auto&       stats = _stream.stats;
+            std::string stopped(e4_to_cstr(stats.stop_e4, inInches ? 3 : 2));
+            std::string queued(e4_to_cstr(stats.bound_e4, inInches ? 3 : 2));
+            dbg_printf("Jog stopped %s after release, %s queued, round trip %u ms\n",
+                       stopped.c_str(),
+                       queued.c_str(),
+                       (unsigned)stats.latency_ms);
+        }
+    }
+
     void onDROChange() {
-        reDisplay();
+        schedule_redisplay();
     }
     void onLimitsChange() {
         reDisplay();
@@ -0,0 +1,28 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "OverrideBurst.h"
+
+size_t override_burst(int delta, int percent, const override_cmds_t& cmds, uint8_t* out, size_t max) {
+    int target = percent + delta;
+    if (target > OVERRIDE_MAX_PERCENT) {
+        target = OVERRIDE_MAX_PERCENT;
+    } else if (target < OVERRIDE_MIN_PERCENT) {
+        target = OVERRIDE_MIN_PERCENT;
+    }
+    int     change = target - percent;
+    bool    up     = change > 0;
+    int     steps  = up ? change : -change;
+    size_t  n      = 0;
+    uint8_t coarse = up ? cmds.coarse_plus : cmds.coarse_minus;
+    uint8_t fine   = up ? cmds.fine_plus : cmds.fine_minus;
+    // The intermediate values lie between percent and target, so
+    // FluidNC never clamps a step and the sum comes out exact
+    for (int i = 0; i < steps / 10 && n < max; ++i) {
+        out[n++] = coarse;
+    }
+    for (int i = 0; i < steps % 10 && n < max; ++i) {
+        out[n++] = fine;
+    }
+    return n;
+}
@@ -0,0 +1,33 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Turns a change of a feed or spindle override into FluidNC's realtime
+// override commands.  With the encoder curve a fast spin can ask for a
+// change of 100% or more in one frame, which is too many bytes as 1%
+// steps, so the bulk of a change goes as 10% steps and only the rest as
+// 1% steps.  The result stays within FluidNC's 10% to 200% range.  This
+// file has no hardware dependencies so it can be tested on the host.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define OVERRIDE_MIN_PERCENT 10
+#define OVERRIDE_MAX_PERCENT 200
+
+// The realtime bytes for one override
+struct override_cmds_t {
+    uint8_t coarse_plus;   // +10%
+    uint8_t coarse_minus;  // -10%
+    uint8_t fine_plus;     // +1%
+    uint8_t fine_minus;    // -1%
+};
+
+// Most bytes in one burst: 19 coarse steps and 9 fine ones cover the
+// whole range
+#define OVERRIDE_BURST_MAX 28
+
+// Writes the commands that change percent by delta into out, which has
+// room for max bytes, and returns their count
+size_t override_burst(int delta, int percent, const override_cmds_t& cmds, uint8_t* out, size_t max);
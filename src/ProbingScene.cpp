@@ -62,7 +62,7 @@ public:
         ackBeep();
     }
 
-    void onDROChange() { reDisplay(); }
+    void onDROChange() { schedule_redisplay(); }
 
     void onEncoder(int delta) {
         if (abs(delta) > 0) {
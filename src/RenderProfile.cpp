@@ -0,0 +1,215 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#ifdef RENDER_PROFILE
+
+#    include "RenderProfile.h"
+#    include "System.h"
+#    include "Scene.h"
+#    include <algorithm>
+#    include <vector>
+
+// The CPU cycle counter where there is one, so that short phases
+// are not lost in microsecond rounding
+#    ifdef ARDUINO
+static inline uint32_t cycles() {
+    return ESP.getCycleCount();
+}
+static uint32_t cycles_per_us() {
+    return ESP.getCpuFreqMHz();
+}
+#    else
+static inline uint32_t cycles() {
+    return microseconds();
+}
+static uint32_t cycles_per_us() {
+    return 1;
+}
+#    endif
+
+static const char* phase_names[] = { "background", "image", "text", "diff", "push" };
+
+struct FrameSample {
+    uint32_t total;
+    uint32_t phase[RP_NONE];
+};
+
+struct SceneProfile {
+    const char*              name;
+    std::vector<FrameSample> frames;  // Ring of the most recent frames
+    size_t                   next  = 0;
+    uint32_t                 count = 0;  // Frames since boot
+
+    SceneProfile(const char* n) : name(n) { frames.reserve(RENDER_PROFILE_FRAMES); }
+
+    void add(const FrameSample& f) {
+        if (frames.size() < RENDER_PROFILE_FRAMES) {
+            frames.push_back(f);
+        } else {
+            frames[next] = f;
+        }
+        next = (next + 1) % RENDER_PROFILE_FRAMES;
+        ++count;
+    }
+};
+
+static std::vector<SceneProfile> profiles;
+
+static SceneProfile* find_profile(const char* scene, bool create) {
+    for (auto& p : profiles) {
+        if (p.name == scene) {
+            return &p;
+        }
+    }
+    if (!create) {
+        return nullptr;
+    }
+    profiles.emplace_back(scene);
+    return &profiles.back();
+}
+
+static FrameSample    frame;
+static bool           frame_open  = false;
+static uint32_t       frame_start = 0;
+static uint32_t       phase_mark  = 0;
+static render_phase_t current     = RP_NONE;
+
+static bool hud = false;
+
+static void open_frame(uint32_t now) {
+    if (!frame_open) {
+        frame_open  = true;
+        frame       = {};
+        frame_start = now;
+        phase_mark  = now;
+    }
+}
+
+// Charges the time since the last mark to the running phase
+static void charge(uint32_t now) {
+    if (current != RP_NONE) {
+        frame.phase[current] += now - phase_mark;
+    }
+    phase_mark = now;
+}
+
+RenderPhase::RenderPhase(render_phase_t phase) {
+    uint32_t now = cycles();
+    open_frame(now);
+    charge(now);
+    _outer  = current;
+    current = phase;
+}
+
+RenderPhase::~RenderPhase() {
+    charge(cycles());
+    current = _outer;
+}
+
+void render_frame_begin() {
+    open_frame(cycles());
+}
+
+void render_frame_end(const char* scene) {
+    if (!frame_open) {
+        return;
+    }
+    uint32_t now = cycles();
+    charge(now);
+    frame.total = now - frame_start;
+    frame_open  = false;
+    find_profile(scene, true)->add(frame);
+}
+
+struct Summary {
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t p99_us;
+    uint32_t phase_us[RP_NONE];
+    uint32_t scene_us;  // Frame time outside every phase
+};
+
+static void summarize(const SceneProfile& p, Summary& s) {
+    uint32_t              cpu = cycles_per_us();
+    std::vector<uint32_t> totals;
+    uint64_t              sum = 0;
+    uint64_t              phase_sum[RP_NONE] {};
+    for (auto& f : p.frames) {
+        totals.push_back(f.total);
+        sum += f.total;
+        for (int i = 0; i < RP_NONE; ++i) {
+            phase_sum[i] += f.phase[i];
+        }
+    }
+    size_t n = totals.size();
+    std::sort(totals.begin(), totals.end());
+    s.min_us        = totals[0] / cpu;
+    s.avg_us        = sum / n / cpu;
+    s.p99_us        = totals[std::min(n - 1, (n * 99) / 100)] / cpu;
+    uint32_t phases = 0;
+    for (int i = 0; i < RP_NONE; ++i) {
+        s.phase_us[i] = phase_sum[i] / n / cpu;
+        phases += s.phase_us[i];
+    }
+    s.scene_us = s.avg_us > phases ? s.avg_us - phases : 0;
+}
+
+void render_profile_dump() {
+    dbg_printf("Render profile in us, last %d frames of each scene\n", RENDER_PROFILE_FRAMES);
+    for (auto& p : profiles) {
+        Summary s;
+        summarize(p, s);
+        dbg_printf("%s: %u frames, min %u avg %u p99 %u\n", p.name, p.count, s.min_us, s.avg_us, s.p99_us);
+        dbg_printf("  avg");
+        for (int i = 0; i < RP_NONE; ++i) {
+            dbg_printf(" %s %u", phase_names[i], s.phase_us[i]);
+        }
+        dbg_printf(" scene %u\n", s.scene_us);
+    }
+}
+
+bool render_profile_gesture(int x, int y) {
+    if (y >= display.height() / 10) {
+        return false;
+    }
+    hud = !hud;
+    if (!hud) {
+        // The HUD was drawn over retained widgets, so the scene
+        // must draw everything again
+        ++scene_activations;
+        schedule_redisplay();
+    }
+    return true;
+}
+
+void render_profile_hud() {
+    if (!hud || !current_scene) {
+        return;
+    }
+    SceneProfile* p = find_profile(current_scene->name(), false);
+    if (!p || p->frames.empty()) {
+        return;
+    }
+    uint32_t start = cycles();
+
+    Summary s;
+    summarize(*p, s);
+
+    char line[32];
+    snprintf(line, sizeof(line), "%u.%u p99 %u.%u ms", s.avg_us / 1000, s.avg_us / 100 % 10, s.p99_us / 1000, s.p99_us / 100 % 10);
+    int w = canvas.width() / 2;
+    int x = (canvas.width() - w) / 2;
+    int y = canvas.height() - 40;
+    canvas.fillRect(x, y, w, 12, BLACK);
+    canvas.setFont(&fonts::Font0);
+    canvas.setTextDatum(top_center);
+    canvas.setTextColor(YELLOW);
+    canvas.drawString(line, canvas.width() / 2, y + 2);
+
+    // Keep the HUD's own cost out of the frame it is drawn in
+    uint32_t spent = cycles() - start;
+    frame_start += spent;
+    phase_mark += spent;
+}
+
+#endif
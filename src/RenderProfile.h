@@ -0,0 +1,69 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+// Per-frame render profiling, enabled with -DRENDER_PROFILE.  Without
+// it, the hooks below compile to nothing.
+//
+// A frame begins when a scheduled redraw starts, or, for a redraw made
+// directly by an input handler, at its first phase.  It ends when
+// refreshDisplay() has pushed it.  A phase that starts inside another
+// pauses the outer one, so each phase is charged only its own time.
+// Frame time outside every phase is the scene's own drawing.
+//
+// The last RENDER_PROFILE_FRAMES frames of each scene are kept for
+// min/avg/p99.  A touch hold on the top strip of the screen toggles a
+// HUD, and CTRL-P on the debug port dumps the statistics.
+
+enum render_phase_t {
+    RP_BACKGROUND,  // Scene::background()
+    RP_IMAGE,       // drawPngFile()
+    RP_TEXT,        // text() and auto_text()
+    RP_DIFF,        // Finding the dirty tiles in refreshDisplay()
+    RP_PUSH,        // Sending them to the panel
+    RP_NONE,
+};
+
+#ifdef RENDER_PROFILE
+
+#    ifndef RENDER_PROFILE_FRAMES
+#        define RENDER_PROFILE_FRAMES 100
+#    endif
+
+class RenderPhase {
+private:
+    render_phase_t _outer;
+
+public:
+    RenderPhase(render_phase_t phase);
+    ~RenderPhase();
+};
+
+#    define RENDER_PHASE(phase) RenderPhase _render_phase(phase)
+
+void render_frame_begin();
+void render_frame_end(const char* scene);
+
+// Draws the HUD on the canvas if it is on.  Called by refreshDisplay()
+// before the canvas is diffed.
+void render_profile_hud();
+
+// Returns true if a touch hold at x,y is the HUD gesture, and toggles it
+bool render_profile_gesture(int x, int y);
+
+void render_profile_dump();
+
+#else
+
+#    define RENDER_PHASE(phase)
+
+inline void render_frame_begin() {}
+inline void render_frame_end(const char* scene) {}
+inline void render_profile_hud() {}
+inline bool render_profile_gesture(int x, int y) {
+    return false;
+}
+inline void render_profile_dump() {}
+
+#endif
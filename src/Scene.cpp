@@ -3,6 +3,8 @@
 
 #include "Scene.h"
 #include "System.h"
+#include "RenderProfile.h"
+#include "EncoderStream.h"
 
 #ifndef ARDUINO
 #    include <sys/stat.h>
@@ -15,6 +17,8 @@ extern Scene statusScene;
 
 Scene* current_scene = nullptr;
 
+uint32_t encoder_event_us = 0;
+
 int touchX;
 int touchY;
 int touchDeltaX;
@@ -22,11 +26,14 @@ int touchDeltaY;
 
 std::vector<Scene*> scene_stack;
 
+uint32_t scene_activations = 0;
+
 void activate_scene(Scene* scene, void* arg) {
     if (current_scene) {
         current_scene->onExit();
     }
     current_scene = scene;
+    ++scene_activations;
     current_scene->onEntry(arg);
     current_scene->reDisplay();
 }
@@ -93,8 +100,12 @@ void dispatch_touch() {
         last_touch_state = t.state;
         touchX           = t.x - sprite_offset.x;
         touchY           = t.y - sprite_offset.y;
+        if (t.wasHold() && render_profile_gesture(t.x, t.y)) {
+            return;
+        }
         int delta;
         if (screen_encoder(t.x, t.y, delta) && t.state == m5::touch_state_t::touch) {
+            encoder_event_us = microseconds();
             current_scene->onEncoder(delta);
             return;
         }
@@ -150,15 +161,57 @@ void schedule_action(ActionHandler _action) {
     action = _action;
 }
 
+// Frame scheduler state
+static bool redisplay_pending = false;
+static int  last_frame_ms     = 0;
+
+uint32_t frames_rendered   = 0;
+uint32_t redraws_coalesced = 0;
+
+void schedule_redisplay() {
+    if (redisplay_pending) {
+        ++redraws_coalesced;
+    }
+    redisplay_pending = true;
+}
+
+void frame_rendered() {
+    // Any frame, whether scheduled or drawn directly by an input
+    // handler, shows the latest model state so it satisfies a
+    // pending request.
+    redisplay_pending = false;
+    last_frame_ms     = milliseconds();
+    ++frames_rendered;
+    render_frame_end(current_scene ? current_scene->name() : "");
+}
+
+static void render_scheduled_frame() {
+    if (!redisplay_pending || !current_scene) {
+        return;
+    }
+    if ((milliseconds() - last_frame_ms) < UPDATE_RATE_MS) {
+        return;
+    }
+    // Clear first in case the scene's reDisplay() does not reach refreshDisplay()
+    redisplay_pending = false;
+    render_frame_begin();
+    current_scene->reDisplay();
+}
+
 void dispatch_events() {
     update_events();
 
-    static int16_t oldEncoder   = 0;
-    int16_t        newEncoder   = get_encoder();
-    int16_t        encoderDelta = newEncoder - oldEncoder;
+#ifndef ARDUINO
+    // Host builds have no sampling task, so sample once per pass
+    encoder_sampler.sample(get_encoder(), microseconds());
+#endif
+    int             encoderDelta = 0;
+    encoder_event_t event;
+    while (encoder_sampler.read(event)) {
+        encoderDelta += event.delta;
+        encoder_event_us = event.us;
+    }
     if (encoderDelta) {
-        oldEncoder = newEncoder;
-
         int16_t scaledDelta = current_scene->scale_encoder(encoderDelta);
         if (scaledDelta && !ui_locked()) {
             current_scene->onEncoder(scaledDelta);
@@ -186,6 +239,11 @@ void dispatch_events() {
         action();
         action = nullptr;
     }
+
+    current_scene->onTick();
+
+    // Input events have been handled above, so deferred redraws go last
+    render_scheduled_frame();
 }
 
 static const char* setting_name(const char* base_name, int axis) {
@@ -234,17 +292,37 @@ bool Scene::initPrefs() {
         return false;  // Already open
     }
     _prefs = nvs_init(name());
+    if (_prefs) {
+        encoder_curve_t curve = _encoder_curve.get();
+        getPref("EncSlow", &curve.slow);
+        getPref("EncFast", &curve.fast);
+        getPref("EncGain", &curve.gain);
+        _encoder_curve.set(curve);
+    }
     return _prefs;
 }
 
+void Scene::saveEncoderCurve(const encoder_curve_t& curve) {
+    _encoder_curve.set(curve);
+    initPrefs();
+    setPref("EncSlow", curve.slow);
+    setPref("EncFast", curve.fast);
+    setPref("EncGain", curve.gain);
+}
+
 int Scene::scale_encoder(int delta) {
     _encoder_accum += delta;
     int res = _encoder_accum / _encoder_scale;
     _encoder_accum %= _encoder_scale;
-    return res;
+    if (res == 0) {
+        return 0;
+    }
+    return _encoder_curve.apply(res, encoder_event_us);
 }
 
 void Scene::background() {
+    RENDER_PHASE(RP_BACKGROUND);
+    forgetBackground();
     system_background();
 }
 
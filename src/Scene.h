@@ -6,6 +6,7 @@
 #include "GrblParserC.h"
 #include "Drawing.h"
 #include "NVS.h"
+#include "EncoderCurve.h"
 #include <vector>
 
 void pop_scene(void* arg = nullptr);
@@ -24,9 +25,15 @@ private:
     int _encoder_accum = 0;
     int _encoder_scale = 1;
 
+    EncoderCurve _encoder_curve;
+
 protected:
     const char** _help_text = nullptr;
 
+    // The scene's default speed curve for the encoder.  A curve saved
+    // in the scene's preferences replaces it when initPrefs() runs.
+    void setEncoderCurve(const encoder_curve_t& curve) { _encoder_curve.set(curve); }
+
 public:
     Scene(const char* name, int encoder_scale = 1, const char** help_text = nullptr) :
         _name(name), _help_text(help_text), _encoder_scale(encoder_scale) {}
@@ -56,6 +63,8 @@ public:
     virtual void onLimitsChange() {}
     virtual void onMessage(char* command, char* arguments) {}
     virtual void onEncoder(int delta) {}
+    // Called on every pass of the event loop, for scenes with timed work
+    virtual void onTick() {}
     virtual void reDisplay() {}
     virtual void onEntry(void* arg = nullptr) {}
     virtual void onExit() {}
@@ -67,6 +76,9 @@ public:
 
     int scale_encoder(int delta);
 
+    const encoder_curve_t& encoderCurve() { return _encoder_curve.get(); }
+    void                   saveEncoderCurve(const encoder_curve_t& curve);
+
     void setPref(const char* name, int value);
     void getPref(const char* name, int* value);
     void setPref(const char* name, int axis, int value);
@@ -84,6 +96,10 @@ void   activate_scene(Scene* scene, void* arg = nullptr);
 void   push_scene(Scene* scene, void* arg = nullptr);
 Scene* parent_scene();
 
+// Incremented by every scene change, so retained drawing can tell
+// when the canvas was last drawn by a different scene
+extern uint32_t scene_activations;
+
 // helper functions
 
 // Function to rotate through an aaray of numbers
@@ -109,6 +125,19 @@ void rotateNumberLoop(T& currentVal, T increment, T min, T max) {
 typedef void (*ActionHandler)(void);
 void schedule_action(ActionHandler action);
 
+// schedule_redisplay() marks the current scene as needing a redraw.
+// Model updates use it instead of calling reDisplay() directly so
+// that bursts of status reports, errors and setting replies coalesce
+// into at most one frame every UPDATE_RATE_MS.  Input handlers that
+// need immediate feedback can still call reDisplay() directly.
+void schedule_redisplay();
+
+// Called by refreshDisplay() whenever a frame reaches the panel
+void frame_rendered();
+
+extern uint32_t frames_rendered;    // Frames actually pushed to the panel
+extern uint32_t redraws_coalesced;  // Redraw requests absorbed by a pending frame
+
 extern Scene* current_scene;
 
 void dispatch_events();
@@ -2,6 +2,7 @@
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
 #include "Scene.h"
+#include "OverrideBurst.h"
 #include "transport/transport.h"
 
 extern Scene menuScene;
@@ -19,9 +20,34 @@ private:
 
     ovrd_display_t overd_display = FRO;
 
+    // The DROs change on nearly every report while the machine moves,
+    // so they are retained and everything else is redrawn only when
+    // something it shows has changed.
+    WidgetTree _widgets;
+    DROWidget  _dros[3] = { { 16, 68, 210, 32, 0 }, { 16, 101, 210, 32, 1 }, { 16, 134, 210, 32, 2 } };
+
+    uint32_t layout() {
+        WidgetKey key;
+        key.add(state).add(my_state_string).add(lastAlarm).add(mode_string()).add(overd_display);
+        if (state == Cycle || state == Hold) {
+            key.add(myPercent).add(myFro).add(mySro).add(myFeed).add(mySpeed);
+        }
+#ifdef USE_WIFI_PENDANT
+        key.add(transport && transport->isConnected());
+#endif
+        return key;
+    }
+
 public:
-    StatusScene() : Scene("Status") {}
+    StatusScene() : Scene("Status") {
+        for (auto& dro : _dros) {
+            _widgets.add(dro);
+        }
+        // A fast turn changes the override by up to 5% per detent
+        setEncoderCurve({ 8, 40, 5 });
+    }
 
+    void onEntry(void* arg) override { initPrefs(); }
     void onExit() override {}
 
     void onDialButtonPress() {
@@ -119,30 +145,26 @@ public:
         }
     }
 
+    // Changes an override by delta percent, in 10% steps where it can
+    void send_override(int delta, int percent, const override_cmds_t& cmds) {
+        if (!transport) {
+            return;
+        }
+        uint8_t burst[OVERRIDE_BURST_MAX];
+        size_t  n = override_burst(delta, percent, cmds, burst, sizeof(burst));
+        for (size_t i = 0; i < n; ++i) {
+            transport->sendRT(burst[i]);
+        }
+    }
+
     void onEncoder(int delta) {
         if (state == Cycle) {
             switch (overd_display) {
                 case FRO:
-                    if (delta > 0 && myFro < 200) {
-                        if (transport) {
-                            transport->sendRT(FeedOvrFinePlus);
-                        }
-                    } else if (delta < 0 && myFro > 10) {
-                        if (transport) {
-                            transport->sendRT(FeedOvrFineMinus);
-                        }
-                    }
+                    send_override(delta, myFro, { FeedOvrCoarsePlus, FeedOvrCoarseMinus, FeedOvrFinePlus, FeedOvrFineMinus });
                     break;
                 case SRO:
-                    if (delta > 0 && mySro < 200) {
-                        if (transport) {
-                            transport->sendRT(SpindleOvrFinePlus);
-                        }
-                    } else if (delta < 0 && mySro > 10) {
-                        if (transport) {
-                            transport->sendRT(SpindleOvrFineMinus);
-                        }
-                    }
+                    send_override(delta, mySro, { SpindleOvrCoarsePlus, SpindleOvrCoarseMinus, SpindleOvrFinePlus, SpindleOvrFineMinus });
                     break;
                 case RT_FEED_SPEED:
                     overd_display = FRO;
@@ -152,10 +174,18 @@ public:
         }
     }
 
-    void onDROChange() { reDisplay(); }
+    void onDROChange() { schedule_redisplay(); }
     void onLimitsChange() { reDisplay(); }
 
     void reDisplay() {
+        if (_widgets.retained(layout())) {
+            for (auto& dro : _dros) {
+                dro.draw(-1, true);
+            }
+            refreshDisplay();
+            return;
+        }
+
         background();
         drawMenuTitle(current_scene->name());
         drawStatus();
@@ -165,10 +195,9 @@ public:
         drawConnectionStatus(220, 15);
 #endif
 
-        DRO dro(16, 68, 210, 32);
-        dro.draw(0, -1, true);
-        dro.draw(1, -1, true);
-        dro.draw(2, -1, true);
+        for (auto& dro : _dros) {
+            dro.draw(-1, true);
+        }
 
         int y = 170;
         if (state == Cycle || state == Hold) {
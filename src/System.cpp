@@ -3,6 +3,7 @@
 
 #include "System.h"
 #include "FluidNCModel.h"
+#include <cstdarg>
 
 #if 0
 // Helpful for debugging touch development.
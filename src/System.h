@@ -9,11 +9,12 @@
 #ifdef ARDUINO
 #    include <Arduino.h>
 #    include <LittleFS.h>
-constexpr static const int UPDATE_RATE_MS = 30;  // minimum refresh rate in milliseconds
-extern Stream&             debugPort;
-void                       init_fnc_uart(int uart_num, int tx_pin, int rx_pin);
+extern Stream& debugPort;
+void           init_fnc_uart(int uart_num, int tx_pin, int rx_pin);
 #endif  // ARDUINO
 
+constexpr static const int UPDATE_RATE_MS = 30;  // minimum refresh rate in milliseconds
+
 #ifdef USE_LOVYANGFX
 #    include "LovyanGFX.h"
 #    include "Touch_Class.hpp"
@@ -41,8 +42,13 @@ extern LGFX_Device&     display;
 extern LGFX_Sprite      canvas;
 extern m5::Touch_Class& touch;
 
+// drawPngFile() draws through the decoded image cache in ImageCache.cpp.
+// decodePngFile() is the platform-specific decoder that reads the file
+// every time; pngFileSize() reads the dimensions from the PNG header.
 void drawPngFile(const char* filename, int x, int y);
 void drawPngFile(LGFX_Sprite* sprite, const char* filename, int x, int y);
+void decodePngFile(LGFX_Sprite* sprite, const char* filename, int x, int y);
+bool pngFileSize(const char* filename, int& width, int& height);
 
 void init_system();
 
@@ -60,8 +66,9 @@ void dbg_print(const std::string& s);
 void dbg_println(const std::string& s);
 void dbg_printf(const char* format, ...);
 
-void update_events();
-void delay_ms(uint32_t ms);
+void     update_events();
+void     delay_ms(uint32_t ms);
+uint32_t microseconds();
 
 void resetFlowControl();
 
@@ -6,7 +6,15 @@
 #include "System.h"
 #include "FluidNCModel.h"
 #include "NVS.h"
+#include "Assets.h"
 #include "transport/transport.h"
+#include "transport/comms_task.h"
+#include "transport/line_framer.h"
+#include "RenderProfile.h"
+#include "LoopTiming.h"
+#ifdef FNC_CAPTURE
+#include "transport/capture.h"
+#endif
 #ifdef USE_WIFI_PENDANT
 #include "transport/wifi_transport_factory.h"
 #include "transport/transport_config.h"
@@ -19,7 +27,37 @@
 #include <driver/uart.h>
 #include "hal/uart_hal.h"
 
-uart_port_t fnc_uart_port;
+uart_port_t          fnc_uart_port;
+static QueueHandle_t fnc_uart_events = nullptr;
+
+// Driver receive buffer.  256 bytes is only 2.5 ms at 1 Mbaud.
+#ifndef FNC_UART_RX_BUFFER
+#    define FNC_UART_RX_BUFFER 8192
+#endif
+
+// Driver events, mostly one per received line
+#ifndef FNC_UART_EVENT_QUEUE
+#    define FNC_UART_EVENT_QUEUE 32
+#endif
+
+uint32_t uart_tx_bytes     = 0;
+uint32_t uart_tx_calls     = 0;
+uint32_t uart_rx_events    = 0;
+uint32_t uart_rx_overflows = 0;
+
+// Every write to the FluidNC UART goes through here, from one task: the
+// comms task when it runs the UART, otherwise the UI task.  The counters
+// therefore have a single writer.
+static void uart_write(const uint8_t* buf, size_t len) {
+    uart_write_bytes(fnc_uart_port, (const char*)buf, len);
+    uart_tx_bytes += len;
+    ++uart_tx_calls;
+#ifdef ECHO_FNC_TO_DEBUG
+    for (size_t i = 0; i < len; i++) {
+        dbg_write(buf[i]);
+    }
+#endif
+}
 
 // Transport implementation
 // Serial transport implementation for UART communication
@@ -27,6 +65,10 @@ class SerialTransport : public Transport {
 private:
     bool _initialized = false;
 
+    // Lines are assembled here with their terminator so that each one
+    // is a single call into the UART driver
+    char _line[256];
+
 public:
     bool begin() override {
         _initialized = true;
@@ -43,14 +85,18 @@ public:
     
     void sendLine(const char* line, int timeout = 2000) override {
         if (!line) return;
-        
-        const char* p = line;
-        while (*p) {
-            putChar(*p);
-            p++;
+
+        size_t len = strlen(line);
+        if (len + 2 <= sizeof(_line)) {
+            memcpy(_line, line, len);
+            _line[len++] = '\r';
+            _line[len++] = '\n';
+            write((const uint8_t*)_line, len);
+        } else {
+            write((const uint8_t*)line, len);
+            write((const uint8_t*)"\r\n", 2);
         }
-        putChar('\r');
-        putChar('\n');
+        _linesSent.fetch_add(1, std::memory_order_release);
     }
     
     void sendRT(uint8_t c) override {
@@ -58,26 +104,96 @@ public:
     }
     
     int getChar() override {
-        return fnc_getchar();
+        uint8_t c;
+        return read(&c, 1) ? c : -1;
+    }
+
+    size_t read(uint8_t* buf, size_t max) override {
+        int res = uart_read_bytes(fnc_uart_port, buf, max, 0);
+        return res > 0 ? res : 0;
+    }
+
+    // The driver posts an event when the FIFO fills, when the line goes
+    // idle, and, with pattern detection, at every '\n', so the comms
+    // task wakes as soon as a line is complete.  The data itself is
+    // taken in bulk by read(), which also retires the driver's pattern
+    // positions.
+    bool waitForData(int timeout_ms) override {
+        if (!fnc_uart_events) {
+            return false;
+        }
+        uart_event_t event;
+        if (xQueueReceive(fnc_uart_events, &event, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+            return true;
+        }
+        ++uart_rx_events;
+        // UART_BUFFER_FULL needs nothing; the driver leaves the bytes in
+        // the FIFO until read() makes room, and XOFF holds FluidNC
+        if (event.type == UART_FIFO_OVF) {
+            ++uart_rx_overflows;  // Bytes were lost before XOFF took effect
+        }
+        return true;
     }
     
     void putChar(uint8_t c) override {
-        fnc_putchar(c);
+        uart_write(&c, 1);
+    }
+
+    void write(const uint8_t* buf, size_t len) override {
+        uart_write(buf, len);
     }
     
     void resetFlowControl() override {
-        fnc_putchar(0x11);
+        putChar(0x11);
         uart_ll_force_xon(fnc_uart_port);
     }
 };
 
+#ifdef FNC_CAPTURE
+// Build with -DFNC_CAPTURE to record the FluidNC traffic to /capture.cap
+// in LittleFS, for replay on a host with ReplayTransport.  Each new
+// connection starts a new capture.
+class LittleFSCaptureOutput : public CaptureOutput {
+private:
+    File   _file;
+    size_t _unflushed = 0;
+
+public:
+    LittleFSCaptureOutput(File file) : _file(file) {}
+    ~LittleFSCaptureOutput() { _file.close(); }
+    void write(const char* s, size_t len) override {
+        _file.write((const uint8_t*)s, len);
+        _unflushed += len;
+    }
+    // Called every loop, so only commit to flash once a block is ready
+    void flush() override {
+        if (_unflushed >= 4096) {
+            _file.flush();
+            _unflushed = 0;
+        }
+    }
+};
+
+static Transport* capture_transport(Transport* io, bool owns_io) {
+    File file = LittleFS.open("/capture.cap", "w");
+    if (!file) {
+        dbg_println("Cannot open /capture.cap");
+        return io;
+    }
+    dbg_println("Capturing FluidNC traffic to /capture.cap");
+    return new CaptureTransport(io, owns_io, new LittleFSCaptureOutput(file), microseconds);
+}
+#endif
+
 // Global transport instance
 #ifdef USE_WIFI_PENDANT
 static SerialTransport serialTransport; // Fallback for WiFi builds
 Transport* transport = nullptr; // Will be created dynamically for WiFi transports
 #else
+// The UART is serviced by its own task so rendering never stalls it
 static SerialTransport serialTransport;
-Transport* transport = &serialTransport;
+static CommsTask commsTask(serialTransport);
+Transport* transport = &commsTask;
 #endif
 
 // Transport factory implementation
@@ -92,7 +208,7 @@ Transport* TransportFactory::createTransport() {
         (type == TransportConfig::TELNET) ? WiFiTransportFactory::TELNET : WiFiTransportFactory::WEBSOCKET,
         host, port);
 #else
-    return &serialTransport;
+    return &commsTask;
 #endif
 }
 
@@ -113,6 +229,9 @@ void selectTransport() {
             if (transport && transport != &serialTransport) {
                 delete transport; // Clean up old transport if it's not the serial fallback
             }
+#ifdef FNC_CAPTURE
+            wifiTransport = capture_transport(wifiTransport, true);
+#endif
             transport = wifiTransport;
             dbg_printf("Transport: Using WiFi transport\n");
             return;
@@ -142,11 +261,12 @@ void selectTransport() {
 // flow control.  The ESP-IDF driver supports the ESP32's
 // hardware implementation of XON/XOFF, but Arduino does not.
 
+// GrblParser sends realtime commands such as Reset, FeedHold and
+// CycleStart one byte at a time through here.  They go to the
+// transport's realtime path, which is the urgent lane when the comms
+// task runs the UART, and the network connection on WiFi builds.
 extern "C" void fnc_putchar(uint8_t c) {
-    uart_write_bytes(fnc_uart_port, (const char*)&c, 1);
-#ifdef ECHO_FNC_TO_DEBUG
-    dbg_write(c);
-#endif
+    (transport ? transport : &serialTransport)->sendRT(c);
 }
 
 void ledcolor(int n) {
@@ -154,24 +274,55 @@ void ledcolor(int n) {
     digitalWrite(16, !(n & 2));
     digitalWrite(17, !(n & 4));
 }
+
+// A line that stops arriving without its terminator is handed to the
+// parser after this long
+#ifndef FNC_PARTIAL_LINE_MS
+#    define FNC_PARTIAL_LINE_MS 50
+#endif
+
+// The parser takes one byte per call.  Received data is read from the
+// transport in blocks straight into the framer, which releases it one
+// complete line at a time, so the RX time is noted once per line.
+static LineFramer rx_framer;
+static int        rx_last_ms = 0;
+
+static bool fill_rx_framer() {
+    Transport* source = transport ? transport : &serialTransport;
+    size_t     room;
+    uint8_t*   dst = rx_framer.reserve(room);
+    size_t     len = room ? source->read(dst, room) : 0;
+    if (len) {
+        rx_last_ms = milliseconds();
+        rx_framer.commit(len);
+    } else if (rx_framer.partial() && (milliseconds() - rx_last_ms) >= FNC_PARTIAL_LINE_MS) {
+        rx_framer.release_partial();
+    }
+    return rx_framer.ready();
+}
+
 extern "C" int fnc_getchar() {
-    char c;
-    int  res = uart_read_bytes(fnc_uart_port, &c, 1, 0);
-    if (res == 1) {
-#ifdef LED_DEBUG
-        if (c == '\r' || c == '\n') {
-            ledcolor(0);
-        } else {
-            ledcolor(c & 7);
+    int c = rx_framer.getChar();
+    if (c < 0) {
+        if (!fill_rx_framer()) {
+            return -1;
         }
-#endif
+        c = rx_framer.getChar();
+    }
+    if (c == '\n') {
         update_rx_time();
+    }
+#ifdef LED_DEBUG
+    if (c == '\r' || c == '\n') {
+        ledcolor(0);
+    } else {
+        ledcolor(c & 7);
+    }
+#endif
 #ifdef ECHO_FNC_TO_DEBUG
-        dbg_write(c);
+    dbg_write(c);
 #endif
-        return c;
-    }
-    return -1;
+    return c;
 }
 
 extern "C" void poll_extra() {
@@ -182,21 +333,73 @@ extern "C" void poll_extra() {
             ESP.restart();
             while (1) {}
         }
-        fnc_putchar(c);  // So you can type commands to FluidNC
+        if (c == 0x14) {  // CTRL-T
+            loop_timer.dump(dbg_print);
+            return;
+        }
+#ifdef RENDER_PROFILE
+        if (c == 0x10) {  // CTRL-P
+            render_profile_dump();
+            return;
+        }
+#endif
+        // So you can type commands to FluidNC
+        (transport ? transport : &serialTransport)->putChar(c);
     }
 #endif
 }
 
-void drawPngFile(const char* filename, int x, int y) {
-    drawPngFile(&canvas, filename, x, y);
-}
-void drawPngFile(LGFX_Sprite* sprite, const char* filename, int x, int y) {
+void decodePngFile(LGFX_Sprite* sprite, const char* filename, int x, int y) {
     // When datum is middle_center, the origin is the center of the canvas and the
     // +Y direction is down.
     std::string fn { "/" };
     fn += filename;
     sprite->drawPngFile(LittleFS, fn.c_str(), x, -y, 0, 0, 0, 0, 1.0f, 1.0f, datum_t::middle_center);
 }
+bool pngFileSize(const char* filename, int& width, int& height) {
+    std::string fn { "/" };
+    fn += filename;
+    File file = LittleFS.open(fn.c_str(), "r");
+    if (!file) {
+        return false;
+    }
+    // The IHDR chunk with the big-endian width and height always comes first
+    uint8_t header[24];
+    bool    ok = file.read(header, sizeof(header)) == sizeof(header);
+    file.close();
+    if (!ok) {
+        return false;
+    }
+    width  = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+    height = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+    return true;
+}
+
+class LittleFSAssetReader : public AssetReader {
+private:
+    File _file;
+
+public:
+    LittleFSAssetReader(File file) : _file(file) {}
+    ~LittleFSAssetReader() { _file.close(); }
+    bool   seek(size_t pos) override { return _file.seek(pos); }
+    size_t read(uint8_t* buf, size_t len) override { return _file.read(buf, len); }
+    size_t size() override { return _file.size(); }
+};
+
+AssetReader* openAssetFile(const char* filename) {
+    std::string fn { "/" };
+    fn += filename;
+    // Check first because opening a missing file logs an error
+    if (!LittleFS.exists(fn.c_str())) {
+        return nullptr;
+    }
+    File file = LittleFS.open(fn.c_str(), "r");
+    if (!file) {
+        return nullptr;
+    }
+    return new LittleFSAssetReader(file);
+}
 
 #define FORMAT_LITTLEFS_IF_FAILED true
 
@@ -232,7 +435,11 @@ void init_fnc_uart(int uart_num, int tx_pin, int rx_pin) {
         while (1) {}
         return;
     };
-    uart_driver_install(fnc_uart_port, 256, 0, 0, NULL, ESP_INTR_FLAG_IRAM);
+    uart_driver_install(fnc_uart_port, FNC_UART_RX_BUFFER, 0, FNC_UART_EVENT_QUEUE, &fnc_uart_events, ESP_INTR_FLAG_IRAM);
+    // Post an event at each line terminator.  The driver keeps the
+    // positions in a queue that read() retires as it consumes the data.
+    uart_enable_pattern_det_baud_intr(fnc_uart_port, '\n', 1, 9, 0, 0);
+    uart_pattern_queue_reset(fnc_uart_port, FNC_UART_EVENT_QUEUE);
     uart_set_sw_flow_ctrl(fnc_uart_port, true, 64, 120);
     uint32_t baud;
     uart_get_baudrate(fnc_uart_port, &baud);
@@ -252,6 +459,9 @@ void init_system() {
 #else
     // Initialize transport layer for non-WiFi builds
     if (transport) {
+#ifdef FNC_CAPTURE
+        transport = capture_transport(transport, false);
+#endif
         transport->begin();
     }
 #endif
@@ -281,6 +491,10 @@ extern "C" int milliseconds() {
     return millis();
 }
 
+uint32_t microseconds() {
+    return micros();
+}
+
 void delay_ms(uint32_t ms) {
     delay(ms);
 }
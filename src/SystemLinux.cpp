@@ -0,0 +1,631 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// System interface routines for a headless Linux host.  The panel is a
+// block of memory, input is injected by linuxmain.cpp, and FluidNC is
+// reached over a tty, a pty, TCP, or a capture replay.
+
+#include "System.h"
+#include "SystemLinux.h"
+#include "FluidNCModel.h"
+#include "Drawing.h"
+#include "NVS.h"
+#include "Assets.h"
+#include "transport/transport.h"
+#include "transport/line_framer.h"
+
+#include <lgfx/v1/panel/Panel_FrameBufferBase.hpp>
+
+#include <deque>
+#include <vector>
+#include <string>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// Panel_FrameBufferBase does all the drawing; this only gives it
+// the memory to draw into
+class Panel_Headless : public lgfx::Panel_FrameBufferBase {
+private:
+    std::vector<uint16_t> _frame;
+    std::vector<uint8_t*> _lines;
+
+public:
+    bool init(bool use_reset) override {
+        int w = _cfg.memory_width;
+        int h = _cfg.memory_height;
+        _frame.assign(w * h, 0);
+        _lines.resize(h);
+        for (int y = 0; y < h; ++y) {
+            _lines[y] = (uint8_t*)&_frame[y * w];
+        }
+        _lines_buffer = _lines.data();
+        return Panel_FrameBufferBase::init(use_reset);
+    }
+};
+
+// Reports the injected touch point as a single raw contact
+class Touch_Injected : public lgfx::ITouch {
+public:
+    bool    down = false;
+    int16_t x    = 0;
+    int16_t y    = 0;
+
+    bool init() override { return true; }
+    void wakeup() override {}
+    void sleep() override {}
+
+    uint_fast8_t getTouchRaw(lgfx::touch_point_t* tp, uint_fast8_t count) override {
+        if (!down || !count) {
+            return 0;
+        }
+        tp[0].x    = x;
+        tp[0].y    = y;
+        tp[0].size = 1;
+        tp[0].id   = 0;
+        return 1;
+    }
+};
+
+// Same geometry as the M5Dial
+static const int panel_size = 240;
+
+class LGFX_Headless : public lgfx::LGFX_Device {
+public:
+    Panel_Headless panel;
+    Touch_Injected injected;
+
+    LGFX_Headless() {
+        auto cfg          = panel.config();
+        cfg.memory_width  = panel_size;
+        cfg.memory_height = panel_size;
+        cfg.panel_width   = panel_size;
+        cfg.panel_height  = panel_size;
+        panel.config(cfg);
+
+        auto tcfg  = injected.config();
+        tcfg.x_min = 0;
+        tcfg.x_max = panel_size - 1;
+        tcfg.y_min = 0;
+        tcfg.y_max = panel_size - 1;
+        injected.config(tcfg);
+
+        panel.setTouch(&injected);
+        setPanel(&panel);
+    }
+};
+
+static LGFX_Headless xdisplay;
+LGFX_Device&         display = xdisplay;
+LGFX_Sprite          canvas(&xdisplay);
+
+m5::Touch_Class  xtouch;
+m5::Touch_Class& touch = xtouch;
+
+bool round_display = true;
+
+const int panel_bytes_per_pixel = 2;  // RGB565
+
+bool skip_delays = false;
+
+uint32_t uart_tx_bytes     = 0;
+uint32_t uart_tx_calls     = 0;
+uint32_t uart_rx_events    = 0;
+uint32_t uart_rx_overflows = 0;
+
+// A tty, pty or socket.  The descriptor is non-blocking; writes wait
+// for room so that nothing the pendant sends is dropped.
+class PosixTransport : public Transport {
+private:
+    int _fd;
+
+    char _line[256];
+
+public:
+    PosixTransport(int fd) : _fd(fd) {}
+    ~PosixTransport() {
+        if (_fd >= 0) {
+            close(_fd);
+        }
+    }
+
+    bool begin() override { return _fd >= 0; }
+    void loop() override {}
+    bool isConnected() override { return _fd >= 0; }
+
+    void sendLine(const char* line, int timeout = 2000) override {
+        if (!line) {
+            return;
+        }
+        size_t len = strlen(line);
+        if (len + 2 <= sizeof(_line)) {
+            memcpy(_line, line, len);
+            _line[len++] = '\r';
+            _line[len++] = '\n';
+            write((const uint8_t*)_line, len);
+        } else {
+            write((const uint8_t*)line, len);
+            write((const uint8_t*)"\r\n", 2);
+        }
+        _linesSent.fetch_add(1, std::memory_order_release);
+    }
+
+    void sendRT(uint8_t c) override { putChar(c); }
+
+    int getChar() override {
+        uint8_t c;
+        return read(&c, 1) ? c : -1;
+    }
+
+    size_t read(uint8_t* buf, size_t max) override {
+        if (_fd < 0) {
+            return 0;
+        }
+        ssize_t res = ::read(_fd, buf, max);
+        if (res > 0) {
+            ++uart_rx_events;
+            return res;
+        }
+        if (res == 0 || (errno != EAGAIN && errno != EINTR)) {
+            dbg_printf("FluidNC connection closed\n");
+            close(_fd);
+            _fd = -1;
+        }
+        return 0;
+    }
+
+    bool waitForData(int timeout_ms) override {
+        if (_fd < 0) {
+            return false;
+        }
+        struct pollfd pfd = { _fd, POLLIN, 0 };
+        poll(&pfd, 1, timeout_ms);
+        return true;
+    }
+
+    void putChar(uint8_t c) override { write(&c, 1); }
+
+    void write(const uint8_t* buf, size_t len) override {
+        ++uart_tx_calls;
+        while (len && _fd >= 0) {
+            ssize_t res = ::write(_fd, buf, len);
+            if (res > 0) {
+                buf += res;
+                len -= res;
+                uart_tx_bytes += res;
+            } else if (errno == EAGAIN) {
+                struct pollfd pfd = { _fd, POLLOUT, 0 };
+                poll(&pfd, 1, 100);
+            } else if (errno != EINTR) {
+                break;
+            }
+        }
+    }
+
+    void resetFlowControl() override { putChar(0x11); }
+};
+
+static speed_t baud_constant(int baud) {
+    switch (baud) {
+        case 9600:
+            return B9600;
+        case 19200:
+            return B19200;
+        case 38400:
+            return B38400;
+        case 57600:
+            return B57600;
+        case 230400:
+            return B230400;
+        case 460800:
+            return B460800;
+        case 921600:
+            return B921600;
+        case 1000000:
+            return B1000000;
+        default:
+            return B115200;
+    }
+}
+
+Transport* open_serial_transport(const char* path, int baud) {
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        dbg_printf("Can't open %s: %s\n", path, strerror(errno));
+        return nullptr;
+    }
+    // A pty accepts the same settings, and needs raw mode just as much
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, baud_constant(baud));
+        tio.c_cflag |= CLOCAL | CREAD;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    return new PosixTransport(fd);
+}
+
+Transport* open_tcp_transport(const char* hostport) {
+    std::string host(hostport);
+    std::string port("23");
+    size_t      colon = host.rfind(':');
+    if (colon != std::string::npos) {
+        port = host.substr(colon + 1);
+        host.resize(colon);
+    }
+
+    struct addrinfo hints = {};
+    hints.ai_family       = AF_UNSPEC;
+    hints.ai_socktype     = SOCK_STREAM;
+    struct addrinfo* res;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0) {
+        dbg_printf("Can't resolve %s\n", host.c_str());
+        return nullptr;
+    }
+    int fd = -1;
+    for (struct addrinfo* ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0) {
+        dbg_printf("Can't connect to %s\n", hostport);
+        return nullptr;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return new PosixTransport(fd);
+}
+
+Transport* transport = nullptr;
+
+Transport* TransportFactory::createTransport() {
+    return transport;
+}
+
+// A line that stops arriving without its terminator is handed to the
+// parser after this long
+#ifndef FNC_PARTIAL_LINE_MS
+#    define FNC_PARTIAL_LINE_MS 50
+#endif
+
+// Input is framed as on the hardware, so the parser sees the same
+// whole-line delivery
+static LineFramer rx_framer;
+static int        rx_last_ms = 0;
+
+void set_fnc_transport(Transport* t) {
+    transport = t;
+    rx_framer.clear();
+    if (transport) {
+        transport->begin();
+    }
+}
+
+static bool fill_rx_framer() {
+    if (!transport) {
+        return false;
+    }
+    size_t   room;
+    uint8_t* dst = rx_framer.reserve(room);
+    size_t   len = room ? transport->read(dst, room) : 0;
+    if (len) {
+        rx_last_ms = milliseconds();
+        rx_framer.commit(len);
+    } else if (rx_framer.partial() && (milliseconds() - rx_last_ms) >= FNC_PARTIAL_LINE_MS) {
+        rx_framer.release_partial();
+    }
+    return rx_framer.ready();
+}
+
+extern "C" int fnc_getchar() {
+    int c = rx_framer.getChar();
+    if (c < 0) {
+        if (!fill_rx_framer()) {
+            return -1;
+        }
+        c = rx_framer.getChar();
+    }
+    if (c == '\n') {
+        update_rx_time();
+    }
+#ifdef ECHO_FNC_TO_DEBUG
+    dbg_write(c);
+#endif
+    return c;
+}
+
+extern "C" void fnc_putchar(uint8_t c) {
+    if (transport) {
+        transport->sendRT(c);
+    }
+}
+
+extern "C" void poll_extra() {}
+
+void resetFlowControl() {
+    if (transport) {
+        transport->resetFlowControl();
+    }
+}
+
+void init_system() {
+    display.init();
+    touch.begin(&display);
+    touch.setFlickThresh(10);
+
+    // Make an offscreen canvas that can be copied to the screen all at once
+    canvas.setColorDepth(8);
+    canvas.createSprite(display.width(), display.height());
+}
+
+Point sprite_offset { 0, 0 };
+
+void show_logo() {
+    drawPanelAsset(&display, "fluid_dial.png", display.width() / 2, display.height() / 2);
+}
+
+void base_display() {
+    display.clear();
+    invalidateDisplay();
+}
+
+void next_layout(int delta) {}
+void set_layout(int n) {}
+
+void system_background() {
+    canvas.fillSprite(TFT_BLACK);
+}
+
+// Both count from program start, as millis() and micros() count from
+// boot on the ESP32
+static struct timespec start_time = [] {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts;
+}();
+
+static int64_t elapsed_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)(ts.tv_sec - start_time.tv_sec) * 1000000 + (ts.tv_nsec - start_time.tv_nsec) / 1000;
+}
+
+extern "C" int milliseconds() {
+    return elapsed_us() / 1000;
+}
+
+uint32_t microseconds() {
+    return elapsed_us();
+}
+
+void delay_ms(uint32_t ms) {
+    if (!skip_delays) {
+        usleep(ms * 1000);
+    }
+}
+
+// Debug output goes to stderr so that benchmark reports on stdout
+// can be piped cleanly
+void dbg_write(uint8_t c) {
+    fputc(c, stderr);
+}
+
+void dbg_print(const char* s) {
+    fputs(s, stderr);
+}
+
+// Injected input
+
+static int16_t encoder_count = 0;
+
+struct ButtonEvent {
+    int  button;
+    bool pressed;
+};
+static std::deque<ButtonEvent> button_events;
+
+void inject_encoder(int delta) {
+    encoder_count += delta;
+}
+
+void inject_button(int button, bool pressed) {
+    button_events.push_back({ button, pressed });
+}
+
+void inject_touch(int x, int y) {
+    xdisplay.injected.down = true;
+    xdisplay.injected.x    = x;
+    xdisplay.injected.y    = y;
+}
+
+void inject_untouch() {
+    xdisplay.injected.down = false;
+}
+
+void update_events() {
+    touch.update(milliseconds());
+}
+
+int16_t get_encoder() {
+    return encoder_count;
+}
+
+// The dial and buttons are real (injected) inputs, as on the M5Dial,
+// so the screen has no touch areas standing in for them
+bool screen_encoder(int x, int y, int& delta) {
+    return false;
+}
+
+bool screen_button_touched(bool pressed, int x, int y, int& button) {
+    return false;
+}
+
+bool switch_button_touched(bool& pressed, int& button) {
+    if (button_events.empty()) {
+        return false;
+    }
+    button  = button_events.front().button;
+    pressed = button_events.front().pressed;
+    button_events.pop_front();
+    return true;
+}
+
+void ackBeep() {}
+
+void deep_sleep(int us) {}
+
+bool ui_locked() {
+    return false;
+}
+
+bool dump_display(const char* filename) {
+    FILE* fd = fopen(filename, "wb");
+    if (!fd) {
+        return false;
+    }
+    int w = display.width();
+    int h = display.height();
+    fprintf(fd, "P6\n%d %d\n255\n", w, h);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            auto rgb = display.readPixelRGB(x, y);
+            fputc(rgb.R8(), fd);
+            fputc(rgb.G8(), fd);
+            fputc(rgb.B8(), fd);
+        }
+    }
+    fclose(fd);
+    return true;
+}
+
+size_t heap_used() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return mallinfo2().uordblks;
+#else
+    return mallinfo().uordblks;
+#endif
+}
+
+// Images come from the data/ directory that is uploaded to the
+// LittleFS partition on the hardware, so run from the project root
+
+void decodePngFile(LGFX_Sprite* sprite, const char* filename, int x, int y) {
+    std::string fn("data/");
+    fn += filename;
+    // When datum is middle_center, the origin is the center of the canvas and the
+    // +Y direction is down.
+    sprite->drawPngFile(fn.c_str(), x, -y, 0, 0, 0, 0, 1.0f, 1.0f, datum_t::middle_center);
+}
+
+bool pngFileSize(const char* filename, int& width, int& height) {
+    std::string fn("data/");
+    fn += filename;
+    FILE* fd = fopen(fn.c_str(), "rb");
+    if (!fd) {
+        return false;
+    }
+    // The IHDR chunk with the big-endian width and height always comes first
+    uint8_t header[24];
+    bool    ok = fread(header, 1, sizeof(header), fd) == sizeof(header);
+    fclose(fd);
+    if (!ok) {
+        return false;
+    }
+    width  = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+    height = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+    return true;
+}
+
+class StdioAssetReader : public AssetReader {
+private:
+    FILE* _fd;
+
+public:
+    StdioAssetReader(FILE* fd) : _fd(fd) {}
+    ~StdioAssetReader() { fclose(_fd); }
+    bool   seek(size_t pos) override { return fseek(_fd, pos, SEEK_SET) == 0; }
+    size_t read(uint8_t* buf, size_t len) override { return fread(buf, 1, len, _fd); }
+    size_t size() override {
+        long pos = ftell(_fd);
+        fseek(_fd, 0, SEEK_END);
+        long len = ftell(_fd);
+        fseek(_fd, pos, SEEK_SET);
+        return len;
+    }
+};
+
+AssetReader* openAssetFile(const char* filename) {
+    std::string fn("data/");
+    fn += filename;
+    FILE* fd = fopen(fn.c_str(), "rb");
+    return fd ? new StdioAssetReader(fd) : nullptr;
+}
+
+// Preferences are files under prefs/<namespace>/, as on Windows
+
+static FILE* prefFile(const char* handle, const char* pname, const char* mode) {
+    static char fname[100];
+    snprintf(fname, sizeof(fname), "%s/%s", handle, pname);
+
+    return fopen(fname, mode);
+}
+
+void nvs_get_str(nvs_handle_t handle, const char* name, char* value, size_t* len) {
+    FILE* fd = prefFile(handle, name, "rb");
+    if (fd) {
+        *len = fread(value, 1, *len - 1, fd);
+        fclose(fd);
+    } else {
+        *len = 0;
+    }
+    value[*len] = '\0';
+}
+void nvs_set_str(nvs_handle_t handle, const char* name, const char* value) {
+    FILE* fd = prefFile(handle, name, "wb");
+    if (fd) {
+        fwrite(value, 1, strlen(value), fd);
+        fclose(fd);
+    }
+}
+
+void nvs_get_i32(nvs_handle_t handle, const char* name, int32_t* value) {
+    char   strval[20];
+    size_t len = 20;
+    nvs_get_str(handle, name, strval, &len);
+    if (*strval) {
+        *value = atoi(strval);
+    }
+}
+void nvs_set_i32(nvs_handle_t handle, const char* name, int32_t value) {
+    char valstr[20];
+    snprintf(valstr, 20, "%d", value);
+    nvs_set_str(handle, name, valstr);
+}
+
+nvs_handle_t nvs_init(const char* name) {
+    char dname[50];
+    mkdir("prefs", 0777);
+    snprintf(dname, 50, "prefs/%s", name);
+    mkdir(dname, 0777);
+
+    return strdup(dname);
+}
@@ -0,0 +1,40 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Hooks into the headless Linux system layer, for linuxmain.cpp
+
+#pragma once
+
+#include "transport/transport.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Connections to FluidNC.  open_serial_transport() takes a tty or the
+// pty that tools/fluidnc_sim.py --pty prints; open_tcp_transport()
+// takes host:port.  Both return nullptr on failure.
+Transport* open_serial_transport(const char* path, int baud);
+Transport* open_tcp_transport(const char* hostport);
+
+// Makes t the FluidNC connection, discarding any buffered input
+void set_fnc_transport(Transport* t);
+
+// Injected input.  The buttons are 0 red, 1 dial, 2 green, as for
+// switch_button_touched().  Events take effect at the next
+// update_events().
+void inject_encoder(int delta);
+void inject_button(int button, bool pressed);
+void inject_touch(int x, int y);
+void inject_untouch();
+
+// When set, delay_ms() returns at once, so setup() does not wait
+// out the logo during benchmarks
+extern bool skip_delays;
+
+// Bytes per pixel of the headless panel, for counting bytes pushed
+extern const int panel_bytes_per_pixel;
+
+// Writes what the panel shows as a binary PPM file
+bool dump_display(const char* filename);
+
+// Bytes currently allocated from the heap
+size_t heap_used();
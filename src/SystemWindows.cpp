@@ -12,6 +12,7 @@
 #include "M5GFX.h"
 #include "Drawing.h"
 #include "NVS.h"
+#include "Assets.h"
 
 #include <windows.h>
 #include <commctrl.h>
@@ -41,20 +42,64 @@ extern "C" int milliseconds() {
     return m5gfx::millis();
 }
 
+uint32_t microseconds() {
+    return m5gfx::micros();
+}
+
 void delay_ms(uint32_t ms) {
     SDL_Delay(ms);
 }
 
-void drawPngFile(const char* filename, int x, int y) {
-    drawPngFile(&canvas, filename, x, y);
-}
-void drawPngFile(LGFX_Sprite* sprite, const char* filename, int x, int y) {
+void decodePngFile(LGFX_Sprite* sprite, const char* filename, int x, int y) {
     std::string fn("data/");
     fn += filename;
     // When datum is middle_center, the origin is the center of the canvas and the
     // +Y direction is down.
     sprite->drawPngFile(fn.c_str(), x, -y, 0, 0, 0, 0, 1.0f, 1.0f, datum_t::middle_center);
 }
+bool pngFileSize(const char* filename, int& width, int& height) {
+    std::string fn("data/");
+    fn += filename;
+    FILE* fd = fopen(fn.c_str(), "rb");
+    if (!fd) {
+        return false;
+    }
+    // The IHDR chunk with the big-endian width and height always comes first
+    uint8_t header[24];
+    bool    ok = fread(header, 1, sizeof(header), fd) == sizeof(header);
+    fclose(fd);
+    if (!ok) {
+        return false;
+    }
+    width  = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+    height = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+    return true;
+}
+
+class StdioAssetReader : public AssetReader {
+private:
+    FILE* _fd;
+
+public:
+    StdioAssetReader(FILE* fd) : _fd(fd) {}
+    ~StdioAssetReader() { fclose(_fd); }
+    bool   seek(size_t pos) override { return fseek(_fd, pos, SEEK_SET) == 0; }
+    size_t read(uint8_t* buf, size_t len) override { return fread(buf, 1, len, _fd); }
+    size_t size() override {
+        long pos = ftell(_fd);
+        fseek(_fd, 0, SEEK_END);
+        long len = ftell(_fd);
+        fseek(_fd, pos, SEEK_SET);
+        return len;
+    }
+};
+
+AssetReader* openAssetFile(const char* filename) {
+    std::string fn("data/");
+    fn += filename;
+    FILE* fd = fopen(fn.c_str(), "rb");
+    return fd ? new StdioAssetReader(fd) : nullptr;
+}
 
 #define TIOCM_LE 0x001
 #define TIOCM_DTR 0x002
@@ -281,6 +326,7 @@ Point sprite_offset { 0, 0 };
 void show_logo() {}
 void base_display() {
     display.clear();
+    invalidateDisplay();
 }
 
 void next_layout(int delta) {}
@@ -2,6 +2,7 @@
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
 #include "Text.h"
+#include "RenderProfile.h"
 #include <map>
 
 const GFXfont* font[] = {
@@ -14,6 +15,7 @@ const GFXfont* font[] = {
 };
 
 void text(const char* msg, int x, int y, int color, fontnum_t fontnum, int datum) {
+    RENDER_PHASE(RP_TEXT);
     canvas.setFont(font[fontnum]);
     canvas.setTextDatum(datum);
     canvas.setTextColor(color);
@@ -37,6 +39,7 @@ void centered_text(const char* msg, int y, int color, fontnum_t fontnum) {
 }
 
 void auto_text(const std::string& txt, int x, int y, int w, int color, fontnum_t fontnum, int datum, bool tryfonts, bool trimleft) {
+    RENDER_PHASE(RP_TEXT);
     bool doesnotfit = true;
     while (true) {  // forever loop
         int f = fontnum;
@@ -0,0 +1,124 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "TileDiff.h"
+#include <cstring>
+
+void TileDiff::begin(int width, int height) {
+    _width  = width;
+    _height = height;
+    _cols   = (width + _tile_size - 1) / _tile_size;
+    _rows   = (height + _tile_size - 1) / _tile_size;
+    _hashes.assign(_cols * _rows, 0);
+    _dirty.assign(_cols * _rows, true);
+    _valid = false;
+}
+
+// FNV-1a over 32-bit words, with a byte-wise tail for odd tile widths.
+// A collision only costs a missed update of one tile until it changes
+// again, and a full push happens whenever the frame is invalidated.
+uint32_t TileDiff::hash_tile(const uint8_t* pixels, int stride, int bytes_per_pixel, int col, int row) {
+    int x0 = col * _tile_size;
+    int y0 = row * _tile_size;
+    int w  = (x0 + _tile_size > _width) ? _width - x0 : _tile_size;
+    int h  = (y0 + _tile_size > _height) ? _height - y0 : _tile_size;
+
+    int row_bytes = w * bytes_per_pixel;
+    int words     = row_bytes / 4;
+    int tail      = row_bytes % 4;
+
+    uint32_t hash = 2166136261u;
+    for (int y = 0; y < h; ++y) {
+        const uint8_t* p = pixels + (y0 + y) * stride + x0 * bytes_per_pixel;
+        for (int i = 0; i < words; ++i) {
+            uint32_t word;
+            memcpy(&word, p, 4);
+            hash = (hash ^ word) * 16777619u;
+            p += 4;
+        }
+        for (int i = 0; i < tail; ++i) {
+            hash = (hash ^ *p++) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+// Joins horizontally adjacent dirty tiles into spans, then extends a
+// rectangle downward while the next tile row has exactly the same span.
+// That keeps the rectangle count low for the common cases of a single
+// changed DRO digit column or a full-width band.
+void TileDiff::merge(std::vector<dirty_rect_t>& rects) {
+    rects.clear();
+    _open.clear();
+
+    for (int row = 0; row < _rows; ++row) {
+        int y = row * _tile_size;
+        int h = (y + _tile_size > _height) ? _height - y : _tile_size;
+
+        _next_open.clear();
+        int col = 0;
+        while (col < _cols) {
+            if (!_dirty[row * _cols + col]) {
+                ++col;
+                continue;
+            }
+            int first = col;
+            while (col < _cols && _dirty[row * _cols + col]) {
+                ++col;
+            }
+            int x = first * _tile_size;
+            int w = ((col * _tile_size > _width) ? _width : col * _tile_size) - x;
+
+            size_t index = rects.size();
+            for (auto i : _open) {
+                if (rects[i].x == x && rects[i].w == w) {
+                    index = i;
+                    break;
+                }
+            }
+            if (index == rects.size()) {
+                rects.push_back({ x, y, w, h });
+            } else {
+                rects[index].h += h;
+            }
+            _next_open.push_back(index);
+        }
+        _open.swap(_next_open);
+    }
+}
+
+uint32_t TileDiff::diff(const uint8_t* pixels, int stride, int bytes_per_pixel, std::vector<dirty_rect_t>& rects) {
+    bool     any_dirty = false;
+    uint32_t n_pixels  = 0;
+
+    for (int row = 0; row < _rows; ++row) {
+        for (int col = 0; col < _cols; ++col) {
+            int      n     = row * _cols + col;
+            uint32_t hash  = hash_tile(pixels, stride, bytes_per_pixel, col, row);
+            bool     dirty = !_valid || hash != _hashes[n];
+            _hashes[n]     = hash;
+            _dirty[n]      = dirty;
+            any_dirty |= dirty;
+        }
+    }
+
+    ++frames;
+    if (!_valid) {
+        ++full_frames;
+        rects.assign(1, { 0, 0, _width, _height });
+        _valid = true;
+    } else if (any_dirty) {
+        merge(rects);
+    } else {
+        ++skipped;
+        rects.clear();
+    }
+
+    for (auto const& r : rects) {
+        n_pixels += r.w * r.h;
+    }
+    last_rects  = rects.size();
+    last_pixels = n_pixels;
+    total_pixels += n_pixels;
+    return n_pixels;
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Tile-level change detection for the offscreen canvas.  The canvas
+// is divided into square tiles and a hash of each tile is remembered
+// from the previous push.  diff() compares a new frame against those
+// hashes and returns the changed tiles merged into rectangles, so
+// refreshDisplay() only has to send the parts of the screen that
+// actually changed.  This file has no graphics dependencies so it can
+// be tested on the host.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Tile edge length in pixels.  Smaller tiles send fewer unchanged
+// pixels but cost more rectangles (and more setWindow commands).
+#ifndef REFRESH_TILE_SIZE
+#    define REFRESH_TILE_SIZE 16
+#endif
+
+struct dirty_rect_t {
+    int x;
+    int y;
+    int w;
+    int h;
+};
+
+class TileDiff {
+private:
+    int  _tile_size;
+    int  _width  = 0;
+    int  _height = 0;
+    int  _cols   = 0;
+    int  _rows   = 0;
+    bool _valid  = false;  // false forces the next frame to be sent in full
+
+    std::vector<uint32_t> _hashes;
+    std::vector<bool>     _dirty;
+    std::vector<size_t>   _open;  // rects that reach the bottom of the previous tile row
+    std::vector<size_t>   _next_open;
+
+    uint32_t hash_tile(const uint8_t* pixels, int stride, int bytes_per_pixel, int col, int row);
+    void     merge(std::vector<dirty_rect_t>& rects);
+
+public:
+    // Statistics, in pixels so callers can scale by the panel depth
+    uint32_t frames       = 0;
+    uint32_t full_frames  = 0;
+    uint32_t skipped      = 0;  // frames with nothing to send
+    uint32_t last_pixels  = 0;
+    uint64_t total_pixels = 0;
+    uint32_t last_rects   = 0;
+
+    TileDiff(int tile_size = REFRESH_TILE_SIZE) : _tile_size(tile_size) {}
+
+    // Sizes the hash table for a width x height frame and forces a full push
+    void begin(int width, int height);
+    bool ready() { return _cols != 0; }
+
+    // Forget the previous frame, e.g. after something else drew on the panel
+    void invalidate() { _valid = false; }
+
+    // Compares the frame at pixels (stride bytes per row) against the
+    // previous one, remembers it, and fills rects with the regions
+    // that must be sent.  Returns the number of pixels to be sent.
+    uint32_t diff(const uint8_t* pixels, int stride, int bytes_per_pixel, std::vector<dirty_rect_t>& rects);
+};
@@ -0,0 +1,34 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Widget.h"
+#include "Scene.h"  // scene_activations
+
+uint32_t Widget::drawn   = 0;
+uint32_t Widget::skipped = 0;
+
+bool Widget::changed(uint32_t key) {
+    if (_valid && key == _key) {
+        ++skipped;
+        return false;
+    }
+    _key   = key;
+    _valid = true;
+    ++drawn;
+    return true;
+}
+
+bool WidgetTree::retained(uint32_t layout) {
+    // Any scene activation, including a popup over this scene and the
+    // return from it, means the canvas was drawn by someone else.
+    if (_valid && layout == _layout && _activation == scene_activations) {
+        return true;
+    }
+    _valid      = true;
+    _layout     = layout;
+    _activation = scene_activations;
+    for (auto widget : _widgets) {
+        widget->invalidate();
+    }
+    return false;
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Retained-mode support for scenes whose displays change only in a few
+// places between frames.  A Widget owns a rectangle of the canvas and
+// remembers a key computed from the state it was last drawn with, so a
+// frame can skip every widget whose model value, color and highlight
+// are unchanged.  The canvas keeps the old pixels, and refreshDisplay()
+// sends only the tiles that the redrawn widgets touched.
+//
+// Widgets must cover their whole rectangle when they draw, since the
+// background under them is not restored.  A widget that does not paint
+// all of it calls restoreBackground() first.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Accumulates an FNV-1a hash of the values that determine how a widget looks
+class WidgetKey {
+private:
+    uint32_t _hash = 2166136261u;
+
+public:
+    template <typename T>
+    WidgetKey& add(const T& value) {
+        auto p = reinterpret_cast<const uint8_t*>(&value);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            _hash = (_hash ^ p[i]) * 16777619u;
+        }
+        return *this;
+    }
+    WidgetKey& add(const char* s) {
+        while (*s) {
+            _hash = (_hash ^ (uint8_t)*s++) * 16777619u;
+        }
+        return add('\0');
+    }
+    operator uint32_t() const { return _hash; }
+};
+
+class Widget {
+private:
+    uint32_t _key   = 0;
+    bool     _valid = false;
+
+protected:
+    int _x;
+    int _y;
+    int _width;
+    int _height;
+
+    // Returns true if the widget must be drawn for the state in key,
+    // and records key as the drawn state.
+    bool changed(uint32_t key);
+
+public:
+    Widget(int x, int y, int width, int height) : _x(x), _y(y), _width(width), _height(height) {}
+
+    void invalidate() { _valid = false; }
+
+    int x() { return _x; }
+    int y() { return _y; }
+    int width() { return _width; }
+    int height() { return _height; }
+
+    static uint32_t drawn;
+    static uint32_t skipped;
+};
+
+// The widgets of one scene.  A scene asks retained() at the start of
+// reDisplay(); if it returns false, the canvas does not hold this
+// scene's previous frame, or the parts of it that are not widgets have
+// changed, so the scene draws everything and the widgets draw
+// unconditionally.  Otherwise the scene only needs to draw its widgets.
+class WidgetTree {
+private:
+    std::vector<Widget*> _widgets;
+    uint32_t             _layout     = 0;
+    uint32_t             _activation = 0;
+    bool                 _valid      = false;
+
+public:
+    void add(Widget& widget) { _widgets.push_back(&widget); }
+
+    // layout is a key of everything the scene draws outside its widgets
+    bool retained(uint32_t layout);
+    void invalidate() { _valid = false; }
+};
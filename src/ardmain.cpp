@@ -5,6 +5,7 @@
 #include "FileParser.h"
 #include "Scene.h"
 #include "AboutScene.h"
+#include "LoopTiming.h"
 #include "transport/transport.h"
 #ifdef USE_WIFI_PENDANT
 #include "net/net_config.h"
@@ -50,20 +51,41 @@ void setup() {
 
     extern Scene* initMenus();
     activate_scene(initMenus());
+    dbg_printf("Boot to menu: %d ms\n", milliseconds());
 }
 
+LoopTimer loop_timer;
+
 void loop() {
+    loop_timer.start(microseconds());
 #ifdef USE_WIFI_PENDANT
     // Update WiFi connection status and handle reconnects
     wifiReady();
     
     // Initialize WiFi transport if not already done
     init_wifi_transport();
+    loop_timer.mark(LP_WIFI, microseconds());
 #endif
     
     if (transport) {
         transport->loop();  // Handle transport-specific tasks
     }
+    loop_timer.mark(LP_TRANSPORT, microseconds());
     fnc_poll();         // Handle messages from FluidNC
+    loop_timer.mark(LP_POLL, microseconds());
     dispatch_events();  // Handle dial, touch, buttons
+    loop_timer.mark(LP_EVENTS, microseconds());
+    if (transport) {
+        transport->flush();  // Send the lines queued by this iteration
+    }
+    loop_timer.mark(LP_FLUSH, microseconds());
+
+    auto stall = loop_timer.finish(microseconds(), milliseconds(), current_scene ? current_scene->name() : "");
+    if (stall) {
+        dbg_printf("Loop stall: %u ms, %u ms in %s, scene %s\n",
+                   stall->total_us / 1000,
+                   stall->phase_us / 1000,
+                   LoopTimer::phase_name(stall->phase),
+                   stall->scene);
+    }
 }
@@ -0,0 +1,448 @@
+// Copyright (c) 2023 Mitch Bradley
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+// Entry point for the headless Linux build, with a script runner for
+// injected input and a per-scene benchmark
+
+#ifdef LINUX_HOST
+
+#    include "System.h"
+#    include "SystemLinux.h"
+#    include "Scene.h"
+#    include "FluidNCModel.h"
+#    include "RenderProfile.h"
+#    include "LoopTiming.h"
+#    include "transport/replay_transport.h"
+
+#    include <algorithm>
+#    include <string>
+#    include <vector>
+#    include <poll.h>
+#    include <unistd.h>
+
+extern void setup();
+extern void loop();
+
+extern Scene menuScene;
+extern Scene statusScene;
+extern Scene homingScene;
+extern Scene multiJogScene;
+extern Scene probingScene;
+extern Scene toolchangeScene;
+extern Scene fileSelectScene;
+extern Scene settingsScene;
+extern Scene aboutScene;
+
+static const struct {
+    const char* name;
+    Scene*      scene;
+} scenes[] = {
+    { "menu", &menuScene },
+    { "status", &statusScene },
+    { "homing", &homingScene },
+    { "jog", &multiJogScene },
+    { "probing", &probingScene },
+    { "toolchange", &toolchangeScene },
+    { "files", &fileSelectScene },
+    { "settings", &settingsScene },
+    { "about", &aboutScene },
+};
+
+static Scene* find_scene(const char* name) {
+    for (auto& s : scenes) {
+        if (strcmp(name, s.name) == 0) {
+            return s.scene;
+        }
+    }
+    return nullptr;
+}
+
+// Frame statistics, collected around each main loop iteration that
+// pushed a frame to the panel
+struct FrameStats {
+    uint32_t frames  = 0;
+    uint32_t min_us  = UINT32_MAX;
+    uint32_t max_us  = 0;
+    uint64_t sum_us  = 0;
+    uint32_t reports = 0;
+    uint64_t pixels  = 0;
+    size_t   heap    = 0;
+    size_t   peak    = 0;
+};
+
+static FrameStats stats;
+
+static void step() {
+    uint32_t frames = frames_rendered;
+    uint32_t start  = microseconds();
+    loop();
+    uint32_t us = microseconds() - start;
+    if (frames_rendered != frames) {
+        ++stats.frames;
+        stats.sum_us += us;
+        stats.min_us = std::min(stats.min_us, us);
+        stats.max_us = std::max(stats.max_us, us);
+    }
+    size_t heap = heap_used();
+    if (heap > stats.peak) {
+        stats.peak = heap;
+    }
+}
+
+static void run_for(int ms) {
+    int start = milliseconds();
+    while ((milliseconds() - start) < ms) {
+        step();
+    }
+}
+
+// Draws the current scene from scratch and compares the panel with
+// what the retained frames before it left there.  Any difference is a
+// widget that did not repaint all of its rectangle.
+static bool check_retained() {
+    int                         w = display.width();
+    int                         h = display.height();
+    std::vector<lgfx::rgb888_t> retained(w * h);
+    std::vector<lgfx::rgb888_t> full(w * h);
+    display.readRectRGB(0, 0, w, h, retained.data());
+
+    ++scene_activations;
+    current_scene->reDisplay();
+    display.readRectRGB(0, 0, w, h, full.data());
+
+    int differ = 0;
+    int first  = -1;
+    for (int i = 0; i < w * h; ++i) {
+        auto& a = retained[i];
+        auto& b = full[i];
+        if (a.R8() != b.R8() || a.G8() != b.G8() || a.B8() != b.B8()) {
+            if (first < 0) {
+                first = i;
+            }
+            ++differ;
+        }
+    }
+    if (differ) {
+        fprintf(stderr,
+                "check: %d pixels differ from a full redraw of %s, the first at %d,%d\n",
+                differ,
+                current_scene->name(),
+                first % w,
+                first / w);
+        return false;
+    }
+    return true;
+}
+
+static int button_number(const char* name) {
+    if (strcmp(name, "red") == 0) {
+        return 0;
+    }
+    if (strcmp(name, "dial") == 0) {
+        return 1;
+    }
+    if (strcmp(name, "green") == 0) {
+        return 2;
+    }
+    return atoi(name);
+}
+
+// One script command per line:
+//   wait MS            run the main loop for MS milliseconds
+//   encoder N          turn the dial N counts
+//   press|release|click red|dial|green
+//   touch X Y, untouch, tap X Y
+//   scene NAME         activate a scene at the top level
+//   dump FILE          write the panel contents as a PPM file
+//   check              fail unless a full redraw matches the panel
+//   profile            print the render profile, with -DRENDER_PROFILE
+//   timing             print the main loop timing and stalls
+static bool run_command(const char* line) {
+    char cmd[16];
+    char arg[200] = "";
+    int  x, y;
+    if (sscanf(line, " %15s %199[^\n]", cmd, arg) < 1 || cmd[0] == '#') {
+        return true;
+    }
+    if (strcmp(cmd, "wait") == 0) {
+        run_for(atoi(arg));
+    } else if (strcmp(cmd, "encoder") == 0) {
+        inject_encoder(atoi(arg));
+        step();
+    } else if (strcmp(cmd, "press") == 0) {
+        inject_button(button_number(arg), true);
+        step();
+    } else if (strcmp(cmd, "release") == 0) {
+        inject_button(button_number(arg), false);
+        step();
+    } else if (strcmp(cmd, "click") == 0) {
+        inject_button(button_number(arg), true);
+        run_for(100);
+        inject_button(button_number(arg), false);
+        step();
+    } else if (strcmp(cmd, "touch") == 0 && sscanf(arg, "%d %d", &x, &y) == 2) {
+        inject_touch(x, y);
+        run_for(20);
+    } else if (strcmp(cmd, "untouch") == 0) {
+        inject_untouch();
+        run_for(20);
+    } else if (strcmp(cmd, "tap") == 0 && sscanf(arg, "%d %d", &x, &y) == 2) {
+        inject_touch(x, y);
+        run_for(50);
+        inject_untouch();
+        run_for(20);
+    } else if (strcmp(cmd, "scene") == 0) {
+        Scene* scene = find_scene(arg);
+        if (!scene) {
+            fprintf(stderr, "Unknown scene %s\n", arg);
+            return false;
+        }
+        activate_at_top_level(scene);
+        step();
+    } else if (strcmp(cmd, "profile") == 0) {
+        render_profile_dump();
+    } else if (strcmp(cmd, "timing") == 0) {
+        loop_timer.dump(dbg_print);
+    } else if (strcmp(cmd, "check") == 0) {
+        return check_retained();
+    } else if (strcmp(cmd, "dump") == 0) {
+        if (!dump_display(arg)) {
+            fprintf(stderr, "Can't write %s\n", arg);
+        }
+    } else {
+        fprintf(stderr, "Unknown command %s\n", line);
+        return false;
+    }
+    return true;
+}
+
+static bool run_script(const std::vector<std::string>& script) {
+    for (auto& line : script) {
+        if (!run_command(line.c_str())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool read_file(const char* filename, std::string& text) {
+    FILE* fd = fopen(filename, "rb");
+    if (!fd) {
+        return false;
+    }
+    char   buf[4096];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), fd)) > 0) {
+        text.append(buf, len);
+    }
+    fclose(fd);
+    return true;
+}
+
+static void split_lines(const std::string& text, std::vector<std::string>& lines) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        lines.push_back(text.substr(pos, end - pos));
+        pos = end + 1;
+    }
+}
+
+// Used for each scene when --bench has no --script.  A detent is four
+// counts, and menus ignore anything less.
+static const char* default_script =
+    "wait 500\n"
+    "encoder 4\nwait 100\nencoder 4\nwait 100\nencoder 4\nwait 100\n"
+    "encoder -4\nwait 100\nencoder -4\nwait 100\nencoder -4\nwait 100\n"
+    "wait 1000\n";
+
+static void print_stats_header() {
+    printf("%-12s %7s %8s %8s %8s %10s %10s %8s %8s\n",
+           "scene",
+           "frames",
+           "min ms",
+           "avg ms",
+           "max ms",
+           "fr/report",
+           "KB pushed",
+           "heap KB",
+           "peak KB");
+}
+
+static void print_stats(const char* name) {
+    printf("%-12s %7u %8.2f %8.2f %8.2f %10.3f %10.1f %8.1f %8.1f\n",
+           name,
+           stats.frames,
+           stats.frames ? stats.min_us / 1000.0 : 0.0,
+           stats.frames ? stats.sum_us / 1000.0 / stats.frames : 0.0,
+           stats.max_us / 1000.0,
+           stats.reports ? (double)stats.frames / stats.reports : 0.0,
+           stats.pixels * panel_bytes_per_pixel / 1024.0,
+           stats.heap / 1024.0,
+           stats.peak / 1024.0);
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --port DEV        serial port or pty, e.g. from tools/fluidnc_sim.py --pty\n"
+            "  --baud N          serial baud rate, default 115200\n"
+            "  --tcp HOST:PORT   raw TCP, e.g. tools/fluidnc_sim.py --tcp PORT\n"
+            "  --replay FILE     play back a capture instead of a live controller\n"
+            "  --max-speed       deliver the replay as fast as it is read\n"
+            "  --script FILE     run scripted input, then exit\n"
+            "  --bench           run every scene through the script and report\n"
+            "  --scenes A,B,...  scenes for --bench, default all\n"
+            "  --dump DIR        with --bench, save each scene's last frame in DIR\n"
+            "Without --script or --bench, script commands are read from stdin.\n",
+            name);
+    exit(1);
+}
+
+int main(int argc, char** argv) {
+    const char* port        = nullptr;
+    int         baud        = 115200;
+    const char* tcp         = nullptr;
+    const char* replay      = nullptr;
+    const char* script_file = nullptr;
+    const char* scene_list  = nullptr;
+    const char* dump_dir    = nullptr;
+    bool        bench       = false;
+    auto        mode        = ReplayTransport::TIMED;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string opt(argv[i]);
+        bool        has_arg = i + 1 < argc;
+        if (opt == "--port" && has_arg) {
+            port = argv[++i];
+        } else if (opt == "--baud" && has_arg) {
+            baud = atoi(argv[++i]);
+        } else if (opt == "--tcp" && has_arg) {
+            tcp = argv[++i];
+        } else if (opt == "--replay" && has_arg) {
+            replay = argv[++i];
+        } else if (opt == "--max-speed") {
+            mode = ReplayTransport::MAX_SPEED;
+        } else if (opt == "--script" && has_arg) {
+            script_file = argv[++i];
+        } else if (opt == "--bench") {
+            bench = true;
+        } else if (opt == "--scenes" && has_arg) {
+            scene_list = argv[++i];
+        } else if (opt == "--dump" && has_arg) {
+            dump_dir = argv[++i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    std::vector<CaptureRecord> records;
+    if (replay) {
+        std::string text;
+        if (!read_file(replay, text)) {
+            fprintf(stderr, "Can't read %s\n", replay);
+            return 1;
+        }
+        load_capture(text.data(), text.size(), records);
+    }
+    auto connect = [&]() -> Transport* {
+        if (port) {
+            return open_serial_transport(port, baud);
+        }
+        if (tcp) {
+            return open_tcp_transport(tcp);
+        }
+        if (replay) {
+            return new ReplayTransport(records, mode, microseconds);
+        }
+        return nullptr;
+    };
+
+    Transport* t = connect();
+    if (!t) {
+        usage(argv[0]);
+    }
+    set_fnc_transport(t);
+
+    std::vector<std::string> script;
+    if (script_file) {
+        std::string text;
+        if (!read_file(script_file, text)) {
+            fprintf(stderr, "Can't read %s\n", script_file);
+            return 1;
+        }
+        split_lines(text, script);
+    } else if (bench) {
+        split_lines(default_script, script);
+    }
+
+    skip_delays = bench || script_file;
+    setup();
+
+    if (!bench) {
+        if (script_file) {
+            return run_script(script) ? 0 : 1;
+        }
+        // Interactive: commands arrive on stdin while the loop runs
+        std::string pending;
+        while (true) {
+            step();
+            struct pollfd pfd = { 0, POLLIN, 0 };
+            if (poll(&pfd, 1, 1) > 0) {
+                char    buf[256];
+                ssize_t len = read(0, buf, sizeof(buf));
+                if (len <= 0) {
+                    return 0;
+                }
+                pending.append(buf, len);
+                size_t nl;
+                while ((nl = pending.find('\n')) != std::string::npos) {
+                    run_command(pending.substr(0, nl).c_str());
+                    pending.erase(0, nl + 1);
+                }
+            }
+        }
+    }
+
+    // Let the connection settle before the first scene is measured
+    run_for(500);
+
+    print_stats_header();
+    for (auto& s : scenes) {
+        if (scene_list && !strstr(scene_list, s.name)) {
+            continue;
+        }
+        // Each scene sees the same traffic from the start of the capture
+        if (replay) {
+            Transport* old = transport;
+            set_fnc_transport(connect());
+            delete old;
+        }
+        activate_at_top_level(s.scene);
+
+        stats            = FrameStats();
+        uint32_t reports = status_reports;
+        uint64_t pixels  = total_refresh_pixels;
+        if (!run_script(script)) {
+            return 1;
+        }
+        stats.reports = status_reports - reports;
+        stats.pixels  = total_refresh_pixels - pixels;
+        stats.heap    = heap_used();
+        print_stats(s.name);
+
+        if (dump_dir) {
+            std::string fn(dump_dir);
+            fn += "/";
+            fn += s.name;
+            fn += ".ppm";
+            dump_display(fn.c_str());
+        }
+    }
+    return 0;
+}
+
+#endif
@@ -7,6 +7,7 @@
 
 #include "System.h"
 #include "net_store.h"
+#include "FluidNCModel.h"
 #include <WiFi.h>
 #include <LittleFS.h>
 
@@ -20,6 +21,115 @@ static char currentSSID[64] = "";
 static char currentPassword[64] = "";
 static bool wifiInitialized = false;
 
+// Fast rejoin state.  The first attempt after boot or a link loss goes
+// straight to the access point and channel of the last successful join;
+// if that does not connect within FAST_REJOIN_TIMEOUT_MS, a full scan
+// follows at once.
+static wifi_rejoin_t rejoinCache;
+static bool haveRejoinCache = false;
+static wifi_static_ip_t staticIp;
+static bool directedAttempt = false; // Current attempt is a fast rejoin
+static bool directedTried = false;   // Fast rejoin already used for this outage
+
+// Outage timing, from boot or link loss to the first status report
+static wifi_join_stats_t wifiJoinStats;
+static unsigned long outageStart = 0;
+static bool outageAfterBoot = true;
+static bool awaitingReport = true;
+static bool joinedFast = false;
+static uint32_t reportsAtOutage = 0;
+
+static void beginOutage(unsigned long now) {
+    outageStart = now;
+    outageAfterBoot = false;
+    awaitingReport = true;
+    reportsAtOutage = status_reports;
+    directedTried = false;
+}
+
+// Fixed addresses skip DHCP.  A cached lease is only reused on a fast
+// rejoin, and only if /net.json asks for it.
+static void applyAddressConfig(bool fast) {
+    if (staticIp.enabled) {
+        WiFi.config(IPAddress(staticIp.ip), IPAddress(staticIp.gateway), IPAddress(staticIp.mask), IPAddress(staticIp.dns));
+    } else if (fast && staticIp.reuse_lease && rejoinCache.ip && rejoinCache.gateway) {
+        WiFi.config(IPAddress(rejoinCache.ip), IPAddress(rejoinCache.gateway), IPAddress(rejoinCache.mask), IPAddress(rejoinCache.dns));
+    } else {
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    }
+}
+
+static void beginDirectedJoin() {
+    dbg_printf("WiFi: Fast rejoin to %s on channel %d\n", currentSSID, rejoinCache.channel);
+    directedAttempt = true;
+    directedTried = true;
+    applyAddressConfig(true);
+    WiFi.begin(currentSSID, currentPassword, rejoinCache.channel, rejoinCache.bssid);
+}
+
+static void beginScanJoin() {
+    dbg_printf("WiFi: Attempting connection to %s\n", currentSSID);
+    directedAttempt = false;
+    applyAddressConfig(false);
+    WiFi.begin(currentSSID, currentPassword);
+}
+
+// The cached access point did not answer; scan without waiting out the
+// backoff, since no time was spent on a scan yet
+static void fallBackToScan(unsigned long now) {
+    dbg_printf("WiFi: Fast rejoin failed, scanning\n");
+    ++wifiJoinStats.fast_failures;
+    WiFi.disconnect();
+    lastConnectionAttempt = now;
+    connectionInProgress = true;
+    beginScanJoin();
+}
+
+// Remembers where the join landed, writing /net.json only if it changed
+static void updateRejoinCache() {
+    wifi_rejoin_t r;
+    memset(&r, 0, sizeof(r));
+    const uint8_t* bssid = WiFi.BSSID();
+    if (!bssid) {
+        return;
+    }
+    memcpy(r.bssid, bssid, sizeof(r.bssid));
+    r.channel = WiFi.channel();
+    r.ip = WiFi.localIP();
+    r.gateway = WiFi.gatewayIP();
+    r.mask = WiFi.subnetMask();
+    r.dns = WiFi.dnsIP();
+    if (haveRejoinCache && memcmp(&r, &rejoinCache, sizeof(r)) == 0) {
+        return;
+    }
+    rejoinCache = r;
+    haveRejoinCache = true;
+    if (!NetStore::saveRejoin(currentSSID, rejoinCache)) {
+        dbg_printf("WiFi: Could not save rejoin cache\n");
+    }
+}
+
+static void checkFirstReport(unsigned long now) {
+    if (!awaitingReport || status_reports == reportsAtOutage) {
+        return;
+    }
+    awaitingReport = false;
+    uint32_t ms = now - outageStart;
+    if (outageAfterBoot) {
+        wifiJoinStats.boot_report_ms = ms;
+    } else {
+        wifiJoinStats.last_report_ms = ms;
+        if (ms > wifiJoinStats.max_report_ms) {
+            wifiJoinStats.max_report_ms = ms;
+        }
+    }
+    dbg_printf("WiFi: First status report %u ms after %s (join %u ms, %s)\n",
+               (unsigned)ms,
+               outageAfterBoot ? "boot" : "link loss",
+               (unsigned)wifiJoinStats.last_join_ms,
+               joinedFast ? "fast rejoin" : "scan");
+}
+
 bool NetConfig::init() {
     if (wifiInitialized) {
         return true;
@@ -44,6 +154,10 @@ bool NetConfig::init() {
     if (NetStore::loadWifiCredentials(currentSSID, sizeof(currentSSID), 
                                      currentPassword, sizeof(currentPassword))) {
         dbg_printf("WiFi: Loaded credentials for SSID: %s\n", currentSSID);
+        haveRejoinCache = NetStore::loadRejoin(currentSSID, rejoinCache);
+        if (NetStore::loadStaticIp(staticIp)) {
+            dbg_printf("WiFi: Static IP %s\n", IPAddress(staticIp.ip).toString().c_str());
+        }
     } else {
         dbg_printf("WiFi: No saved credentials found\n");
     }
@@ -71,8 +185,12 @@ bool NetConfig::connectWifi(const char* ssid, const char* password) {
     strlcpy(currentSSID, ssid, sizeof(currentSSID));
     strlcpy(currentPassword, password ? password : "", sizeof(currentPassword));
     
-    // Save credentials to persistent storage
+    // Save credentials to persistent storage.  This drops the rejoin
+    // cache if the network changed.
     NetStore::saveWifiCredentials(ssid, password);
+    haveRejoinCache = NetStore::loadRejoin(currentSSID, rejoinCache);
+    NetStore::loadStaticIp(staticIp);
+    directedTried = false;
     
     // Start connection attempt
     return wifiConnectAsync();
@@ -97,17 +215,29 @@ bool NetConfig::wifiConnectAsync() {
         return true;
     }
     
+    // A fast rejoin gets a short time to connect before a full scan
+    if (directedAttempt) {
+        if (now - lastConnectionAttempt < FAST_REJOIN_TIMEOUT_MS) {
+            return false;
+        }
+        fallBackToScan(now);
+        return true;
+    }
+    
     // Check if we should attempt connection (respecting backoff delay)
     if (connectionInProgress && (now - lastConnectionAttempt < reconnectDelay)) {
         return false; // Still waiting for current attempt or backoff
     }
     
-    dbg_printf("WiFi: Attempting connection to %s\n", currentSSID);
     connectionInProgress = true;
     lastConnectionAttempt = now;
     
     // Start non-blocking connection
-    WiFi.begin(currentSSID, currentPassword);
+    if (haveRejoinCache && !directedTried) {
+        beginDirectedJoin();
+    } else {
+        beginScanJoin();
+    }
     
     return true;
 }
@@ -118,30 +248,48 @@ bool NetConfig::wifiReady() {
     }
     
     wl_status_t currentStatus = WiFi.status();
+    unsigned long now = millis();
     
     // Handle status change events
     if (currentStatus != lastWifiStatus) {
+        if (lastWifiStatus == WL_CONNECTED) {
+            beginOutage(now);
+        }
         switch (currentStatus) {
             case WL_CONNECTED:
                 dbg_printf("WiFi: Connected to %s, IP: %s\n", currentSSID, WiFi.localIP().toString().c_str());
                 WiFi.setSleep(false); // Disable WiFi sleep for better performance
                 reconnectDelay = 5000; // Reset backoff delay
                 connectionInProgress = false;
+                joinedFast = directedAttempt;
+                directedAttempt = false;
+                wifiJoinStats.last_join_ms = now - outageStart;
+                if (joinedFast) {
+                    ++wifiJoinStats.fast_rejoins;
+                } else {
+                    ++wifiJoinStats.scan_joins;
+                }
+                updateRejoinCache();
                 break;
                 
             case WL_CONNECT_FAILED:
+            case WL_NO_SSID_AVAIL:
+                if (directedAttempt) {
+                    fallBackToScan(now);
+                    break;
+                }
+                if (currentStatus == WL_NO_SSID_AVAIL) {
+                    dbg_printf("WiFi: SSID not available\n");
+                    connectionInProgress = false;
+                    reconnectDelay = min(reconnectDelay * 2, MAX_RECONNECT_DELAY);
+                    break;
+                }
                 dbg_printf("WiFi: Connection failed\n");
                 connectionInProgress = false;
                 // Increase backoff delay for next attempt
                 reconnectDelay = min(reconnectDelay * 2, MAX_RECONNECT_DELAY);
                 break;
                 
-            case WL_NO_SSID_AVAIL:
-                dbg_printf("WiFi: SSID not available\n");
-                connectionInProgress = false;
-                reconnectDelay = min(reconnectDelay * 2, MAX_RECONNECT_DELAY);
-                break;
-                
             case WL_CONNECTION_LOST:
                 dbg_printf("WiFi: Connection lost, will attempt reconnect\n");
                 connectionInProgress = false;
@@ -154,6 +302,10 @@ bool NetConfig::wifiReady() {
         lastWifiStatus = currentStatus;
     }
     
+    if (currentStatus == WL_CONNECTED) {
+        checkFirstReport(now);
+    }
+    
     // Automatic reconnection logic
     if (currentStatus != WL_CONNECTED && strlen(currentSSID) > 0) {
         wifiConnectAsync(); // Will respect backoff timing
@@ -170,6 +322,7 @@ void NetConfig::disconnectWifi() {
     if (wifiInitialized) {
         WiFi.disconnect();
         connectionInProgress = false;
+        directedAttempt = false;
         dbg_printf("WiFi: Disconnected\n");
     }
 }
@@ -206,6 +359,9 @@ const char* NetConfig::getWifiStatus() {
             return "Disconnected";
         case WL_IDLE_STATUS:
         default:
+            if (directedAttempt) {
+                return "Rejoining...";
+            }
             if (connectionInProgress) {
                 return "Connecting...";
             }
@@ -221,4 +377,8 @@ const char* NetConfig::getLocalIP() {
     return "0.0.0.0";
 }
 
+const wifi_join_stats_t& NetConfig::joinStats() {
+    return wifiJoinStats;
+}
+
 #endif // USE_WIFI_PENDANT
\ No newline at end of file
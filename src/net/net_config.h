@@ -4,9 +4,28 @@
 #pragma once
 
 #include <cstddef> // For size_t
+#include <cstdint>
 
 #ifdef USE_WIFI_PENDANT
 
+// How long a fast rejoin to the cached access point may take before
+// falling back to a full scan
+#ifndef FAST_REJOIN_TIMEOUT_MS
+#define FAST_REJOIN_TIMEOUT_MS 3000
+#endif
+
+// Join and recovery times.  An outage starts at boot or when the link
+// drops, and ends with the first status report after the link is back.
+struct wifi_join_stats_t {
+    uint32_t fast_rejoins;    // Joins made with the cached BSSID and channel
+    uint32_t fast_failures;   // Fast rejoins that fell back to a scan
+    uint32_t scan_joins;      // Joins that needed a full scan
+    uint32_t last_join_ms;    // Outage start to WL_CONNECTED
+    uint32_t boot_report_ms;  // Boot to the first status report
+    uint32_t last_report_ms;  // Link loss to the first status report after it
+    uint32_t max_report_ms;   // Longest recovery after a link loss
+};
+
 // Network configuration interface for WiFi pendant
 // Handles WiFi connection management and FluidNC host discovery
 
@@ -25,6 +44,7 @@ public:
     static bool testFluidNCConnection(const char* host, int port);
     static const char* getWifiStatus();
     static const char* getLocalIP();
+    static const wifi_join_stats_t& joinStats();
 };
 
 // Alias functions to match issue requirements exactly
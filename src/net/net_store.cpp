@@ -88,9 +88,39 @@ void NetStore::clear() {
     }
 }
 
+static bool readConfig(JsonDocument& doc) {
+    File file = LittleFS.open(NET_CONFIG_FILE, "r");
+    if (!file) {
+        return false;
+    }
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+    return !error;
+}
+
+static bool writeConfig(const JsonDocument& doc) {
+    File file = LittleFS.open(NET_CONFIG_FILE, "w");
+    if (!file) {
+        return false;
+    }
+    bool success = (serializeJson(doc, file) > 0);
+    file.close();
+    return success;
+}
+
 // Core JSON-based network settings storage functions
 bool NetStore::netSave(const char* ssid, const char* password, const char* host, int port, const char* transport) {
+    // Start from the existing file so that the rejoin cache and the
+    // static IP settings survive a settings change
     JsonDocument doc;
+    if (LittleFS.exists(NET_CONFIG_FILE) && !readConfig(doc)) {
+        doc.clear();
+    }
+    
+    // A different network makes the cached access point useless
+    if (strcmp(doc["ssid"] | "", ssid ? ssid : "") != 0) {
+        doc.remove("rejoin");
+    }
     
     // Set values, using defaults where appropriate
     doc["ssid"] = ssid ? ssid : "";
@@ -99,15 +129,7 @@ bool NetStore::netSave(const char* ssid, const char* password, const char* host,
     doc["port"] = port > 0 ? port : 81;
     doc["transport"] = transport ? transport : "ws";
     
-    File file = LittleFS.open(NET_CONFIG_FILE, "w");
-    if (!file) {
-        return false;
-    }
-    
-    bool success = (serializeJson(doc, file) > 0);
-    file.close();
-    
-    return success;
+    return writeConfig(doc);
 }
 
 bool NetStore::netLoad(char* ssid, size_t ssidLen, char* password, size_t passwordLen, 
@@ -155,4 +177,94 @@ bool NetStore::netLoad(char* ssid, size_t ssidLen, char* password, size_t passwo
     return true;
 }
 
+static uint32_t parseIp(const char* text) {
+    IPAddress addr;
+    return (text && addr.fromString(text)) ? (uint32_t)addr : 0;
+}
+
+static String formatIp(uint32_t ip) {
+    return IPAddress(ip).toString();
+}
+
+bool NetStore::saveRejoin(const char* ssid, const wifi_rejoin_t& rejoin) {
+    JsonDocument doc;
+    if (!readConfig(doc)) {
+        return false;  // Nothing to attach the cache to
+    }
+    
+    char bssid[18];
+    snprintf(bssid, sizeof(bssid), "%02x:%02x:%02x:%02x:%02x:%02x",
+             rejoin.bssid[0], rejoin.bssid[1], rejoin.bssid[2], rejoin.bssid[3], rejoin.bssid[4], rejoin.bssid[5]);
+    
+    JsonObject r = doc["rejoin"].to<JsonObject>();
+    r["ssid"] = ssid;
+    r["bssid"] = bssid;
+    r["channel"] = rejoin.channel;
+    r["ip"] = formatIp(rejoin.ip);
+    r["gateway"] = formatIp(rejoin.gateway);
+    r["mask"] = formatIp(rejoin.mask);
+    r["dns"] = formatIp(rejoin.dns);
+    
+    return writeConfig(doc);
+}
+
+bool NetStore::loadRejoin(const char* ssid, wifi_rejoin_t& rejoin) {
+    memset(&rejoin, 0, sizeof(rejoin));
+    
+    JsonDocument doc;
+    if (!readConfig(doc)) {
+        return false;
+    }
+    JsonObject r = doc["rejoin"];
+    if (r.isNull() || strcmp(r["ssid"] | "", ssid ? ssid : "") != 0) {
+        return false;
+    }
+    
+    unsigned int b[6];
+    if (sscanf(r["bssid"] | "", "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) {
+        return false;
+    }
+    for (int i = 0; i < 6; ++i) {
+        rejoin.bssid[i] = b[i];
+    }
+    rejoin.channel = r["channel"] | 0;
+    if (rejoin.channel <= 0) {
+        return false;
+    }
+    rejoin.ip = parseIp(r["ip"].as<const char*>());
+    rejoin.gateway = parseIp(r["gateway"].as<const char*>());
+    rejoin.mask = parseIp(r["mask"].as<const char*>());
+    rejoin.dns = parseIp(r["dns"].as<const char*>());
+    return true;
+}
+
+void NetStore::forgetRejoin() {
+    JsonDocument doc;
+    if (readConfig(doc) && doc["rejoin"].is<JsonObject>()) {
+        doc.remove("rejoin");
+        writeConfig(doc);
+    }
+}
+
+bool NetStore::loadStaticIp(wifi_static_ip_t& config) {
+    memset(&config, 0, sizeof(config));
+    
+    JsonDocument doc;
+    if (!readConfig(doc)) {
+        return false;
+    }
+    config.reuse_lease = doc["reuse_lease"] | false;
+    
+    JsonObject s = doc["static_ip"];
+    if (s.isNull()) {
+        return false;
+    }
+    config.ip = parseIp(s["ip"].as<const char*>());
+    config.gateway = parseIp(s["gateway"].as<const char*>());
+    config.mask = parseIp(s["mask"] | "255.255.255.0");
+    config.dns = parseIp(s["dns"].as<const char*>());
+    config.enabled = config.ip != 0 && config.gateway != 0;
+    return config.enabled;
+}
+
 #endif // USE_WIFI_PENDANT
\ No newline at end of file
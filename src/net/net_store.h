@@ -4,12 +4,37 @@
 #pragma once
 
 #include <cstddef> // For size_t
+#include <cstdint>
 
 #ifdef USE_WIFI_PENDANT
 
 // Network storage interface for WiFi pendant configuration
 // Handles persistent storage of network credentials and settings
 
+// What was learned from the last successful join, so the next one can
+// go straight to the same access point.  Addresses are IPAddress values
+// (network byte order); 0 means unknown.
+struct wifi_rejoin_t {
+    uint8_t  bssid[6];
+    int32_t  channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t mask;
+    uint32_t dns;
+};
+
+// Fixed address settings from the optional "static_ip" object in
+// /net.json.  When reuse_lease is set, the last DHCP lease is reused on
+// a fast rejoin instead, skipping the DHCP exchange.
+struct wifi_static_ip_t {
+    bool     enabled;
+    bool     reuse_lease;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t mask;
+    uint32_t dns;
+};
+
 class NetStore {
 public:
     static bool init();
@@ -23,6 +48,13 @@ public:
     static bool netSave(const char* ssid, const char* password, const char* host, int port, const char* transport);
     static bool netLoad(char* ssid, size_t ssidLen, char* password, size_t passwordLen, 
                        char* host, size_t hostLen, int& port, char* transport, size_t transportLen);
+
+    // Fast rejoin cache.  The record is kept with the SSID it was made
+    // for; loadRejoin() returns false if there is none for this SSID.
+    static bool saveRejoin(const char* ssid, const wifi_rejoin_t& rejoin);
+    static bool loadRejoin(const char* ssid, wifi_rejoin_t& rejoin);
+    static void forgetRejoin();
+    static bool loadStaticIp(wifi_static_ip_t& config);
 };
 
 #endif // USE_WIFI_PENDANT
\ No newline at end of file
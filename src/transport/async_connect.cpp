@@ -0,0 +1,225 @@
+// Copyright (c) 2023 Barton Dring
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "async_connect.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+AsyncConnector::~AsyncConnector() {
+    stop();
+}
+
+void AsyncConnector::setHost(const char* host, uint16_t port) {
+    if (_host != host) {
+        _cacheValid = false;
+    }
+    _host = host;
+    _port = port;
+}
+
+void AsyncConnector::start(uint32_t now_ms) {
+    stop();
+    _retryInterval = CONNECT_RETRY_MIN_MS;
+    _retryAt       = now_ms;
+    _state         = BACKOFF;
+}
+
+void AsyncConnector::lost(uint32_t now_ms) {
+    closeSocket();
+    _retryAt = now_ms;
+    _state   = BACKOFF;
+}
+
+void AsyncConnector::stop() {
+    if (_state == RESOLVING && _resolver) {
+        _resolver->cancel();
+    }
+    closeSocket();
+    _state = IDLE;
+}
+
+void AsyncConnector::closeSocket() {
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+}
+
+int AsyncConnector::takeSocket() {
+    int fd = _fd;
+    _fd    = -1;
+    return fd;
+}
+
+bool AsyncConnector::poll(uint32_t now_ms) {
+    switch (_state) {
+        case BACKOFF:
+            if ((int32_t)(now_ms - _retryAt) >= 0) {
+                beginAttempt(now_ms);
+                // A connect to a local address can finish at once
+                return _state == CONNECTED;
+            }
+            return false;
+
+        case RESOLVING: {
+            uint32_t ipv4;
+            switch (_resolver->poll(ipv4)) {
+                case HostResolver::DONE:
+                    _cacheValid   = true;
+                    _cachedIp     = ipv4;
+                    _cacheExpires = now_ms + RESOLVE_CACHE_TTL_MS;
+                    _usingCache   = false;
+                    openSocket(ipv4, now_ms);
+                    return _state == CONNECTED;
+                case HostResolver::FAILED:
+                    ++stats.resolve_failures;
+                    fail(now_ms);
+                    return false;
+                case HostResolver::PENDING:
+                    if ((now_ms - _stepStart) >= CONNECT_RESOLVE_TIMEOUT_MS) {
+                        _resolver->cancel();
+                        ++stats.timeouts;
+                        fail(now_ms);
+                    }
+                    return false;
+            }
+            return false;
+        }
+
+        case CONNECTING:
+            return checkSocket(now_ms);
+
+        case IDLE:
+        case CONNECTED:
+            break;
+    }
+    return false;
+}
+
+void AsyncConnector::beginAttempt(uint32_t now_ms) {
+    ++stats.attempts;
+    _attemptStart = now_ms;
+    _stepStart    = now_ms;
+
+    struct in_addr addr;
+    if (inet_pton(AF_INET, _host.c_str(), &addr) == 1) {
+        _usingCache = false;
+        openSocket(addr.s_addr, now_ms);
+        return;
+    }
+    if (_cacheValid && (int32_t)(_cacheExpires - now_ms) > 0) {
+        ++stats.cache_hits;
+        _usingCache = true;
+        openSocket(_cachedIp, now_ms);
+        return;
+    }
+    if (!_resolver || !_resolver->start(_host.c_str())) {
+        ++stats.resolve_failures;
+        fail(now_ms);
+        return;
+    }
+    _state = RESOLVING;
+}
+
+void AsyncConnector::openSocket(uint32_t ipv4, uint32_t now_ms) {
+    _stepStart = now_ms;
+    _fd        = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (_fd < 0) {
+        ++stats.connect_failures;
+        fail(now_ms);
+        return;
+    }
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+    // Realtime bytes such as jog cancel and overrides are single
+    // byte writes that must not wait for Nagle's algorithm
+    int one = 1;
+    setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family      = AF_INET;
+    sa.sin_port        = htons(_port);
+    sa.sin_addr.s_addr = ipv4;
+    if (connect(_fd, (struct sockaddr*)&sa, sizeof(sa)) == 0) {
+        succeed(now_ms);
+        return;
+    }
+    if (errno != EINPROGRESS) {
+        ++stats.connect_failures;
+        fail(now_ms);
+        return;
+    }
+    _state = CONNECTING;
+}
+
+// Looks at the pending handshake without waiting
+bool AsyncConnector::checkSocket(uint32_t now_ms) {
+    fd_set wfds;
+    FD_ZERO(&wfds);
+    FD_SET(_fd, &wfds);
+    struct timeval tv = { 0, 0 };
+    int            n  = select(_fd + 1, nullptr, &wfds, nullptr, &tv);
+    if (n > 0) {
+        int       err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt(_fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0) {
+            return succeed(now_ms);
+        }
+        ++stats.connect_failures;
+        fail(now_ms);
+        return false;
+    }
+    if (n < 0 || (now_ms - _stepStart) >= CONNECT_TIMEOUT_MS) {
+        ++stats.timeouts;
+        fail(now_ms);
+    }
+    return false;
+}
+
+bool AsyncConnector::succeed(uint32_t now_ms) {
+    uint32_t ms = now_ms - _attemptStart;
+    ++stats.connects;
+    stats.last_ms = ms;
+    stats.total_ms += ms;
+    if (ms > stats.max_ms) {
+        stats.max_ms = ms;
+    }
+    _retryInterval = CONNECT_RETRY_MIN_MS;
+    _state         = CONNECTED;
+    return true;
+}
+
+void AsyncConnector::fail(uint32_t now_ms) {
+    closeSocket();
+    if (_usingCache) {
+        _cacheValid = false;
+        _usingCache = false;
+    }
+    _retryAt       = now_ms + _retryInterval;
+    _retryInterval = _retryInterval * 2 < CONNECT_RETRY_MAX_MS ? _retryInterval * 2 : CONNECT_RETRY_MAX_MS;
+    _state         = BACKOFF;
+}
+
+const char* AsyncConnector::stateName(state_t state) {
+    switch (state) {
+        case IDLE:
+            return "idle";
+        case BACKOFF:
+            return "backoff";
+        case RESOLVING:
+            return "resolving";
+        case CONNECTING:
+            return "connecting";
+        case CONNECTED:
+            return "connected";
+    }
+    return "?";
+}
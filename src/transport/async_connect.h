@@ -0,0 +1,135 @@
+// Copyright (c) 2023 Barton Dring
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// Longest wait for a name lookup or a TCP handshake, per attempt
+#ifndef CONNECT_RESOLVE_TIMEOUT_MS
+#define CONNECT_RESOLVE_TIMEOUT_MS 3000
+#endif
+#ifndef CONNECT_TIMEOUT_MS
+#define CONNECT_TIMEOUT_MS 3000
+#endif
+
+// How long a resolved address is reused before it is looked up again
+#ifndef RESOLVE_CACHE_TTL_MS
+#define RESOLVE_CACHE_TTL_MS 60000
+#endif
+
+// Delay after a failed attempt, doubling up to the maximum
+#ifndef CONNECT_RETRY_MIN_MS
+#define CONNECT_RETRY_MIN_MS 2000
+#endif
+#ifndef CONNECT_RETRY_MAX_MS
+#define CONNECT_RETRY_MAX_MS 10000
+#endif
+
+// Looks up a host name without blocking.  Platforms wrap their
+// asynchronous mDNS and DNS queries in one of these.
+class HostResolver {
+public:
+    enum result_t {
+        PENDING,
+        DONE,
+        FAILED,
+    };
+
+    virtual ~HostResolver() = default;
+
+    // Starts a lookup; returns false if it could not be started
+    virtual bool start(const char* host) = 0;
+    // Checks on the lookup.  On DONE, ipv4 is the address in network
+    // byte order.
+    virtual result_t poll(uint32_t& ipv4) = 0;
+    virtual void     cancel()             = 0;
+};
+
+struct connect_stats_t {
+    uint32_t attempts         = 0;
+    uint32_t connects         = 0;
+    uint32_t resolve_failures = 0;
+    uint32_t connect_failures = 0;
+    uint32_t timeouts         = 0;
+    uint32_t cache_hits       = 0;
+    uint32_t last_ms          = 0;  // Time of the last successful attempt
+    uint32_t max_ms           = 0;
+    uint64_t total_ms         = 0;
+
+    uint32_t average_ms() const { return connects ? total_ms / connects : 0; }
+};
+
+// Opens a TCP connection as a series of short steps, so that a
+// reconnect never holds up the main loop.  poll() only checks on the
+// resolver and makes non-blocking socket calls.  Numeric
+// addresses skip the resolver, and resolved names are cached for
+// RESOLVE_CACHE_TTL_MS.  A cached address that fails to connect is
+// dropped, in case the controller has a new one.
+//
+// Times are passed in, so the state machine can be tested on the
+// host against a local listener.
+class AsyncConnector {
+public:
+    enum state_t {
+        IDLE,
+        BACKOFF,
+        RESOLVING,
+        CONNECTING,
+        CONNECTED,
+    };
+
+private:
+    HostResolver* _resolver;
+    std::string   _host;
+    uint16_t      _port  = 0;
+    state_t       _state = IDLE;
+    int           _fd    = -1;
+
+    uint32_t _stepStart     = 0;
+    uint32_t _attemptStart  = 0;
+    uint32_t _retryAt       = 0;
+    uint32_t _retryInterval = CONNECT_RETRY_MIN_MS;
+
+    bool     _cacheValid   = false;
+    uint32_t _cachedIp     = 0;
+    uint32_t _cacheExpires = 0;
+    bool     _usingCache   = false;
+
+    void beginAttempt(uint32_t now_ms);
+    void openSocket(uint32_t ipv4, uint32_t now_ms);
+    bool checkSocket(uint32_t now_ms);
+    bool succeed(uint32_t now_ms);
+    void fail(uint32_t now_ms);
+    void closeSocket();
+
+public:
+    connect_stats_t stats;
+
+    AsyncConnector(HostResolver* resolver) : _resolver(resolver) {}
+    ~AsyncConnector();
+
+    // Changing the host forgets the cached address
+    void setHost(const char* host, uint16_t port);
+
+    // Starts the first attempt on the next poll()
+    void start(uint32_t now_ms);
+
+    // Advances the state machine.  Returns true when a connection has
+    // just been made; takeSocket() then hands it over.
+    bool poll(uint32_t now_ms);
+
+    // Returns the connected, non-blocking socket, which the caller
+    // now owns
+    int takeSocket();
+
+    // The connection was lost; the next attempt starts at once
+    void lost(uint32_t now_ms);
+
+    void stop();
+
+    state_t            state() const { return _state; }
+    static const char* stateName(state_t state);
+};
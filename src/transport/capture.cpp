@@ -0,0 +1,186 @@
+// Copyright (c) 2023 Barton Dring
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "capture.h"
+#include <stdio.h>
+#include <string.h>
+
+CaptureWriter::CaptureWriter(CaptureOutput* out) : _out(out) {
+    static const char header[] = "# FluidDial capture v1: <us> <R|S> <bytes>\n";
+    if (_out) {
+        _out->write(header, sizeof(header) - 1);
+    }
+}
+
+void CaptureWriter::record(uint32_t t_us, char dir, const uint8_t* buf, size_t len) {
+    if (!_out || !len) {
+        return;
+    }
+    char prefix[16];
+    snprintf(prefix, sizeof(prefix), "%u %c ", (unsigned)t_us, dir);
+    _line = prefix;
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t c = buf[i];
+        switch (c) {
+            case '\\':
+                _line += "\\\\";
+                break;
+            case '\r':
+                _line += "\\r";
+                break;
+            case '\n':
+                _line += "\\n";
+                break;
+            default:
+                if (c < 0x20 || c >= 0x7f) {
+                    char hex[5];
+                    snprintf(hex, sizeof(hex), "\\x%02x", c);
+                    _line += hex;
+                } else {
+                    _line += (char)c;
+                }
+        }
+    }
+    _line += '\n';
+    _out->write(_line.data(), _line.size());
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+bool parse_capture_line(const char* line, size_t len, CaptureRecord& record) {
+    const char* end = line + len;
+    if (len == 0 || *line == '#') {
+        return false;
+    }
+    uint32_t t = 0;
+    const char* p = line;
+    while (p < end && *p >= '0' && *p <= '9') {
+        t = t * 10 + (*p++ - '0');
+    }
+    if (p == line || end - p < 3 || p[0] != ' ' || (p[1] != 'R' && p[1] != 'S') || p[2] != ' ') {
+        return false;
+    }
+    record.t_us = t;
+    record.dir  = p[1];
+    record.data.clear();
+    for (p += 3; p < end; ++p) {
+        if (*p != '\\' || p + 1 == end) {
+            record.data += *p;
+            continue;
+        }
+        switch (*++p) {
+            case 'r':
+                record.data += '\r';
+                break;
+            case 'n':
+                record.data += '\n';
+                break;
+            case 'x': {
+                int hi = p + 2 < end ? hex_digit(p[1]) : -1;
+                int lo = p + 2 < end ? hex_digit(p[2]) : -1;
+                if (hi < 0 || lo < 0) {
+                    return false;
+                }
+                record.data += (char)(hi << 4 | lo);
+                p += 2;
+                break;
+            }
+            default:
+                record.data += *p;
+        }
+    }
+    return true;
+}
+
+size_t load_capture(const char* text, size_t len, std::vector<CaptureRecord>& records) {
+    const char*   end = text + len;
+    size_t        n   = 0;
+    CaptureRecord record;
+    while (text < end) {
+        const char* nl = (const char*)memchr(text, '\n', end - text);
+        if (!nl) {
+            nl = end;
+        }
+        size_t line_len = nl - text;
+        if (line_len && text[line_len - 1] == '\r') {
+            --line_len;
+        }
+        if (parse_capture_line(text, line_len, record)) {
+            records.push_back(record);
+            ++n;
+        }
+        text = nl + 1;
+    }
+    return n;
+}
+
+CaptureTransport::CaptureTransport(Transport* io, bool owns_io, CaptureOutput* out, uint32_t (*now_us)()) :
+    _io(io), _owns_io(owns_io), _out(out), _writer(out), _now_us(now_us), _start(now_us()) {}
+
+CaptureTransport::~CaptureTransport() {
+    if (_owns_io) {
+        delete _io;
+    }
+    delete _out;
+}
+
+void CaptureTransport::flush() {
+    _io->flush();
+    if (_out) {
+        _out->flush();
+    }
+}
+
+void CaptureTransport::record(char dir, const uint8_t* buf, size_t len) {
+    _writer.record(_now_us() - _start, dir, buf, len);
+}
+
+void CaptureTransport::sendLine(const char* line, int timeout) {
+    _io->sendLine(line, timeout);
+    if (line) {
+        std::string s(line);
+        s += '\n';
+        record('S', (const uint8_t*)s.data(), s.size());
+    }
+}
+
+void CaptureTransport::sendRT(uint8_t c) {
+    _io->sendRT(c);
+    record('S', &c, 1);
+}
+
+int CaptureTransport::getChar() {
+    int c = _io->getChar();
+    if (c >= 0) {
+        uint8_t b = c;
+        record('R', &b, 1);
+    }
+    return c;
+}
+
+size_t CaptureTransport::read(uint8_t* buf, size_t max) {
+    size_t len = _io->read(buf, max);
+    record('R', buf, len);
+    return len;
+}
+
+void CaptureTransport::putChar(uint8_t c) {
+    _io->putChar(c);
+    record('S', &c, 1);
+}
+
+void CaptureTransport::write(const uint8_t* buf, size_t len) {
+    _io->write(buf, len);
+    record('S', buf, len);
+}
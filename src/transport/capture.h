@@ -0,0 +1,79 @@
+// Copyright (c) 2023 Barton Dring
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include "transport.h"
+#include <string>
+#include <vector>
+
+// Traffic captures, one text line per transport read or write:
+//
+//   <microseconds since start> <R|S> <bytes>
+//
+// R is data received from FluidNC and S is data the pendant sent.  In
+// the bytes, backslash, CR, LF and anything outside printable ASCII are
+// written as \\, \r, \n and \xHH.  Lines starting with # are comments.
+
+struct CaptureRecord {
+    uint32_t    t_us;
+    char        dir;  // 'R' or 'S'
+    std::string data;
+};
+
+// Where a capture is written
+class CaptureOutput {
+public:
+    virtual ~CaptureOutput() = default;
+    virtual void write(const char* s, size_t len) = 0;
+    virtual void flush() {}
+};
+
+class CaptureWriter {
+private:
+    CaptureOutput* _out;
+    std::string    _line;
+
+public:
+    CaptureWriter(CaptureOutput* out);
+    void record(uint32_t t_us, char dir, const uint8_t* buf, size_t len);
+};
+
+// Returns false for comments, blank lines and malformed lines
+bool parse_capture_line(const char* line, size_t len, CaptureRecord& record);
+
+// Parses a whole capture and returns the number of records
+size_t load_capture(const char* text, size_t len, std::vector<CaptureRecord>& records);
+
+// Passes everything through to another transport and writes it to a
+// capture.  Times are relative to when this object was made.
+class CaptureTransport : public Transport {
+private:
+    Transport*     _io;
+    bool           _owns_io;
+    CaptureOutput* _out;
+    CaptureWriter  _writer;
+    uint32_t (*_now_us)();
+    uint32_t _start;
+
+    void record(char dir, const uint8_t* buf, size_t len);
+
+public:
+    // Takes ownership of out, and of io if owns_io is set
+    CaptureTransport(Transport* io, bool owns_io, CaptureOutput* out, uint32_t (*now_us)());
+    ~CaptureTransport();
+
+    bool     begin() override { return _io->begin(); }
+    void     loop() override { _io->loop(); }
+    bool     isConnected() override { return _io->isConnected(); }
+    void     sendLine(const char* line, int timeout = 2000) override;
+    void     sendRT(uint8_t c) override;
+    int      getChar() override;
+    size_t   read(uint8_t* buf, size_t max) override;
+    void     putChar(uint8_t c) override;
+    void     write(const uint8_t* buf, size_t len) override;
+    void     resetFlowControl() override { _io->resetFlowControl(); }
+    bool     waitForData(int timeout_ms) override { return _io->waitForData(timeout_ms); }
+    void     flush() override;
+    uint32_t linesSent() override { return _io->linesSent(); }
+};
@@ -0,0 +1,128 @@
+// Copyright (c) 2023 Barton Dring
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#ifdef ARDUINO
+
+#include "comms_task.h"
+#include "System.h"
+
+// The Arduino loop runs on APP_CPU (core 1)
+static const BaseType_t comms_core     = 0;
+static const UBaseType_t comms_priority = 5;
+
+bool CommsTask::begin() {
+    if (!_io.begin()) {
+        return false;
+    }
+    if (!_started) {
+        _started = true;
+        xTaskCreatePinnedToCore(task, "comms", 4096, this, comms_priority, &_task, comms_core);
+    }
+    return true;
+}
+
+void CommsTask::task(void* arg) {
+    static_cast<CommsTask*>(arg)->run();
+}
+
+void CommsTask::run() {
+    while (true) {
+        _io.loop();
+        if (_resetFlow.exchange(false, std::memory_order_acquire)) {
+            _io.resetFlowControl();
+        }
+        bool busy = drainTx();
+        busy |= fillRx();
+        _io.flush();
+        if (!busy && !_io.waitForData(1)) {
+            vTaskDelay(1);
+        }
+    }
+}
+
+// Moves as much received data as the RX queue can hold.  When the queue
+// is full the bytes stay in the driver, so UART flow control still works.
+bool CommsTask::fillRx() {
+    uint8_t block[256];
+    size_t  room = _rx.space();
+    if (room == 0) {
+        ++rxStalls;
+        return false;
+    }
+    size_t len = _io.read(block, room < sizeof(block) ? room : sizeof(block));
+    if (len) {
+        _rx.write(block, len);
+        return true;
+    }
+    return false;
+}
+
+// Adapts the wrapped transport to what TxLanes sends to
+class TransportSink : public TxSink {
+private:
+    Transport& _io;
+
+public:
+    TransportSink(Transport& io) : _io(io) {}
+    void sendRT(uint8_t c) override { _io.sendRT(c); }
+    void sendLine(const char* line) override { _io.sendLine(line); }
+    void write(const uint8_t* buf, size_t len) override { _io.write(buf, len); }
+};
+
+bool CommsTask::drainTx() {
+    TransportSink sink(_io);
+    return _tx.service(sink, microseconds);
+}
+
+// Waits up to timeout_ms for room in the normal lane.  This only happens
+// when the transport cannot keep up, such as while FluidNC holds XOFF.
+bool CommsTask::enqueue(TxLanes::kind_t kind, const uint8_t* buf, size_t len, int timeout_ms) {
+    uint32_t start = millis();
+    while (!_tx.roomForLine(len)) {
+        if ((int)(millis() - start) >= timeout_ms) {
+            break;  // pushLine() counts the drop
+        }
+        vTaskDelay(1);
+    }
+    return _tx.pushLine(kind, buf, len, microseconds());
+}
+
+void CommsTask::sendLine(const char* line, int timeout) {
+    if (!line) {
+        return;
+    }
+    const size_t max = TxLanes::max_record;
+    size_t       len = strlen(line);
+    while (len > max) {
+        enqueue(TxLanes::RAW, (const uint8_t*)line, max, timeout);
+        line += max;
+        len -= max;
+    }
+    enqueue(TxLanes::LINE, (const uint8_t*)line, len, timeout);
+}
+
+// The urgent lane holds more than any burst the UI sends, so this only
+// waits if the task has stalled.  pushRT() counts a byte that still
+// does not fit.
+void CommsTask::sendRT(uint8_t c) {
+    uint32_t start = millis();
+    while (!_tx.roomForRT() && (millis() - start) < 100) {
+        vTaskDelay(1);
+    }
+    _tx.pushRT(c, microseconds());
+}
+
+void CommsTask::putChar(uint8_t c) {
+    enqueue(TxLanes::RAW, &c, 1, 100);
+}
+
+void CommsTask::write(const uint8_t* buf, size_t len) {
+    while (len) {
+        size_t chunk = len < TxLanes::max_record ? len : TxLanes::max_record;
+        enqueue(TxLanes::RAW, buf, chunk, 100);
+        buf += chunk;
+        len -= chunk;
+    }
+}
+
+#endif  // ARDUINO
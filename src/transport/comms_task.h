@@ -0,0 +1,73 @@
+// Copyright (c) 2023 Barton Dring
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#ifdef ARDUINO
+
+#include "transport.h"
+#include "ring_buffer.h"
+#include "tx_lanes.h"
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Received bytes waiting for the parser.  At 1 Mbaud this covers about
+// 80 ms of continuous traffic while the UI is busy rendering.
+#ifndef COMMS_RX_QUEUE_SIZE
+#define COMMS_RX_QUEUE_SIZE 8192
+#endif
+
+// Runs a transport's I/O in its own FreeRTOS task, pinned to the core
+// that the Arduino loop does not use, so a long render or SPI push on
+// the UI side never stalls the receive path.
+//
+// The UI sees this object as its Transport.  Received bytes reach it
+// through an RX queue, and what it sends goes through TxLanes, where
+// realtime bytes overtake queued lines.  The queues are single-producer,
+// single-consumer ring buffers, so neither side takes a lock.  The
+// parser and the model stay on the UI task, so the GrblParser callbacks
+// never race with drawing.
+class CommsTask : public Transport {
+private:
+    Transport&   _io;
+    TaskHandle_t _task    = nullptr;
+    bool         _started = false;
+
+    RingBuffer<COMMS_RX_QUEUE_SIZE> _rx;
+    TxLanes                         _tx;
+
+    // Set by the UI; the task resets the transport's flow control so
+    // that only the task touches the UART
+    std::atomic<bool> _resetFlow { false };
+
+    bool enqueue(TxLanes::kind_t kind, const uint8_t* buf, size_t len, int timeout_ms);
+    bool drainTx();
+    bool fillRx();
+    void run();
+
+    static void task(void* arg);
+
+public:
+    CommsTask(Transport& io) : _io(io) {}
+
+    bool begin() override;
+    void loop() override {}  // The task does the work
+    bool isConnected() override { return _io.isConnected(); }
+    void sendLine(const char* line, int timeout = 2000) override;
+    void sendRT(uint8_t c) override;
+    int  getChar() override { return _rx.getChar(); }
+    size_t read(uint8_t* buf, size_t max) override { return _rx.read(buf, max); }
+    void putChar(uint8_t c) override;
+    void write(const uint8_t* buf, size_t len) override;
+    void resetFlowControl() override { _resetFlow.store(true, std::memory_order_release); }
+    uint32_t linesSent() override { return _io.linesSent(); }
+
+    // Queue statistics, including the enqueue-to-transport latency of
+    // realtime bytes and lines
+    uint32_t       rxStalls = 0;  // Times the RX queue was full, pushing back on the transport
+    size_t         rxHighWater() const { return _rx.high_water; }
+    const TxLanes& txLanes() const { return _tx; }
+};
+
+#endif  // ARDUINO
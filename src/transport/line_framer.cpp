@@ -0,0 +1,64 @@
+// Copyright (c) 2023 Barton Dring
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "line_framer.h"
+#include <string.h>
+
+static_assert(LINE_FRAMER_SIZE > LineFramer::max_line, "LINE_FRAMER_SIZE must hold more than one line");
+
+uint8_t* LineFramer::reserve(size_t& room) {
+    if (_head) {
+        // Normally only a partial line is left, so this copies little
+        size_t held = _tail - _head;
+        memmove(_buf, _buf + _head, held);
+        _ready -= _head;
+        _tail = held;
+        _head = 0;
+    }
+    room = sizeof(_buf) - _tail;
+    return _buf + _tail;
+}
+
+size_t LineFramer::commit(size_t len) {
+    size_t   found = 0;
+    uint8_t* p     = _buf + _tail;
+    uint8_t* end   = p + len;
+    _tail += len;
+
+    // memchr is word-at-a-time, so this is far cheaper than testing
+    // each byte as it is handed out
+    while (p < end) {
+        uint8_t* nl = (uint8_t*)memchr(p, '\n', end - p);
+        if (!nl) {
+            break;
+        }
+        p = nl + 1;
+        ++found;
+    }
+    if (found) {
+        _ready = p - _buf;
+        lines += found;
+    }
+    if (partial() >= max_line) {
+        _ready = _tail;
+        ++overlong;
+    }
+    return found;
+}
+
+size_t LineFramer::push(const uint8_t* buf, size_t len) {
+    size_t found = 0;
+    while (len) {
+        size_t   room;
+        uint8_t* dst = reserve(room);
+        if (room == 0) {
+            break;  // The caller has not taken the complete lines
+        }
+        size_t n = len < room ? len : room;
+        memcpy(dst, buf, n);
+        found += commit(n);
+        buf += n;
+        len -= n;
+    }
+    return found;
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2023 Barton Dring
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Received bytes held while their line is incomplete
+#ifndef LINE_FRAMER_SIZE
+#define LINE_FRAMER_SIZE 2048
+#endif
+
+// Splits the received byte stream into lines.  The transport reads
+// straight into the framer's buffer with reserve() and commit(), and
+// the parser takes bytes with getChar() only up to the end of the last
+// complete line, so it never stops halfway through a line and the
+// caller can do per-line work, like noting the RX time, when it sees
+// the terminator.
+//
+// A partial line longer than max_line is released as is, so a missing
+// terminator cannot fill the buffer.  release_partial() does the same
+// for a line that has stopped arriving.
+class LineFramer {
+public:
+    static const size_t max_line = 512;
+
+private:
+    uint8_t _buf[LINE_FRAMER_SIZE];
+    size_t  _head  = 0;  // Next byte for getChar()
+    size_t  _ready = 0;  // End of the complete lines
+    size_t  _tail  = 0;  // End of the received bytes
+
+public:
+    uint32_t lines    = 0;  // Terminators seen
+    uint32_t overlong = 0;  // Partial lines released at max_line
+
+    // Returns where up to room bytes can be stored, after moving the
+    // unread bytes to the front.  Call it once getChar() returns -1.
+    uint8_t* reserve(size_t& room);
+
+    // Accepts len bytes stored at the reserve() pointer.  Returns the
+    // number of lines they completed.
+    size_t commit(size_t len);
+
+    // Copies len bytes in, for callers that already have them in memory.
+    // Returns the number of lines completed.  Bytes that do not fit are
+    // dropped.
+    size_t push(const uint8_t* buf, size_t len);
+
+    // Next byte of a complete line, or -1
+    int getChar() { return _head < _ready ? _buf[_head++] : -1; }
+
+    size_t ready() const { return _ready - _head; }
+    size_t partial() const { return _tail - _ready; }
+
+    void release_partial() { _ready = _tail; }
+    void clear() { _head = _ready = _tail = 0; }
+};
@@ -0,0 +1,74 @@
+// Copyright (c) 2023 Barton Dring
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "replay_transport.h"
+#include <string.h>
+
+ReplayTransport::ReplayTransport(const std::vector<CaptureRecord>& records, mode_t mode, uint32_t (*now_us)()) :
+    _records(records), _mode(mode), _now_us(now_us) {}
+
+bool ReplayTransport::begin() {
+    _start  = _now_us();
+    _next   = 0;
+    _offset = 0;
+    sent.clear();
+    return true;
+}
+
+// The capture's own S records are only a reference; what this pendant
+// sends is in sent
+void ReplayTransport::skipSent() {
+    while (_next < _records.size() && _records[_next].dir != 'R') {
+        ++_next;
+    }
+}
+
+bool ReplayTransport::finished() {
+    skipSent();
+    return _next == _records.size();
+}
+
+size_t ReplayTransport::read(uint8_t* buf, size_t max) {
+    uint32_t elapsed = _now_us() - _start;
+    size_t   n       = 0;
+    while (n < max) {
+        skipSent();
+        if (_next == _records.size()) {
+            break;
+        }
+        const CaptureRecord& record = _records[_next];
+        if (_mode == TIMED && record.t_us > elapsed) {
+            break;
+        }
+        size_t len = record.data.size() - _offset;
+        if (len > max - n) {
+            len = max - n;
+        }
+        memcpy(buf + n, record.data.data() + _offset, len);
+        n += len;
+        _offset += len;
+        if (_offset == record.data.size()) {
+            _offset = 0;
+            ++_next;
+        }
+    }
+    return n;
+}
+
+int ReplayTransport::getChar() {
+    uint8_t c;
+    return read(&c, 1) ? c : -1;
+}
+
+void ReplayTransport::recordSent(const uint8_t* buf, size_t len) {
+    sent.push_back({ _now_us() - _start, 'S', std::string((const char*)buf, len) });
+}
+
+void ReplayTransport::sendLine(const char* line, int /*timeout*/) {
+    if (line) {
+        std::string s(line);
+        s += '\n';
+        recordSent((const uint8_t*)s.data(), s.size());
+        _linesSent.fetch_add(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2023 Barton Dring
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include "transport.h"
+#include "capture.h"
+
+// Plays back the FluidNC side of a capture, so the parser, model and
+// scenes can be driven with real traffic off the hardware.  TIMED
+// releases each received block at its captured time after begin();
+// MAX_SPEED releases everything at once.  What the pendant sends is
+// kept in sent, in the same record format.
+class ReplayTransport : public Transport {
+public:
+    enum mode_t {
+        TIMED,
+        MAX_SPEED,
+    };
+
+private:
+    std::vector<CaptureRecord> _records;
+    mode_t                     _mode;
+    uint32_t (*_now_us)();
+    uint32_t _start  = 0;
+    size_t   _next   = 0;  // Index of the next record to deliver
+    size_t   _offset = 0;  // Bytes of it already delivered
+
+    void skipSent();
+    void recordSent(const uint8_t* buf, size_t len);
+
+public:
+    std::vector<CaptureRecord> sent;
+
+    ReplayTransport(const std::vector<CaptureRecord>& records, mode_t mode, uint32_t (*now_us)());
+
+    bool   begin() override;
+    void   loop() override {}
+    bool   isConnected() override { return true; }
+    void   sendLine(const char* line, int timeout = 2000) override;
+    void   sendRT(uint8_t c) override { recordSent(&c, 1); }
+    int    getChar() override;
+    size_t read(uint8_t* buf, size_t max) override;
+    void   putChar(uint8_t c) override { recordSent(&c, 1); }
+    void   write(const uint8_t* buf, size_t len) override { recordSent(buf, len); }
+    void   resetFlowControl() override {}
+
+    // True when every received record has been delivered
+    bool finished();
+
+    // Captured time of the last record, for sizing a timed run
+    uint32_t duration_us() const { return _records.empty() ? 0 : _records.back().t_us; }
+};
@@ -0,0 +1,96 @@
+// Copyright (c) 2023 Barton Dring
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Fixed-capacity byte FIFO for one producer and one consumer.
+// The producer only writes _head and the consumer only writes _tail,
+// so the two sides can run in different tasks without a lock.
+// Capacity must be a power of two.
+//
+// Bytes that do not fit are dropped and counted in overflow_bytes,
+// because a receive callback has nowhere to wait.
+template <size_t Capacity>
+class RingBuffer {
+    static_assert((Capacity & (Capacity - 1)) == 0, "RingBuffer capacity must be a power of two");
+
+private:
+    uint8_t             _data[Capacity];
+    std::atomic<size_t> _head { 0 };  // Total bytes ever written
+    std::atomic<size_t> _tail { 0 };  // Total bytes ever read
+
+public:
+    uint32_t overflow_bytes  = 0;
+    uint32_t overflow_events = 0;
+    size_t   high_water      = 0;
+
+    size_t capacity() const { return Capacity; }
+    size_t available() const { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed); }
+    size_t space() const { return Capacity - (_head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire)); }
+
+    // Producer side.  Returns the number of bytes stored.
+    size_t write(const uint8_t* buf, size_t len) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t room = Capacity - (head - _tail.load(std::memory_order_acquire));
+        if (len > room) {
+            overflow_bytes += len - room;
+            ++overflow_events;
+            len = room;
+        }
+        size_t start = head & (Capacity - 1);
+        size_t first = Capacity - start;
+        if (first > len) {
+            first = len;
+        }
+        memcpy(_data + start, buf, first);
+        memcpy(_data, buf + first, len - first);
+        _head.store(head + len, std::memory_order_release);
+
+        size_t used = Capacity - room + len;
+        if (used > high_water) {
+            high_water = used;
+        }
+        return len;
+    }
+
+    // Consumer side.  Copies buffered bytes without consuming them.
+    size_t peek(uint8_t* buf, size_t max) const {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t len  = _head.load(std::memory_order_acquire) - tail;
+        if (len > max) {
+            len = max;
+        }
+        size_t start = tail & (Capacity - 1);
+        size_t first = Capacity - start;
+        if (first > len) {
+            first = len;
+        }
+        memcpy(buf, _data + start, first);
+        memcpy(buf + first, _data, len - first);
+        return len;
+    }
+
+    // Consumer side.  Returns the number of bytes copied into buf.
+    size_t read(uint8_t* buf, size_t max) {
+        size_t len = peek(buf, max);
+        _tail.store(_tail.load(std::memory_order_relaxed) + len, std::memory_order_release);
+        return len;
+    }
+
+    int getChar() {
+        uint8_t c;
+        return read(&c, 1) ? c : -1;
+    }
+
+    // Bytes ever written and read, for marking a position in the stream
+    size_t total_written() const { return _head.load(std::memory_order_acquire); }
+    size_t total_read() const { return _tail.load(std::memory_order_relaxed); }
+
+    // Consumer side; discards everything currently buffered
+    void clear() { _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release); }
+};
@@ -6,6 +6,146 @@
 #include "telnet_transport.h"
 #include "System.h"
 #include <ESPmDNS.h>
+#include <mdns.h>
+#include <lwip/dns.h>
+#include <fcntl.h>
+
+// How long an mDNS query listens for answers
+static const uint32_t mdns_query_ms = 2000;
+
+// lwIP answers DNS lookups on its own task.  The answer is tagged
+// with the lookup's generation so that a late answer to a cancelled
+// lookup is ignored.
+static volatile uint32_t dns_generation = 0;
+static volatile bool     dns_done       = false;
+static volatile uint32_t dns_address    = 0;
+
+static void dns_found(const char* name, const ip_addr_t* ipaddr, void* arg) {
+    if ((uint32_t)(uintptr_t)arg != dns_generation) {
+        return;
+    }
+    dns_address = (ipaddr && IP_IS_V4(ipaddr)) ? ip4_addr_get_u32(ip_2_ip4(ipaddr)) : 0;
+    dns_done    = true;
+}
+
+EspHostResolver::~EspHostResolver() {
+    cancel();
+}
+
+// Returns false while the search is still running.  mdns 1.x, with
+// ESP-IDF 5, also returns the number of results.
+static bool search_results(void* search, mdns_result_t** results) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+    uint8_t num_results;
+    return mdns_query_async_get_results((mdns_search_once_t*)search, 0, results, &num_results);
+#else
+    return mdns_query_async_get_results((mdns_search_once_t*)search, 0, results);
+#endif
+}
+
+// A search can only be deleted once it has finished
+static bool finish_search(void* search) {
+    mdns_result_t* results = nullptr;
+    if (!search_results(search, &results)) {
+        return false;
+    }
+    mdns_query_results_free(results);
+    mdns_query_async_delete((mdns_search_once_t*)search);
+    return true;
+}
+
+bool EspHostResolver::reapStale() {
+    if (_mdnsStale && finish_search(_mdnsStale)) {
+        _mdnsStale = nullptr;
+    }
+    return _mdnsStale == nullptr;
+}
+
+bool EspHostResolver::start(const char* host) {
+    cancel();
+
+    size_t len = strlen(host);
+    if (len > 6 && strcmp(host + len - 6, ".local") == 0) {
+        static bool mdns_started = false;
+        if (!mdns_started) {
+            if (!MDNS.begin("fluiddial")) {
+                dbg_printf("TelnetTransport: mDNS initialization failed\n");
+                return false;
+            }
+            mdns_started = true;
+        }
+        if (!reapStale()) {
+            return false;  // The last cancelled search is still running
+        }
+        std::string name(host, len - 6);
+#if ESP_IDF_VERSION_MAJOR >= 5
+        _mdnsSearch = mdns_query_async_new(name.c_str(), nullptr, nullptr, MDNS_TYPE_A, mdns_query_ms, 1, nullptr);
+#else
+        _mdnsSearch = mdns_query_async_new(name.c_str(), nullptr, nullptr, MDNS_TYPE_A, mdns_query_ms, 1);
+#endif
+        return _mdnsSearch != nullptr;
+    }
+
+    ip_addr_t addr;
+    uint32_t  generation = ++dns_generation;
+    dns_done             = false;
+    switch (dns_gethostbyname(host, &addr, dns_found, (void*)(uintptr_t)generation)) {
+        case ERR_OK:  // Already in lwIP's cache
+            dns_found(host, &addr, (void*)(uintptr_t)generation);
+            break;
+        case ERR_INPROGRESS:
+            break;
+        default:
+            return false;
+    }
+    _dnsPending = true;
+    return true;
+}
+
+HostResolver::result_t EspHostResolver::poll(uint32_t& ipv4) {
+    if (_mdnsSearch) {
+        mdns_result_t* results = nullptr;
+        if (!search_results(_mdnsSearch, &results)) {
+            return PENDING;
+        }
+        result_t result = FAILED;
+        for (mdns_result_t* r = results; r && result != DONE; r = r->next) {
+            for (mdns_ip_addr_t* a = r->addr; a; a = a->next) {
+                if (a->addr.type == ESP_IPADDR_TYPE_V4) {
+                    ipv4   = a->addr.u_addr.ip4.addr;
+                    result = DONE;
+                    break;
+                }
+            }
+        }
+        mdns_query_results_free(results);
+        mdns_query_async_delete((mdns_search_once_t*)_mdnsSearch);
+        _mdnsSearch = nullptr;
+        return result;
+    }
+    if (_dnsPending) {
+        if (!dns_done) {
+            return PENDING;
+        }
+        _dnsPending = false;
+        ipv4        = dns_address;
+        return ipv4 ? DONE : FAILED;
+    }
+    return FAILED;
+}
+
+void EspHostResolver::cancel() {
+    if (_mdnsSearch) {
+        if (!finish_search(_mdnsSearch) && reapStale()) {
+            _mdnsStale = _mdnsSearch;
+        }
+        _mdnsSearch = nullptr;
+    }
+    if (_dnsPending) {
+        ++dns_generation;
+        _dnsPending = false;
+    }
+}
 
 TelnetTransport::TelnetTransport(const char* host, int port) : _host(host), _port(port) {
 }
@@ -19,6 +159,7 @@ TelnetTransport::~TelnetTransport() {
 void TelnetTransport::setHost(const char* host, int port) {
     _host = host;
     _port = port;
+    _connector.setHost(host, port);
 }
 
 bool TelnetTransport::begin() {
@@ -30,10 +171,11 @@ bool TelnetTransport::begin() {
     dbg_printf("TelnetTransport: Connecting to %s:%d\n", _host.c_str(), _port);
     
     _initialized = true;
-    _lastReconnectAttempt = millis();
-    
-    // Attempt initial connection
-    attemptReconnect();
+    _connector.setHost(_host.c_str(), _port);
+    _connector.start(millis());
+
+    // The first attempt starts here but completes in later loop() calls
+    pollConnector();
     
     return true;
 }
@@ -43,17 +185,20 @@ void TelnetTransport::loop() {
         return;
     }
     
+    flush();
+
     // Check if client is still connected
     bool wasConnected = _connected;
     if (_connected && !_client.connected()) {
         _connected = false;
         _client.stop();
+        _connector.lost(millis());
         dbg_printf("TelnetTransport: Connection lost\n");
     }
     
     // Handle reconnection
     if (!_connected && WiFi.isConnected()) {
-        attemptReconnect();
+        pollConnector();
     }
     
     // Trigger UI update if connection state changed
@@ -63,77 +208,74 @@ void TelnetTransport::loop() {
     }
 }
 
-void TelnetTransport::attemptReconnect() {
-    unsigned long now = millis();
-    if (now - _lastReconnectAttempt >= _reconnectInterval) {
-        dbg_printf("TelnetTransport: Attempting reconnect to %s:%d\n", _host.c_str(), _port);
-        
-        // Check if hostname ends with .local and attempt mDNS resolution first
-        bool connectionSuccess = false;
-        if (_host.endsWith(".local")) {
-            IPAddress mdnsIP = resolveMdnsHost(_host.c_str());
-            if (mdnsIP != INADDR_NONE) {
-                dbg_printf("TelnetTransport: mDNS resolved %s to %s\n", _host.c_str(), mdnsIP.toString().c_str());
-                connectionSuccess = _client.connect(mdnsIP, _port);
-            } else {
-                dbg_printf("TelnetTransport: mDNS resolution failed, trying DNS\n");
-                connectionSuccess = _client.connect(_host.c_str(), _port);
-            }
-        } else {
-            connectionSuccess = _client.connect(_host.c_str(), _port);
-        }
-        
-        if (connectionSuccess) {
-            bool wasConnected = _connected;
-            _connected = true;
-            _reconnectInterval = 2000; // Reset reconnect interval on successful connection
-            dbg_printf("TelnetTransport: Connected successfully\n");
-            
-            // Trigger UI update if connection state changed
-            if (!wasConnected) {
-                extern void trigger_status_redraw();
-                trigger_status_redraw();
-            }
-        } else {
-            _connected = false;
-            // Exponential backoff, but cap at max interval
-            _reconnectInterval = min(_reconnectInterval * 2, _maxReconnectInterval);
-            dbg_printf("TelnetTransport: Connection failed, retry in %lu ms\n", _reconnectInterval);
-        }
-        
-        _lastReconnectAttempt = now;
+void TelnetTransport::pollConnector() {
+    auto before = _connector.state();
+    if (_connector.poll(millis())) {
+        // WiFiClient expects a blocking socket, as its own connect() leaves it
+        int fd = _connector.takeSocket();
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+        _client    = WiFiClient(fd);
+        _connected = true;
+        _txLength  = 0;
+
+        auto& stats = _connector.stats;
+        dbg_printf("TelnetTransport: Connected in %u ms, avg %u max %u over %u connects\n",
+                   stats.last_ms,
+                   stats.average_ms(),
+                   stats.max_ms,
+                   stats.connects);
+        return;
     }
+    auto after = _connector.state();
+    if (after != before && after == AsyncConnector::BACKOFF) {
+        dbg_printf("TelnetTransport: Connection to %s:%d failed, %u attempts\n", _host.c_str(), _port, _connector.stats.attempts);
+    }
+}
+
+bool TelnetTransport::isConnected() {
+    return _connected && _client.connected() && WiFi.isConnected();
 }
 
-IPAddress TelnetTransport::resolveMdnsHost(const char* hostname) {
-    // Initialize mDNS if not already done
-    if (!MDNS.begin("fluiddial")) {
-        dbg_printf("TelnetTransport: mDNS initialization failed\n");
-        return INADDR_NONE;
+void TelnetTransport::writeNow(const uint8_t* buf, size_t len) {
+    _client.write(buf, len);
+    ++_txWrites;
+    _txBytes += len;
+    // Lines are counted as they go out, so the ones dropped by a
+    // JogCancel or a lost connection are not
+    for (const uint8_t* end = buf + len; (buf = (const uint8_t*)memchr(buf, '\n', end - buf)) != nullptr; ++buf) {
+        _linesSent.fetch_add(1, std::memory_order_release);
     }
-    
-    // Extract hostname without .local suffix for mDNS query
-    String hostWithoutLocal = String(hostname);
-    if (hostWithoutLocal.endsWith(".local")) {
-        hostWithoutLocal = hostWithoutLocal.substring(0, hostWithoutLocal.length() - 6);
+}
+
+void TelnetTransport::stage(const uint8_t* buf, size_t len) {
+    if (_txLength + len > sizeof(_txBuffer)) {
+        flush();
     }
-    
-    dbg_printf("TelnetTransport: Resolving mDNS hostname: %s\n", hostWithoutLocal.c_str());
-    
-    // Query mDNS for the hostname
-    IPAddress serverIP = MDNS.queryHost(hostWithoutLocal);
-    
-    if (serverIP == INADDR_NONE) {
-        dbg_printf("TelnetTransport: mDNS query failed for %s\n", hostWithoutLocal.c_str());
-    } else {
-        dbg_printf("TelnetTransport: mDNS resolved %s to %s\n", hostWithoutLocal.c_str(), serverIP.toString().c_str());
+    if (len > sizeof(_txBuffer)) {
+        writeNow(buf, len);
+        return;
     }
-    
-    return serverIP;
+    if (_txLength == 0) {
+        _txStagedUs = micros();
+    }
+    memcpy(_txBuffer + _txLength, buf, len);
+    _txLength += len;
 }
 
-bool TelnetTransport::isConnected() {
-    return _connected && _client.connected() && WiFi.isConnected();
+void TelnetTransport::flush() {
+    if (_txLength == 0) {
+        return;
+    }
+    if (isConnected()) {
+        writeNow(_txBuffer, _txLength);
+        uint32_t latency = micros() - _txStagedUs;
+        _lineLatencyTotalUs += latency;
+        if (latency > _lineLatencyMaxUs) {
+            _lineLatencyMaxUs = latency;
+        }
+        ++_flushes;
+    }
+    _txLength = 0;
 }
 
 void TelnetTransport::sendLine(const char* line, int timeout) {
@@ -141,10 +283,9 @@ void TelnetTransport::sendLine(const char* line, int timeout) {
         return;
     }
     
-    // Send line with single newline appended
-    _client.print(line);
-    _client.print('\n');
-    _client.flush();
+    // Send line with single newline appended, on the next flush
+    stage((const uint8_t*)line, strlen(line));
+    stage((const uint8_t*)"\n", 1);
     
     dbg_printf("TelnetTransport: Sent line: %s\n", line);
 }
@@ -154,9 +295,13 @@ void TelnetTransport::sendRT(uint8_t c) {
         return;
     }
     
-    // Send single byte
-    _client.write(c);
-    _client.flush();
+    // Realtime bytes go out immediately, ahead of any staged lines.
+    // WiFiClient::flush() would discard received data, so it is not used.
+    if (c == TxLanes::jog_cancel) {
+        _txLength = drop_jog_lines(_txBuffer, _txLength, _jogDropped);
+    }
+    writeNow(&c, 1);
+    ++_rtSent;
     
     dbg_printf("TelnetTransport: Sent RT: 0x%02X\n", c);
 }
@@ -173,12 +318,28 @@ int TelnetTransport::getChar() {
     return -1; // No data available
 }
 
+size_t TelnetTransport::read(uint8_t* buf, size_t max) {
+    if (!isConnected() || !_client.available()) {
+        return 0;
+    }
+    int len = _client.read(buf, max);
+    return len > 0 ? len : 0;
+}
+
 void TelnetTransport::putChar(uint8_t c) {
     if (!isConnected()) {
         return;
     }
     
-    _client.write(c);
+    stage(&c, 1);
+}
+
+void TelnetTransport::write(const uint8_t* buf, size_t len) {
+    if (!isConnected()) {
+        return;
+    }
+
+    stage(buf, len);
 }
 
 void TelnetTransport::resetFlowControl() {
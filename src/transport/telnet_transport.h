@@ -6,8 +6,27 @@
 #ifdef USE_WIFI_PENDANT
 
 #include "transport.h"
+#include "async_connect.h"
+#include "tx_lanes.h"
 #include <WiFi.h>
-#include <ESPmDNS.h>
+
+// Resolves .local names with an asynchronous mDNS query and other
+// names with lwIP's asynchronous DNS lookup
+class EspHostResolver : public HostResolver {
+private:
+    void* _mdnsSearch = nullptr;
+    void* _mdnsStale  = nullptr;  // Cancelled, waiting to finish
+    bool  _dnsPending = false;
+
+    bool reapStale();
+
+public:
+    ~EspHostResolver();
+
+    bool     start(const char* host) override;
+    result_t poll(uint32_t& ipv4) override;
+    void     cancel() override;
+};
 
 // Telnet transport implementation for FluidNC communication
 class TelnetTransport : public Transport {
@@ -17,12 +36,30 @@ private:
     bool _initialized = false;
     String _host;
     int _port;
-    unsigned long _lastReconnectAttempt = 0;
-    unsigned long _reconnectInterval = 2000; // Start with 2s  
-    const unsigned long _maxReconnectInterval = 10000; // Max 10s for faster recovery
-    
-    void attemptReconnect();
-    IPAddress resolveMdnsHost(const char* hostname);
+
+    // Reconnects one non-blocking step per loop() call
+    EspHostResolver _resolver;
+    AsyncConnector _connector { &_resolver };
+
+    // Lines are staged here and sent with one write() per loop iteration.
+    // Realtime bytes bypass the staging buffer, and a JogCancel discards
+    // the jog lines still staged.
+    uint8_t _txBuffer[512];
+    size_t _txLength = 0;
+    uint32_t _txStagedUs = 0; // When the oldest staged byte was queued
+
+    // Counters for measuring send latency and write calls
+    uint32_t _txWrites = 0;
+    uint32_t _txBytes = 0;
+    uint32_t _rtSent = 0;
+    uint32_t _jogDropped = 0;
+    uint32_t _flushes = 0;
+    uint32_t _lineLatencyMaxUs = 0;
+    uint64_t _lineLatencyTotalUs = 0;
+
+    void pollConnector();
+    void stage(const uint8_t* buf, size_t len);
+    void writeNow(const uint8_t* buf, size_t len);
     
 public:
     TelnetTransport(const char* host, int port);
@@ -35,11 +72,25 @@ public:
     void sendLine(const char* line, int timeout = 2000) override;
     void sendRT(uint8_t c) override;
     int getChar() override;
+    size_t read(uint8_t* buf, size_t max) override;
     void putChar(uint8_t c) override;
+    void write(const uint8_t* buf, size_t len) override;
+    void flush() override;
     void resetFlowControl() override;
     
     // Telnet specific methods
     void setHost(const char* host, int port);
+
+    // Send statistics
+    uint32_t txWrites() const { return _txWrites; }
+    uint32_t txBytes() const { return _txBytes; }
+    uint32_t rtSent() const { return _rtSent; }
+    uint32_t jogDropped() const { return _jogDropped; }
+    uint32_t lineLatencyMaxUs() const { return _lineLatencyMaxUs; }
+    uint32_t lineLatencyAvgUs() const { return _flushes ? _lineLatencyTotalUs / _flushes : 0; }
+
+    // Reconnect statistics
+    const connect_stats_t& connectStats() const { return _connector.stats; }
 };
 
 #endif // USE_WIFI_PENDANT
\ No newline at end of file
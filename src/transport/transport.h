@@ -3,7 +3,9 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
+#include <atomic>
 
 // Transport layer abstraction for FluidNC communication
 // Supports both UART (current) and WiFi (future) communication methods
@@ -18,8 +20,39 @@ public:
     virtual void sendLine(const char* line, int timeout = 2000) = 0;
     virtual void sendRT(uint8_t c) = 0;
     virtual int getChar() = 0;
+    // Copies up to max received bytes into buf and returns the count.
+    // Transports that buffer internally override this to copy in bulk.
+    virtual size_t read(uint8_t* buf, size_t max) {
+        size_t n = 0;
+        int    c;
+        while (n < max && (c = getChar()) >= 0) {
+            buf[n++] = c;
+        }
+        return n;
+    }
     virtual void putChar(uint8_t c) = 0;
+    // Sends len bytes.  Transports that can hand a whole block to the
+    // driver in one call override this.
+    virtual void write(const uint8_t* buf, size_t len) {
+        while (len--) {
+            putChar(*buf++);
+        }
+    }
     virtual void resetFlowControl() = 0;
+    // Blocks until received data may be available or timeout_ms has
+    // passed.  Returns false if the transport cannot wait, in which case
+    // the caller must sleep some other way.
+    virtual bool waitForData(int /*timeout_ms*/) { return false; }
+    // Sends anything the transport has buffered.  Called once per
+    // main loop iteration, after the scene has handled its events.
+    virtual void flush() {}
+    // Lines written to FluidNC, each of which it answers with ok or
+    // error.  Counted where the line is written, so lines dropped on
+    // the way, such as jog lines overtaken by a JogCancel, are not.
+    virtual uint32_t linesSent() { return _linesSent.load(std::memory_order_acquire); }
+
+protected:
+    std::atomic<uint32_t> _linesSent { 0 };
 };
 
 // Transport factory
@@ -30,6 +63,14 @@ public:
 
 extern Transport* transport;
 
+// Bytes and uart_write_bytes() calls sent to the FluidNC UART
+extern uint32_t uart_tx_bytes;
+extern uint32_t uart_tx_calls;
+
+// UART driver events taken by the comms task, and receive overflows
+extern uint32_t uart_rx_events;
+extern uint32_t uart_rx_overflows;
+
 #ifndef USE_WIFI_PENDANT
 // For UART builds, provide pass-through declarations to existing functions for compatibility
 extern "C" {
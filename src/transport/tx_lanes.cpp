@@ -0,0 +1,138 @@
+// Copyright (c) 2023 Barton Dring
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "tx_lanes.h"
+
+void LatencyHistogram::add(uint32_t us) {
+    int bucket = 0;
+    while (bucket < n_buckets - 1 && us >= bucket_limit_us(bucket)) {
+        ++bucket;
+    }
+    ++buckets[bucket];
+    ++count;
+    total_us += us;
+    if (us > max_us) {
+        max_us = us;
+    }
+}
+
+uint32_t LatencyHistogram::percentile_us(int percent) const {
+    uint64_t wanted = ((uint64_t)count * percent + 99) / 100;
+    uint64_t seen   = 0;
+    for (int bucket = 0; bucket < n_buckets - 1; ++bucket) {
+        seen += buckets[bucket];
+        if (seen >= wanted) {
+            return bucket_limit_us(bucket);
+        }
+    }
+    return max_us;
+}
+
+// Urgent lane entries are the byte followed by its 32-bit timestamp.
+// Normal lane records are a kind byte, a 16-bit length, a 32-bit
+// timestamp and the payload.
+
+static const size_t urgent_entry  = 5;
+static const size_t normal_header = 7;
+
+bool TxLanes::roomForRT() const {
+    return _urgent.space() >= urgent_entry;
+}
+
+bool TxLanes::pushRT(uint8_t c, uint32_t now_us) {
+    uint8_t entry[urgent_entry] = { c, (uint8_t)now_us, (uint8_t)(now_us >> 8), (uint8_t)(now_us >> 16), (uint8_t)(now_us >> 24) };
+    if (!roomForRT()) {
+        ++rt_dropped;
+        return false;
+    }
+    if (c == jog_cancel) {
+        // Published before the entry, so the consumer sees it with the cancel
+        _cancel_mark.store(_normal.total_written(), std::memory_order_release);
+    }
+    _urgent.write(entry, sizeof(entry));
+    return true;
+}
+
+bool TxLanes::roomForLine(size_t len) const {
+    return _normal.space() >= normal_header + len;
+}
+
+bool TxLanes::pushLine(kind_t kind, const uint8_t* buf, size_t len, uint32_t now_us) {
+    if (len > max_record || !roomForLine(len)) {
+        ++line_dropped;
+        return false;
+    }
+    uint8_t header[normal_header] = {
+        kind, (uint8_t)len, (uint8_t)(len >> 8), (uint8_t)now_us, (uint8_t)(now_us >> 8), (uint8_t)(now_us >> 16), (uint8_t)(now_us >> 24)
+    };
+    // The consumer waits until the whole record is present
+    _normal.write(header, sizeof(header));
+    _normal.write(buf, len);
+    return true;
+}
+
+static bool is_jog(const uint8_t* line, size_t len) {
+    return len >= 3 && line[0] == '$' && line[1] == 'J' && line[2] == '=';
+}
+
+size_t drop_jog_lines(uint8_t* buf, size_t len, uint32_t& dropped) {
+    size_t kept = 0;
+    size_t line = 0;
+    while (line < len) {
+        const uint8_t* nl  = (const uint8_t*)memchr(buf + line, '\n', len - line);
+        size_t         end = nl ? nl - buf + 1 : len;
+        if (nl && is_jog(buf + line, end - line)) {
+            ++dropped;
+        } else {
+            memmove(buf + kept, buf + line, end - line);
+            kept += end - line;
+        }
+        line = end;
+    }
+    return kept;
+}
+
+static uint32_t le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool TxLanes::service(TxSink& sink, uint32_t (*now_us)()) {
+    bool busy = false;
+    while (true) {
+        uint8_t entry[urgent_entry];
+        while (_urgent.available() >= urgent_entry) {
+            _urgent.read(entry, sizeof(entry));
+            if (entry[0] == jog_cancel) {
+                _drop_jogs_before = _cancel_mark.load(std::memory_order_acquire);
+            }
+            sink.sendRT(entry[0]);
+            rt_latency.add(now_us() - le32(entry + 1));
+            busy = true;
+        }
+
+        uint8_t header[normal_header];
+        if (_normal.peek(header, sizeof(header)) != sizeof(header)) {
+            return busy;
+        }
+        size_t len = header[1] | (header[2] << 8);
+        if (_normal.available() < sizeof(header) + len) {
+            return busy;  // The producer has not finished this record
+        }
+        size_t start = _normal.total_read();
+        _normal.read(header, sizeof(header));
+        _normal.read(_record, len);
+        if (header[0] == LINE && (ptrdiff_t)(_drop_jogs_before - start) > 0 && is_jog(_record, len)) {
+            ++jog_dropped;  // Queued before a JogCancel that has been sent
+            busy = true;
+            continue;
+        }
+        if (header[0] == LINE) {
+            _record[len] = '\0';
+            sink.sendLine((const char*)_record);
+        } else {
+            sink.write(_record, len);
+        }
+        line_latency.add(now_us() - le32(header + 3));
+        busy = true;
+    }
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2023 Barton Dring
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+#include "ring_buffer.h"
+
+// Realtime bytes waiting to be sent.  Each entry is 5 bytes, so this
+// holds 204 of them, more than a burst of override steps sends.
+#ifndef TX_URGENT_QUEUE_SIZE
+#define TX_URGENT_QUEUE_SIZE 1024
+#endif
+
+// Lines waiting to be sent
+#ifndef TX_NORMAL_QUEUE_SIZE
+#define TX_NORMAL_QUEUE_SIZE 2048
+#endif
+
+// Counts latencies in power-of-two microsecond buckets:
+// bucket 0 is < 64 us, bucket n is < 64 << n us, and the last bucket
+// holds everything longer.
+class LatencyHistogram {
+public:
+    static const int n_buckets = 16;
+
+    uint32_t buckets[n_buckets] = { 0 };
+    uint32_t count              = 0;
+    uint32_t max_us             = 0;
+    uint64_t total_us           = 0;
+
+    void add(uint32_t us);
+
+    static uint32_t bucket_limit_us(int bucket) { return 64u << bucket; }
+
+    // Upper bound of the bucket that contains the given percentile
+    uint32_t percentile_us(int percent) const;
+    uint32_t average_us() const { return count ? total_us / count : 0; }
+};
+
+// Removes the complete "$J=" lines from buf, which holds text lines
+// ending in '\n', and returns the new length.  A line whose start has
+// already gone out is kept.  dropped counts the lines removed.
+size_t drop_jog_lines(uint8_t* buf, size_t len, uint32_t& dropped);
+
+// Where TxLanes sends its data
+class TxSink {
+public:
+    virtual ~TxSink() = default;
+    virtual void sendRT(uint8_t c)                     = 0;
+    virtual void sendLine(const char* line)            = 0;
+    virtual void write(const uint8_t* buf, size_t len) = 0;
+};
+
+// Two outgoing queues.  Realtime bytes such as Reset, FeedHold and
+// JogCancel go in the urgent lane, which is always emptied before the
+// next line is sent, so they never wait behind a long macro line or a
+// pending $File/ShowSome.  The normal lane is bounded; a full lane makes
+// the producer wait or drop rather than growing without limit.
+//
+// A JogCancel also discards the $J= lines queued before it, which
+// would otherwise start new jogs after the cancel.
+//
+// One producer and one consumer, like RingBuffer.  Entries carry the
+// time they were queued so the time to reach the sink can be measured
+// for each lane.
+class TxLanes {
+public:
+    enum kind_t : uint8_t {
+        LINE = 1,  // Sent with sendLine(), which adds the terminator
+        RAW  = 2,  // Sent as is with write()
+    };
+
+    static const size_t  max_record = 512;   // Longest LINE or RAW payload
+    static const uint8_t jog_cancel = 0x85;  // JogCancel
+
+private:
+    RingBuffer<TX_URGENT_QUEUE_SIZE> _urgent;
+    RingBuffer<TX_NORMAL_QUEUE_SIZE> _normal;
+    uint8_t                          _record[max_record + 1];
+
+    // Normal lane position when the last JogCancel was queued, and as
+    // seen by the consumer when it sent that cancel
+    std::atomic<size_t> _cancel_mark { 0 };
+    size_t              _drop_jogs_before = 0;
+
+public:
+    LatencyHistogram rt_latency;
+    LatencyHistogram line_latency;
+    uint32_t         rt_dropped   = 0;
+    uint32_t         line_dropped = 0;
+    uint32_t         jog_dropped  = 0;  // Jog lines discarded by a JogCancel
+
+    // Producer side; return false if the lane is full
+    bool pushRT(uint8_t c, uint32_t now_us);
+    bool pushLine(kind_t kind, const uint8_t* buf, size_t len, uint32_t now_us);
+
+    bool roomForRT() const;
+    bool roomForLine(size_t len) const;
+
+    // Consumer side.  Sends queued data to sink, checking the urgent lane
+    // again before each line.  Returns true if anything was sent.
+    bool service(TxSink& sink, uint32_t (*now_us)());
+
+    size_t normal_high_water() const { return _normal.high_water; }
+};
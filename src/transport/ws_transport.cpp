@@ -52,22 +52,19 @@ void WSTransport::webSocketEvent(WStype_t type, uint8_t* payload, size_t length)
             
         case WStype_CONNECTED:
             _connected = true;
+            _rxBuffer.clear(); // Drop anything left from the previous connection
             _reconnectInterval = 1500; // Reset reconnect interval on successful connection
             dbg_printf("WSTransport: Connected to %s\n", payload);
             break;
             
         case WStype_TEXT:
-            // Add received text to buffer
-            if (payload && length > 0) {
-                _receivedData += String((char*)payload, length);
-            }
-            break;
-            
         case WStype_BIN:
-            // Handle binary data (for single bytes like RT commands)
+            // Add received data to buffer
             if (payload && length > 0) {
-                for (size_t i = 0; i < length; i++) {
-                    _receivedData += (char)payload[i];
+                _rxBuffer.write(payload, length);
+                if (_rxBuffer.overflow_events != _reportedOverflows) {
+                    _reportedOverflows = _rxBuffer.overflow_events;
+                    dbg_printf("WSTransport: Receive buffer full, %u bytes dropped\n", _rxBuffer.overflow_bytes);
                 }
             }
             break;
@@ -126,6 +123,7 @@ void WSTransport::sendLine(const char* line, int timeout) {
     // Send line with single newline appended
     String message = String(line) + "\n";
     _webSocket.sendTXT(message);
+    _linesSent.fetch_add(1, std::memory_order_release);
     
     dbg_printf("WSTransport: Sent line: %s", message.c_str());
 }
@@ -142,12 +140,11 @@ void WSTransport::sendRT(uint8_t c) {
 }
 
 int WSTransport::getChar() {
-    if (_receivedData.length() > 0) {
-        char c = _receivedData.charAt(0);
-        _receivedData.remove(0, 1);
-        return (int)c;
-    }
-    return -1; // No data available
+    return _rxBuffer.getChar(); // -1 if no data available
+}
+
+size_t WSTransport::read(uint8_t* buf, size_t max) {
+    return _rxBuffer.read(buf, max);
 }
 
 void WSTransport::putChar(uint8_t c) {
@@ -6,9 +6,16 @@
 #ifdef USE_WIFI_PENDANT
 
 #include "transport.h"
+#include "ring_buffer.h"
 #include <WebSocketsClient.h>
 #include <WiFi.h>
 
+// Large enough for a whole $Files/ListGCode reply or $File/ShowSome
+// preview, which arrive as a burst between two parser polls
+#ifndef WS_RX_BUFFER_SIZE
+#define WS_RX_BUFFER_SIZE 8192
+#endif
+
 // WebSocket transport implementation for FluidNC communication
 class WSTransport : public Transport {
 private:
@@ -20,7 +27,8 @@ private:
     unsigned long _lastReconnectAttempt = 0;
     unsigned long _reconnectInterval = 1500; // Start with 1.5s
     const unsigned long _maxReconnectInterval = 5000; // Max 5s
-    String _receivedData;
+    RingBuffer<WS_RX_BUFFER_SIZE> _rxBuffer;
+    uint32_t _reportedOverflows = 0;
     
     void webSocketEvent(WStype_t type, uint8_t* payload, size_t length);
     void attemptReconnect();
@@ -36,11 +44,16 @@ public:
     void sendLine(const char* line, int timeout = 2000) override;
     void sendRT(uint8_t c) override;
     int getChar() override;
+    size_t read(uint8_t* buf, size_t max) override;
     void putChar(uint8_t c) override;
     void resetFlowControl() override;
     
     // WebSocket specific methods
     void setHost(const char* host, int port);
+
+    // Receive buffer statistics
+    uint32_t rxOverflowBytes() const { return _rxBuffer.overflow_bytes; }
+    size_t rxHighWater() const { return _rxBuffer.high_water; }
 };
 
 #endif // USE_WIFI_PENDANT
\ No newline at end of file
@@ -0,0 +1,229 @@
+# This script writes the traffic corpus used by the host tests and
+# benchmarks, in the capture format described in src/transport/capture.h.
+# Run it with "python make_corpus.py" from this directory; the output is
+# deterministic, so the .cap files are checked in alongside it.
+#   job_ri200.cap   - a three minute SD job with $RI=200 status reports
+#   files_list.cap  - a $Files/ListGCode reply for a card with 200 files
+#   macros.cap      - macrocfg.json via $File/SendJSON, then a preview
+#   jog_ri200.cap   - X and Y jogs through zero, in the Jog state
+#
+# It also writes encoder traces for the encoder curve tests, modelled on
+# an M5Dial wheel with 4 counts per detent.  Each line is the time in
+# microseconds and the counts seen since the previous line.
+#   wheel_fine.enc  - single detents, two per second
+#   wheel_spin.enc  - a flick up to 40 detents per second and back down
+#   wheel_back.enc  - a fast turn, then fine detents the other way
+#
+# Times assume 115200 baud.  Each FluidNC line is one record, stamped
+# when its last byte arrives.  JSON is sent in [JSON:...] chunks and the
+# pendant acknowledges each one with 0xB2, as handle_json() does.
+
+import json
+import math
+import random
+
+US_PER_BYTE = 87  # 115200 baud
+ACK = "\xb2"
+CHUNK = 120  # JSON characters per [JSON:...] line
+
+
+def escape(data):
+    out = []
+    for c in data:
+        o = ord(c)
+        if c == "\\":
+            out.append("\\\\")
+        elif c == "\r":
+            out.append("\\r")
+        elif c == "\n":
+            out.append("\\n")
+        elif o < 0x20 or o >= 0x7F:
+            out.append("\\x%02x" % o)
+        else:
+            out.append(c)
+    return "".join(out)
+
+
+class Capture:
+    def __init__(self, description):
+        self.records = []
+        self.t = 0
+        self.description = description
+
+    def send(self, data, gap_us=0):
+        self.t += gap_us
+        self.records.append((self.t, "S", data))
+        self.t += len(data) * US_PER_BYTE
+
+    def receive(self, data, gap_us=0):
+        self.t += gap_us + len(data) * US_PER_BYTE
+        self.records.append((self.t, "R", data))
+
+    def json(self, obj):
+        text = json.dumps(obj, separators=(",", ":"))
+        for i in range(0, len(text), CHUNK):
+            self.receive("[JSON:" + text[i : i + CHUNK] + "]\r\n", 200)
+            self.send(ACK, 300)
+        self.receive("ok\r\n", 100)
+
+    def save(self, name):
+        with open(name, "w", newline="\n") as f:
+            f.write("# FluidDial capture v1: <us> <R|S> <bytes>\n")
+            f.write("# %s\n" % self.description)
+            for t, d, data in self.records:
+                f.write("%d %s %s\n" % (t, d, escape(data)))
+
+
+def job_ri200():
+    cap = Capture("SD job with $RI=200 status reports, generated by make_corpus.py")
+    cap.send("$RI=200\n")
+    cap.receive("ok\r\n", 1500)
+    cap.send("$SD/Run=/sd/logo_engrave.nc\n", 40000)
+    cap.receive("ok\r\n", 2000)
+
+    start = cap.t
+    reports = 900
+    feed_ov = 100
+    for n in range(reports):
+        # A raster over a 120 x 80 mm area, stepping down twice
+        phase = n / reports
+        row = int(phase * 60)
+        x = (n % 30) * 4.0 if row % 2 == 0 else (29 - n % 30) * 4.0
+        y = row * 80.0 / 60
+        z = -1.0 if phase < 0.5 else -2.0
+        x += 0.125 * math.sin(n)
+        feed = 0 if n % 30 == 0 else 1200 * feed_ov // 100
+        report = "<Run|MPos:%.3f,%.3f,%.3f|FS:%d,12000" % (x, y, z, feed)
+        if n % 10 == 0:
+            report += "|WCO:-210.000,-145.000,-32.500"
+        elif n % 10 == 5:
+            report += "|Ov:%d,100,100" % feed_ov
+        report += "|SD:%.2f,/sd/logo_engrave.nc>\r\n" % (phase * 100)
+        cap.t = start + n * 200000 - len(report) * US_PER_BYTE
+        cap.receive(report)
+        if n == 300:
+            cap.send("\x91", 30000)  # Feed override +10
+            feed_ov = 110
+        if n == 600:
+            cap.send("\x90", 30000)  # Feed override reset
+            feed_ov = 100
+
+    cap.receive("<Idle|MPos:0.000,0.000,5.000|FS:0,0|Ov:100,100,100>\r\n", 150000)
+    cap.receive("[MSG:INFO: /sd/logo_engrave.nc file job succeeded]\r\n", 200)
+    cap.save("job_ri200.cap")
+
+
+def jog_ri200():
+    cap = Capture("Jogs through zero with $RI=200 status reports, generated by make_corpus.py")
+    cap.send("$RI=200\n")
+    cap.receive("ok\r\n", 1500)
+    cap.receive("<Idle|MPos:-3.000,-2.000,0.000|FS:0,0|WCO:0.000,0.000,0.000|Ov:100,100,100>\r\n", 150000)
+
+    # The sign and the number of digits change as the axes cross zero
+    pos = {"X": -3.0, "Y": -2.0}
+    for axis, target in (("X", 12.0), ("Y", 8.0), ("X", -15.0)):
+        cap.send("$J=G91 G21 %s%.3f F600\n" % (axis, target - pos[axis]), 50000)
+        cap.receive("ok\r\n", 2000)
+        while pos[axis] != target:
+            if abs(target - pos[axis]) <= 2.0:
+                pos[axis] = target
+            else:
+                pos[axis] += math.copysign(2.0, target - pos[axis])
+            cap.receive("<Jog|MPos:%.3f,%.3f,0.000|FS:600,0>\r\n" % (pos["X"], pos["Y"]), 200000)
+        cap.receive("<Idle|MPos:%.3f,%.3f,0.000|FS:0,0>\r\n" % (pos["X"], pos["Y"]), 200000)
+    cap.save("jog_ri200.cap")
+
+
+def files_list():
+    rng = random.Random(200)
+    words = ["pocket", "logo", "engrave", "drill", "surface", "box", "lid", "sign", "tray", "bracket", "panel", "gear"]
+    files = []
+    for i in range(200):
+        name = "%s_%s_%03d.nc" % (rng.choice(words), rng.choice(words), i)
+        files.append({"name": name, "size": str(rng.randint(500, 900000))})
+    files.append({"name": "archive", "size": "-1"})
+    cap = Capture("$Files/ListGCode reply with 200 files, generated by make_corpus.py")
+    cap.send("$Files/ListGCode=/sd\n")
+    cap.json({"files": files, "path": "/sd", "total": "29.7GB", "used": "61.4MB", "occupation": "1", "status": "Ok"})
+    cap.save("files_list.cap")
+
+
+def macros():
+    names = ["Home", "Probe Z", "Park", "Spindle warmup", "Tool change", "Zero XY", "Vacuum on", "Vacuum off"]
+    result = []
+    for i, name in enumerate(names):
+        result.append({"name": name, "filename": "/macro%d.g" % i, "target": "ESP", "class": "", "index": str(i)})
+    cap = Capture("macrocfg.json and a file preview, generated by make_corpus.py")
+    cap.send("$File/SendJSON=/macrocfg.json\n")
+    cap.json({"cmd": "$File/SendJSON", "argument": "/macrocfg.json", "status": "ok", "result": result})
+    cap.send("$File/ShowSome=0:8,/localfs/macro1.g\n", 50000)
+    lines = ["G21", "G91", "G38.2 Z-20 F100", "G0 Z2", "G38.2 Z-5 F25", "G10 L20 P0 Z15.0", "G0 Z5", "G90"]
+    cap.json({"cmd": "$File/ShowSome=0:8,/localfs/macro1.g", "status": "ok", "firstline": "0", "file_lines": lines})
+    cap.save("macros.cap")
+
+
+class Trace:
+    COUNTS_PER_DETENT = 4
+
+    def __init__(self, description):
+        self.description = description
+        self.t = 0
+        self.events = []
+
+    def detent(self, direction, gap_us):
+        # The four edges of a detent arrive close together
+        self.t += gap_us
+        for i in range(self.COUNTS_PER_DETENT):
+            self.events.append((self.t + i * 300, direction))
+
+    def turn(self, direction, start_dps, end_dps, seconds, rng):
+        # Detents at a speed changing linearly, with some hand jitter
+        elapsed = 0.0
+        while elapsed < seconds:
+            speed = start_dps + (end_dps - start_dps) * elapsed / seconds
+            gap = 1.0 / max(speed, 0.5) * rng.uniform(0.9, 1.1)
+            elapsed += gap
+            self.detent(direction, int(gap * 1000000))
+
+    def save(self, name):
+        with open(name, "w", newline="\n") as f:
+            f.write("# FluidDial encoder trace v1: <us> <counts>\n")
+            f.write("# %s\n" % self.description)
+            for t, counts in self.events:
+                f.write("%d %d\n" % (t, counts))
+
+
+def wheel_fine():
+    trace = Trace("20 single detents at 2 per second, generated by make_corpus.py")
+    for i in range(20):
+        trace.detent(1, 500000)
+    trace.save("wheel_fine.enc")
+
+
+def wheel_spin():
+    rng = random.Random(23)
+    trace = Trace("A flick: up to 40 detents/s, held, then slowing, generated by make_corpus.py")
+    trace.turn(1, 2, 40, 0.3, rng)
+    trace.turn(1, 40, 40, 1.0, rng)
+    trace.turn(1, 40, 2, 0.5, rng)
+    trace.save("wheel_spin.enc")
+
+
+def wheel_back():
+    rng = random.Random(7)
+    trace = Trace("A fast turn, then 10 fine detents back, generated by make_corpus.py")
+    trace.turn(1, 30, 30, 0.5, rng)
+    trace.t += 500000
+    for i in range(10):
+        trace.detent(-1, 400000)
+    trace.save("wheel_back.enc")
+
+
+if __name__ == "__main__":
+    job_ri200()
+    jog_ri200()
+    files_list()
+    macros()
+    wheel_fine()
+    wheel_spin()
+    wheel_back()
@@ -0,0 +1,199 @@
+#include <unity.h>
+
+#include "transport/async_connect.h"
+#include <arpa/inet.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Host-side tests for the non-blocking connect state machine, against
+// a listener on the loopback interface.  A fake resolver stands in for
+// mDNS and DNS, and a fake clock drives the timeouts.
+// Run with: pio test -e native_test
+
+class FakeResolver : public HostResolver {
+public:
+    int      starts  = 0;
+    int      cancels = 0;
+    result_t result  = PENDING;
+    uint32_t address = htonl(INADDR_LOOPBACK);
+
+    bool start(const char* host) override {
+        ++starts;
+        return true;
+    }
+    result_t poll(uint32_t& ipv4) override {
+        ipv4 = address;
+        return result;
+    }
+    void cancel() override { ++cancels; }
+};
+
+static int      listener = -1;
+static uint16_t port     = 0;
+static uint32_t now      = 0;
+
+static uint16_t listen_on_loopback(int& fd) {
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in sa {};
+    sa.sin_family      = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (struct sockaddr*)&sa, sizeof(sa));
+    listen(fd, 4);
+    socklen_t len = sizeof(sa);
+    getsockname(fd, (struct sockaddr*)&sa, &len);
+    return ntohs(sa.sin_port);
+}
+
+// Polls until connected or the fake clock passes limit_ms, checking
+// that no single poll takes long
+static bool poll_until_connected(AsyncConnector& c, uint32_t limit_ms) {
+    for (int i = 0; i < 100000 && now < limit_ms; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        bool done  = c.poll(now);
+        auto us    = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        TEST_ASSERT_LESS_THAN(5000, us);
+        if (done) {
+            return true;
+        }
+        usleep(100);
+        now += 1;
+    }
+    return false;
+}
+
+void setUp(void) {
+    now  = 1000;
+    port = listen_on_loopback(listener);
+}
+
+void tearDown(void) {
+    close(listener);
+}
+
+void test_numeric_host_connects() {
+    AsyncConnector c(nullptr);
+    c.setHost("127.0.0.1", port);
+    c.start(now);
+    TEST_ASSERT_TRUE(poll_until_connected(c, now + 1000));
+    TEST_ASSERT_EQUAL(AsyncConnector::CONNECTED, c.state());
+    int fd = c.takeSocket();
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_EQUAL(1, write(fd, "?", 1));
+    close(fd);
+    TEST_ASSERT_EQUAL_UINT32(1, c.stats.attempts);
+    TEST_ASSERT_EQUAL_UINT32(1, c.stats.connects);
+}
+
+void test_refused_connect_backs_off() {
+    int      closed;
+    uint16_t dead = listen_on_loopback(closed);
+    close(closed);  // Nothing listens on this port now
+
+    AsyncConnector c(nullptr);
+    c.setHost("127.0.0.1", dead);
+    c.start(now);
+    TEST_ASSERT_FALSE(poll_until_connected(c, now + 100));
+    TEST_ASSERT_EQUAL(AsyncConnector::BACKOFF, c.state());
+    TEST_ASSERT_EQUAL_UINT32(1, c.stats.connect_failures);
+
+    // No new attempt until the retry interval has passed, then twice as long
+    now += CONNECT_RETRY_MIN_MS - 200;
+    c.poll(now);
+    TEST_ASSERT_EQUAL_UINT32(1, c.stats.attempts);
+    TEST_ASSERT_FALSE(poll_until_connected(c, now + 400));
+    TEST_ASSERT_EQUAL_UINT32(2, c.stats.attempts);
+    now += CONNECT_RETRY_MIN_MS + 200;
+    c.poll(now);
+    TEST_ASSERT_EQUAL_UINT32(2, c.stats.attempts);
+}
+
+void test_resolve_timeout() {
+    FakeResolver   r;
+    AsyncConnector c(&r);
+    c.setHost("fluidnc.local", port);
+    c.start(now);
+    c.poll(now);
+    TEST_ASSERT_EQUAL(AsyncConnector::RESOLVING, c.state());
+    now += CONNECT_RESOLVE_TIMEOUT_MS - 1;
+    c.poll(now);
+    TEST_ASSERT_EQUAL(AsyncConnector::RESOLVING, c.state());
+    now += 1;
+    c.poll(now);
+    TEST_ASSERT_EQUAL(AsyncConnector::BACKOFF, c.state());
+    TEST_ASSERT_EQUAL(1, r.cancels);
+    TEST_ASSERT_EQUAL_UINT32(1, c.stats.timeouts);
+}
+
+void test_resolved_address_is_cached() {
+    FakeResolver   r;
+    AsyncConnector c(&r);
+    c.setHost("fluidnc.local", port);
+    c.start(now);
+    c.poll(now);
+    r.result = HostResolver::DONE;
+    TEST_ASSERT_TRUE(poll_until_connected(c, now + 1000));
+    close(c.takeSocket());
+    TEST_ASSERT_EQUAL(1, r.starts);
+
+    // A reconnect within the TTL skips the lookup
+    c.lost(now);
+    TEST_ASSERT_TRUE(poll_until_connected(c, now + 1000));
+    close(c.takeSocket());
+    TEST_ASSERT_EQUAL(1, r.starts);
+    TEST_ASSERT_EQUAL_UINT32(1, c.stats.cache_hits);
+
+    // After it, the name is looked up again
+    now += RESOLVE_CACHE_TTL_MS;
+    c.lost(now);
+    TEST_ASSERT_TRUE(poll_until_connected(c, now + 1000));
+    close(c.takeSocket());
+    TEST_ASSERT_EQUAL(2, r.starts);
+    TEST_ASSERT_EQUAL_UINT32(3, c.stats.connects);
+}
+
+void test_failed_cached_address_is_dropped() {
+    FakeResolver   r;
+    AsyncConnector c(&r);
+    c.setHost("fluidnc.local", port);
+    c.start(now);
+    c.poll(now);
+    r.result = HostResolver::DONE;
+    TEST_ASSERT_TRUE(poll_until_connected(c, now + 1000));
+    close(c.takeSocket());
+
+    // The controller went away; the cached address fails, so the next
+    // attempt asks the resolver again
+    close(listener);
+    listener = -1;
+    c.lost(now);
+    TEST_ASSERT_FALSE(poll_until_connected(c, now + 100));
+    TEST_ASSERT_EQUAL_UINT32(1, c.stats.cache_hits);
+    now += CONNECT_RETRY_MAX_MS;
+    c.poll(now);
+    TEST_ASSERT_EQUAL(2, r.starts);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_numeric_host_connects);
+    RUN_TEST(test_refused_connect_backs_off);
+    RUN_TEST(test_resolve_timeout);
+    RUN_TEST(test_resolved_address_is_cached);
+    RUN_TEST(test_failed_cached_address_is_dropped);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#    include <Arduino.h>
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(int argc, char** argv) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,189 @@
+#include <unity.h>
+
+#include "EncoderCurve.h"
+#include "EncoderStream.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Host-side tests for the ballistic encoder curves.  The wheel traces
+// in test/corpus are replayed through the encoder sampler at its task
+// rate, and drained once per frame as dispatch_events() does.
+// Run with: pio test -e native_test
+
+static const int COUNTS_PER_DETENT = 4;
+static const int FRAME_MS          = 20;
+
+static const encoder_curve_t jog_curve   = { 6, 30, 10 };
+static const encoder_curve_t files_curve = { 5, 20, 25 };
+
+struct trace_event_t {
+    uint32_t us;
+    int      counts;
+};
+
+static bool load_trace(const char* name, std::vector<trace_event_t>& events) {
+    std::string   path = std::string("test/corpus/") + name;
+    std::ifstream f(path);
+    if (!f) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream in(line);
+        trace_event_t      ev;
+        in >> ev.us >> ev.counts;
+        events.push_back(ev);
+    }
+    return true;
+}
+
+// Returns the steps produced in each frame
+static std::vector<int> replay(const std::vector<trace_event_t>& events, const encoder_curve_t& curve) {
+    EncoderSampler   sampler;
+    EncoderCurve     scaler(curve);
+    std::vector<int> frames;
+    int16_t          raw   = 0;
+    int              accum = 0;
+    size_t           next  = 0;
+    uint32_t         end   = events.empty() ? 0 : events.back().us + 500000;
+    for (uint32_t ms = 0; ms * 1000 <= end; ++ms) {
+        while (next < events.size() && events[next].us <= ms * 1000) {
+            raw += events[next++].counts;
+        }
+        sampler.sample(raw, ms * 1000);
+        if (ms % FRAME_MS == 0) {
+            encoder_event_t ev;
+            uint32_t        event_us = 0;
+            while (sampler.read(ev)) {
+                accum += ev.delta;
+                event_us = ev.us;
+            }
+            // As Scene::scale_encoder()
+            int detents = accum / COUNTS_PER_DETENT;
+            accum %= COUNTS_PER_DETENT;
+            frames.push_back(detents ? scaler.apply(detents, event_us) : 0);
+        }
+    }
+    return frames;
+}
+
+static int total(const std::vector<int>& frames) {
+    int sum = 0;
+    for (int f : frames) {
+        sum += f;
+    }
+    return sum;
+}
+
+static int detents(const std::vector<trace_event_t>& events) {
+    int sum = 0;
+    for (auto& ev : events) {
+        sum += ev.counts;
+    }
+    return sum / COUNTS_PER_DETENT;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_curve_shape() {
+    EncoderCurve c(jog_curve);
+    TEST_ASSERT_EQUAL_INT(EncoderCurve::ONE, c.gain(0));
+    TEST_ASSERT_EQUAL_INT(EncoderCurve::ONE, c.gain(6));
+    TEST_ASSERT_EQUAL_INT(10 * EncoderCurve::ONE, c.gain(30));
+    TEST_ASSERT_EQUAL_INT(10 * EncoderCurve::ONE, c.gain(100));
+    TEST_ASSERT_EQUAL_INT(EncoderCurve::ONE + 9 * EncoderCurve::ONE / 2, c.gain(18));
+
+    // 20 detents/s is 6.25 steps per detent, the quarters carried over
+    TEST_ASSERT_EQUAL_INT(1, c.apply(1, 1000000));
+    TEST_ASSERT_EQUAL_INT(6, c.apply(1, 1050000));
+    TEST_ASSERT_EQUAL_INT(6, c.apply(1, 1100000));
+    TEST_ASSERT_EQUAL_INT(6, c.apply(1, 1150000));
+    TEST_ASSERT_EQUAL_INT(7, c.apply(1, 1200000));
+    // A reversal drops the fraction and starts at one step per detent
+    TEST_ASSERT_EQUAL_INT(-1, c.apply(-1, 1250000));
+    // As does a pause
+    TEST_ASSERT_EQUAL_INT(-1, c.apply(-1, 1250000 + ENCODER_CURVE_IDLE_US));
+
+    EncoderCurve flat;
+    TEST_ASSERT_FALSE(flat.enabled());
+    TEST_ASSERT_EQUAL_INT(-3, flat.apply(-3, 1000));
+}
+
+void test_fine_detents_are_single_steps() {
+    std::vector<trace_event_t> events;
+    TEST_ASSERT_TRUE(load_trace("wheel_fine.enc", events));
+    auto frames = replay(events, jog_curve);
+    TEST_ASSERT_EQUAL_INT(20, total(frames));
+    for (int f : frames) {
+        TEST_ASSERT_LESS_OR_EQUAL(1, f);
+    }
+}
+
+void test_spin_is_accelerated() {
+    std::vector<trace_event_t> events;
+    TEST_ASSERT_TRUE(load_trace("wheel_spin.enc", events));
+    int n = detents(events);
+    int j = total(replay(events, jog_curve));
+    int f = total(replay(events, files_curve));
+    TEST_ASSERT_GREATER_THAN(3 * n, j);
+    TEST_ASSERT_LESS_OR_EQUAL(10 * n, j);
+    TEST_ASSERT_GREATER_THAN(j, f);
+    printf("Spin of %d detents: %d jog steps, %d file list steps\n", n, j, f);
+}
+
+void test_reversal_starts_fine() {
+    std::vector<trace_event_t> events;
+    TEST_ASSERT_TRUE(load_trace("wheel_back.enc", events));
+    auto frames = replay(events, jog_curve);
+    int  back   = 0;
+    for (int f : frames) {
+        if (f < 0) {
+            TEST_ASSERT_EQUAL_INT(-1, f);
+            back += f;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(-10, back);
+}
+
+void test_replay_is_deterministic() {
+    static const char* traces[] = { "wheel_fine.enc", "wheel_spin.enc", "wheel_back.enc" };
+    for (auto name : traces) {
+        std::vector<trace_event_t> events;
+        TEST_ASSERT_TRUE(load_trace(name, events));
+        auto first  = replay(events, files_curve);
+        auto second = replay(events, files_curve);
+        TEST_ASSERT_EQUAL_size_t(first.size(), second.size());
+        TEST_ASSERT_TRUE(first == second);
+    }
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_curve_shape);
+    RUN_TEST(test_fine_detents_are_single_steps);
+    RUN_TEST(test_spin_is_accelerated);
+    RUN_TEST(test_reversal_starts_fine);
+    RUN_TEST(test_replay_is_deterministic);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#    include <Arduino.h>
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(int argc, char** argv) {
+    return runUnityTests();
+}
+#endif
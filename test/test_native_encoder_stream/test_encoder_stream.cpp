@@ -0,0 +1,192 @@
+#include <unity.h>
+
+#include "EncoderStream.h"
+#include <cmath>
+#include <cstdio>
+
+// Host-side tests for the encoder sampler: counter wrap, the event
+// ring, and the velocity and acceleration estimates.  The counter is
+// simulated as the PCNT unit behaves, returning to 0 at its limits.
+// Run with: pio test -e native_test
+
+static const int32_t LIMIT = 1000;
+
+// A counter that returns to 0 when it reaches +/- LIMIT, as PCNT does
+struct FakePcnt {
+    int32_t raw = 0;
+    void    step(int counts) {
+        while (counts > 0) {
+            if (++raw == LIMIT) {
+                raw = 0;
+            }
+            --counts;
+        }
+        while (counts < 0) {
+            if (--raw == -LIMIT) {
+                raw = 0;
+            }
+            ++counts;
+        }
+    }
+};
+
+static int32_t drain(EncoderSampler& s, uint32_t* last_us = nullptr) {
+    int32_t         total = 0;
+    encoder_event_t ev;
+    while (s.read(ev)) {
+        total += ev.delta;
+        if (last_us) {
+            *last_us = ev.us;
+        }
+    }
+    return total;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_pcnt_wrap_is_unwrapped() {
+    EncoderSampler s(LIMIT);
+    FakePcnt       pcnt;
+    uint32_t       us    = 0;
+    int32_t        total = 0;
+    s.sample(pcnt.raw, us);
+    for (int i = 0; i < 3000; ++i) {
+        pcnt.step(7);
+        s.sample(pcnt.raw, us += 1000);
+        total += drain(s);
+    }
+    TEST_ASSERT_EQUAL_INT32(21000, total);
+    TEST_ASSERT_EQUAL_INT32(21000, s.position());
+    for (int i = 0; i < 5000; ++i) {
+        pcnt.step(-9);
+        s.sample(pcnt.raw, us += 1000);
+        total += drain(s);
+    }
+    TEST_ASSERT_EQUAL_INT32(21000 - 45000, total);
+    TEST_ASSERT_EQUAL_INT32(21000 - 45000, s.position());
+}
+
+void test_int16_wrap_is_unwrapped() {
+    EncoderSampler s;
+    int16_t        raw = 32000;
+    uint32_t       us  = 0;
+    s.sample(raw, us);
+    for (int i = 0; i < 200; ++i) {
+        raw += 10;  // Wraps to negative
+        s.sample(raw, us += 1000);
+    }
+    TEST_ASSERT_EQUAL_INT32(2000, drain(s));
+}
+
+void test_events_carry_timestamps() {
+    EncoderSampler s(LIMIT);
+    s.sample(0, 0);
+    s.sample(0, 1000);  // No change, no event
+    s.sample(3, 2000);
+    s.sample(3, 3000);
+    s.sample(1, 4000);
+    encoder_event_t ev;
+    TEST_ASSERT_TRUE(s.read(ev));
+    TEST_ASSERT_EQUAL_UINT32(2000, ev.us);
+    TEST_ASSERT_EQUAL_INT32(3, ev.delta);
+    TEST_ASSERT_TRUE(s.read(ev));
+    TEST_ASSERT_EQUAL_UINT32(4000, ev.us);
+    TEST_ASSERT_EQUAL_INT32(-2, ev.delta);
+    TEST_ASSERT_FALSE(s.read(ev));
+    TEST_ASSERT_EQUAL_UINT32(2, s.stats.events);
+}
+
+void test_full_ring_keeps_counts() {
+    EncoderSampler s(LIMIT);
+    FakePcnt       pcnt;
+    uint32_t       us = 0;
+    s.sample(pcnt.raw, us);
+    // A long frame: nothing is read for a second
+    for (int i = 0; i < 1000; ++i) {
+        pcnt.step(1);
+        s.sample(pcnt.raw, us += 1000);
+    }
+    TEST_ASSERT_GREATER_THAN(0, s.stats.merged);
+    uint32_t last_us = 0;
+    int32_t  total   = drain(s, &last_us);
+    pcnt.step(1);
+    s.sample(pcnt.raw, us += 1000);
+    total += drain(s, &last_us);
+    TEST_ASSERT_EQUAL_INT32(1001, total);
+    TEST_ASSERT_EQUAL_UINT32(us, last_us);
+}
+
+void test_velocity_and_acceleration() {
+    EncoderSampler s(LIMIT);
+    FakePcnt       pcnt;
+    uint32_t       us = 0;
+    s.sample(pcnt.raw, us);
+
+    // 500 counts/s: one count every other sample
+    for (int i = 0; i < 1000; ++i) {
+        if (i % 2) {
+            pcnt.step(1);
+        }
+        s.sample(pcnt.raw, us += 1000);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(25, 500, s.velocity());
+    TEST_ASSERT_FLOAT_WITHIN(200, 0, s.acceleration());
+
+    // Speeding up at 2000 counts/s^2 for half a second
+    double v = 500, frac = 0;
+    for (int i = 0; i < 500; ++i) {
+        v += 2;
+        frac += v / 1000;
+        pcnt.step((int)frac);
+        frac -= (int)frac;
+        s.sample(pcnt.raw, us += 1000);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(200, 2000, s.acceleration());
+    TEST_ASSERT_FLOAT_WITHIN(100, 1500, s.velocity());
+    printf("Tracking: %.0f counts/s (1500 true), %.0f counts/s^2 (2000 true)\n", s.velocity(), s.acceleration());
+
+    // The wheel stops; the estimate settles within a tenth of a second
+    for (int i = 0; i < 100; ++i) {
+        s.sample(pcnt.raw, us += 1000);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(50, 0, s.velocity());
+}
+
+void test_sparse_samples_stay_stable() {
+    // Host builds sample once per frame
+    EncoderSampler s;
+    int16_t        raw = 0;
+    uint32_t       us  = 0;
+    for (int i = 0; i < 100; ++i) {
+        raw += 15;
+        s.sample(raw, us += 30000);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(50, 500, s.velocity());
+    TEST_ASSERT_EQUAL_UINT32(30000, s.stats.max_gap_us);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_pcnt_wrap_is_unwrapped);
+    RUN_TEST(test_int16_wrap_is_unwrapped);
+    RUN_TEST(test_events_carry_timestamps);
+    RUN_TEST(test_full_ring_keeps_counts);
+    RUN_TEST(test_velocity_and_acceleration);
+    RUN_TEST(test_sparse_samples_stay_stable);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#    include <Arduino.h>
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(int argc, char** argv) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,260 @@
+#include <unity.h>
+
+#include "JogEngine.h"
+#include <cmath>
+#include <cstdio>
+#include <deque>
+
+// Host-side tests for the handwheel jog engine, against a simulated jog
+// planner that moves one axis with limited feed and acceleration and
+// always plans to stop at the end of its queue, as FluidNC does.
+// Run with: pio test -e native_test
+
+static const double ACCEL_MM_S2 = 500;
+static const int    STEP_E4     = 1000;  // 0.1 mm per count
+static const int    MAX_FEED    = 100000000;  // 10000 mm/min in e4 units
+static const int    REPORT_MS   = 200;  // $RI=200
+
+class SimPlanner : public JogSink {
+    struct queued_t {
+        double rem;  // Signed mm still to go
+        double feed;
+    };
+    std::deque<queued_t> _queue;
+    bool                 _cancelling = false;
+    uint32_t             _next_report = 0;
+
+public:
+    double   pos      = 0;
+    double   speed    = 0;
+    uint32_t segments = 0;
+    uint32_t reports  = 0;
+    bool     jogging  = false;  // As shown by the last report
+    bool     sent_while_cancelling = false;
+
+    void jog(const jog_segment_t& seg) override {
+        if (_cancelling) {
+            sent_while_cancelling = true;
+        }
+        _queue.push_back({ seg.distance[0] / 10000.0, seg.feed / 600000.0 });
+        ++segments;
+    }
+    void cancel() override { _cancelling = true; }
+
+    bool moving() const { return !_queue.empty() || speed > 0 || _cancelling; }
+
+    void step(uint32_t now_ms) {
+        const double dt = 0.001;
+        if (_cancelling) {
+            speed = speed > ACCEL_MM_S2 * dt ? speed - ACCEL_MM_S2 * dt : 0;
+            if (speed == 0) {
+                _queue.clear();
+                _cancelling = false;
+            } else {
+                pos += (_queue.empty() || _queue.front().rem > 0 ? 1 : -1) * speed * dt;
+            }
+        } else if (_queue.empty()) {
+            speed = 0;
+        } else {
+            int    dir = _queue.front().rem > 0 ? 1 : -1;
+            double run = 0;  // To the end of the moves in this direction
+            for (auto& q : _queue) {
+                if ((q.rem > 0 ? 1 : -1) != dir) {
+                    break;
+                }
+                run += std::fabs(q.rem);
+            }
+            double limit = std::fmin(_queue.front().feed, std::sqrt(2 * ACCEL_MM_S2 * run));
+            speed        = speed < limit ? std::fmin(limit, speed + ACCEL_MM_S2 * dt) : std::fmax(limit, speed - ACCEL_MM_S2 * dt);
+            speed        = std::fmax(speed, 1.0);
+            double d     = speed * dt;
+            while (d > 0 && !_queue.empty() && (_queue.front().rem > 0 ? 1 : -1) == dir) {
+                double take = std::fmin(d, std::fabs(_queue.front().rem));
+                pos += dir * take;
+                _queue.front().rem -= dir * take;
+                d -= take;
+                if (std::fabs(_queue.front().rem) < 1e-9) {
+                    _queue.pop_front();
+                }
+            }
+            if (_queue.empty() || (_queue.front().rem > 0 ? 1 : -1) != dir) {
+                speed = 0;
+            }
+        }
+        if (now_ms >= _next_report) {
+            _next_report = now_ms + REPORT_MS;
+            jogging      = moving();
+            ++reports;
+        }
+    }
+};
+
+static uint32_t now = 0;
+
+static void setup_engine(JogEngine& e) {
+    int32_t steps[3] = { STEP_E4, 0, 0 };
+    e.setAxes(steps, 3);
+    e.setMaxFeed(MAX_FEED);
+}
+
+// Turns the wheel by counts every period ms, for ms milliseconds
+static void turn(JogEngine& e, SimPlanner& sim, uint32_t ms, int counts, uint32_t period) {
+    for (uint32_t end = now + ms; now < end; ++now) {
+        if (counts && now % period == 0) {
+            e.encoder(counts, now);
+        }
+        e.poll(now, sim.jogging, sim.reports);
+        sim.step(now);
+    }
+}
+
+// Returns how long the machine keeps moving
+static uint32_t settle(JogEngine& e, SimPlanner& sim) {
+    uint32_t stopped = now;
+    while ((sim.moving() || !e.idle(now)) && now < stopped + 60000) {
+        e.poll(now, sim.jogging, sim.reports);
+        sim.step(now);
+        ++now;
+    }
+    return now - stopped;
+}
+
+static uint32_t run(JogEngine& e, SimPlanner& sim, uint32_t ms, int counts, uint32_t period) {
+    turn(e, sim, ms, counts, period);
+    return settle(e, sim);
+}
+
+void setUp(void) {
+    now = 0;
+}
+
+void tearDown(void) {}
+
+void test_slow_turn_moves_exact_distance() {
+    SimPlanner sim;
+    JogEngine  e(&sim);
+    setup_engine(e);
+    for (int i = 0; i < 10; ++i) {
+        run(e, sim, 1, 1, 1);
+        run(e, sim, 200, 0, 1);
+    }
+    TEST_ASSERT_EQUAL_UINT32(10, e.stats.segments);
+    TEST_ASSERT_EQUAL_UINT32(0, e.stats.dropped);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 1.0, sim.pos);
+}
+
+void test_steady_spin_merges_counts() {
+    SimPlanner sim;
+    JogEngine  e(&sim);
+    setup_engine(e);
+    // 2 counts every 5 ms, 40 mm/s, for 2 s
+    uint32_t stop_ms = run(e, sim, 2000, 2, 5);
+    TEST_ASSERT_EQUAL_UINT32(0, e.stats.dropped);
+    TEST_ASSERT_LESS_OR_EQUAL(2000 / JOG_WINDOW_MS + 1, e.stats.segments);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 80.0, sim.pos);
+    TEST_ASSERT_LESS_THAN(JOG_MAX_LAG_MS + JOG_WINDOW_MS + 100, stop_ms);
+    printf("Steady spin: %.1f segments/s (400 events/s), stopped %u ms after the wheel\n",
+           e.stats.segments / 2.0,
+           (unsigned)stop_ms);
+}
+
+// Sends one segment per encoder event, as start_mpg_jog() did
+class Naive {
+    SimPlanner& _sim;
+
+public:
+    Naive(SimPlanner& sim) : _sim(sim) {}
+    void encoder(int counts) {
+        jog_segment_t seg = {};
+        seg.distance[0]   = counts * STEP_E4;
+        seg.feed          = MAX_FEED;
+        _sim.jog(seg);
+    }
+};
+
+void test_fast_spin_stops_with_the_wheel() {
+    // 20 counts every 5 ms is 400 mm/s, well past the 166 mm/s maximum
+    SimPlanner sim;
+    JogEngine  e(&sim);
+    setup_engine(e);
+    uint32_t stop_ms = run(e, sim, 2000, 20, 5);
+    TEST_ASSERT_GREATER_THAN(0, e.stats.dropped);
+    TEST_ASSERT_LESS_THAN(JOG_MAX_LAG_MS + JOG_WINDOW_MS + 400, stop_ms);
+
+    SimPlanner naive_sim;
+    Naive      naive(naive_sim);
+    uint32_t   t = 0;
+    for (; t < 2000; ++t) {
+        if (t % 5 == 0) {
+            naive.encoder(20);
+        }
+        naive_sim.step(t);
+    }
+    uint32_t naive_stop = t;
+    while (naive_sim.moving()) {
+        naive_sim.step(t++);
+    }
+    TEST_ASSERT_GREATER_THAN(2000, t - naive_stop);
+    printf("Fast spin: engine %.1f segments/s, stopped after %u ms; one line per event %u segments/s, stopped after %u ms\n",
+           e.stats.segments / 2.0,
+           (unsigned)stop_ms,
+           (unsigned)(naive_sim.segments / 2),
+           (unsigned)(t - naive_stop));
+}
+
+void test_reversal_cancels_and_replans() {
+    SimPlanner sim;
+    JogEngine  e(&sim);
+    setup_engine(e);
+    // Fast enough that motion is in flight when the wheel turns back
+    turn(e, sim, 500, 4, 5);
+    double turned = sim.pos;
+    turn(e, sim, 1000, -2, 5);
+    uint32_t stop_ms = settle(e, sim);
+    printf("Reversal: turned at %.1f mm, ended at %.1f mm, stopped %u ms after the wheel\n", turned, sim.pos, (unsigned)stop_ms);
+    TEST_ASSERT_EQUAL_UINT32(1, e.stats.cancels);
+    TEST_ASSERT_FALSE(sim.sent_while_cancelling);
+    TEST_ASSERT_TRUE(sim.pos < turned);
+    TEST_ASSERT_LESS_THAN(JOG_MAX_LAG_MS + JOG_WINDOW_MS + 100, stop_ms);
+}
+
+void test_reset_and_unselected_axes() {
+    SimPlanner sim;
+    JogEngine  e(&sim);
+    int32_t    none[3] = { 0, 0, 0 };
+    e.setAxes(none, 3);
+    e.setMaxFeed(MAX_FEED);
+    run(e, sim, 100, 1, 10);
+    TEST_ASSERT_EQUAL_UINT32(0, e.stats.segments);
+    TEST_ASSERT_EQUAL_UINT32(10, e.stats.dropped);
+
+    setup_engine(e);
+    e.encoder(5, now);
+    e.reset();
+    TEST_ASSERT_TRUE(e.idle(now));
+    run(e, sim, 100, 0, 1);
+    TEST_ASSERT_EQUAL_UINT32(0, e.stats.segments);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_slow_turn_moves_exact_distance);
+    RUN_TEST(test_steady_spin_merges_counts);
+    RUN_TEST(test_fast_spin_stops_with_the_wheel);
+    RUN_TEST(test_reversal_cancels_and_replans);
+    RUN_TEST(test_reset_and_unselected_axes);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#    include <Arduino.h>
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(int argc, char** argv) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,350 @@
+#include <unity.h>
+
+#include "JogStream.h"
+#include "LineCounter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+
+// Host-side tests for continuous jog streaming, against a simulated
+// link with a fixed delay each way and a one-axis jog planner that
+// plans to stop at the end of its queue, as FluidNC does.
+// Run with: pio test -e native_test
+
+static const double   ACCEL_MM_S2 = 500;
+static const uint32_t FEED        = 30000000;  // 3000 mm/min in e4 units, 50 mm/s
+static const uint32_t REPORT_MS   = 200;   // $RI=200
+
+class SimLink : public JogSink {
+    struct wire_t {
+        uint32_t at;      // Arrival time
+        double   mm;      // Jog distance, or 0 for a cancel
+        double   feed;    // mm/s
+        bool     other;   // Some other line, which is only answered
+    };
+    std::deque<wire_t>   _to_machine;
+    std::deque<uint32_t> _to_pendant;  // Replies in flight
+
+    struct queued_t {
+        double rem;
+        double feed;
+    };
+    std::deque<queued_t> _queue;
+    bool                 _cancelling  = false;
+    uint32_t             _next_report = 0;
+
+public:
+    uint32_t delay_ms;
+    bool     replies = true;
+    uint32_t lose    = 0;  // Replies to the next jog lines to lose
+    uint32_t now     = 0;
+
+    double   pos     = 0;
+    double   speed   = 0;
+    double   min_speed = 1e9;  // Lowest speed while checking
+    size_t   max_queue = 0;
+    uint32_t lines   = 0;  // Lines sent
+    uint32_t acks    = 0;  // Replies received
+    uint32_t reports = 0;
+    bool     jogging = false;  // As shown by the last report
+    int32_t  report_pos[1] = { 0 };
+
+    SimLink(uint32_t delay) : delay_ms(delay) {}
+
+    void jog(const jog_segment_t& seg) override {
+        _to_machine.push_back({ now + delay_ms, seg.distance[0] / 10000.0, seg.feed / 600000.0, false });
+        ++lines;
+    }
+    void cancel() override { _to_machine.push_back({ now + delay_ms, 0, 0, false }); }
+
+    // A line such as $G
+    void other_line() {
+        _to_machine.push_back({ now + delay_ms, 0, 0, true });
+        ++lines;
+    }
+
+    bool moving() const { return !_queue.empty() || speed > 0 || _cancelling || !_to_machine.empty(); }
+
+    void step() {
+        const double dt = 0.001;
+        while (!_to_machine.empty() && _to_machine.front().at <= now) {
+            auto w = _to_machine.front();
+            _to_machine.pop_front();
+            if (w.other) {
+                _to_pendant.push_back(now + delay_ms);
+            } else if (w.mm == 0) {
+                _cancelling = true;
+            } else {
+                _queue.push_back({ w.mm, w.feed });
+                if (lose) {
+                    --lose;
+                } else if (replies) {
+                    _to_pendant.push_back(now + delay_ms);
+                }
+            }
+        }
+        while (!_to_pendant.empty() && _to_pendant.front() <= now) {
+            _to_pendant.pop_front();
+            ++acks;
+        }
+        max_queue = std::max(max_queue, _queue.size());
+
+        if (_cancelling) {
+            speed = std::fmax(0, speed - ACCEL_MM_S2 * dt);
+            pos += speed * dt;
+            if (speed == 0) {
+                _queue.clear();
+                _cancelling = false;
+            }
+        } else if (_queue.empty()) {
+            speed = 0;
+        } else {
+            double run = 0;
+            for (auto& q : _queue) {
+                run += q.rem;
+            }
+            double limit = std::fmin(_queue.front().feed, std::sqrt(2 * ACCEL_MM_S2 * run));
+            speed        = speed < limit ? std::fmin(limit, speed + ACCEL_MM_S2 * dt) : std::fmax(limit, speed - ACCEL_MM_S2 * dt);
+            speed        = std::fmax(speed, 1.0);
+            double d     = speed * dt;
+            while (d > 0 && !_queue.empty()) {
+                double take = std::fmin(d, _queue.front().rem);
+                pos += take;
+                _queue.front().rem -= take;
+                d -= take;
+                if (_queue.front().rem < 1e-9) {
+                    _queue.pop_front();
+                }
+            }
+            if (_queue.empty()) {
+                speed = 0;
+            }
+        }
+        if (now >= _next_report) {
+            _next_report  = now + REPORT_MS;
+            jogging       = _queue.size() || _cancelling;
+            report_pos[0] = (int32_t)std::lround(pos * 10000);
+            ++reports;
+        }
+        ++now;
+    }
+};
+
+static const int32_t plus_x[1] = { 1000 };
+
+// Holds the button for ms, polling on every millisecond
+static void hold(JogStream& s, SimLink& link, uint32_t ms, bool check_speed = false) {
+    for (uint32_t end = link.now + ms; link.now < end;) {
+        s.poll(link.now, link.lines, link.acks);
+        if (check_speed) {
+            link.min_speed = std::fmin(link.min_speed, link.speed);
+        }
+        link.step();
+    }
+}
+
+// As hold(), but with the replies matched to lines by a LineCounter,
+// as the pendant does
+struct Counted {
+    LineCounter counter;
+    uint32_t    acks = 0;  // Replies given to the counter
+
+    void hold(JogStream& s, SimLink& link, uint32_t ms) {
+        for (uint32_t end = link.now + ms; link.now < end;) {
+            counter.update(&link, link.lines, link.now);
+            for (; acks < link.acks; ++acks) {
+                counter.reply();
+            }
+            s.poll(link.now, counter.sent(), counter.replies());
+            link.step();
+        }
+    }
+};
+
+// Runs without the pendant until the machine stops, returning the
+// distance moved
+static double coast(SimLink& link) {
+    double from = link.pos;
+    while (link.moving() && link.now < 600000) {
+        link.step();
+    }
+    return link.pos - from;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_hold_runs_at_feed() {
+    SimLink   link(20);
+    JogStream s(&link);
+    s.start(plus_x, 1, FEED, link.now);
+    hold(s, link, 1000);
+    hold(s, link, 2000, true);
+    printf("Hold at 50 mm/s with 20 ms each way: round trip %u ms, %u ms segments, lowest speed %.1f mm/s, %u queued\n",
+           (unsigned)s.stats.latency_ms,
+           (unsigned)s.segmentMs(),
+           link.min_speed,
+           (unsigned)link.max_queue);
+    TEST_ASSERT_FLOAT_WITHIN(2, 50, link.min_speed);
+    TEST_ASSERT_UINT32_WITHIN(5, 40, s.stats.latency_ms);
+    TEST_ASSERT_EQUAL_UINT32(JOG_STREAM_MIN_MS, s.segmentMs());
+    // Plus the one being executed
+    TEST_ASSERT_LESS_OR_EQUAL(JOG_STREAM_DEPTH + 1, link.max_queue);
+}
+
+void test_segments_follow_latency() {
+    SimLink   link(75);
+    JogStream s(&link);
+    s.start(plus_x, 1, FEED, link.now);
+    hold(s, link, 1500);
+    hold(s, link, 2000, true);
+    TEST_ASSERT_UINT32_WITHIN(10, 150, s.segmentMs());
+    TEST_ASSERT_FLOAT_WITHIN(2, 50, link.min_speed);
+}
+
+void test_lost_release_stops_within_bound() {
+    SimLink   link(20);
+    JogStream s(&link);
+    s.start(plus_x, 1, FEED, link.now);
+    hold(s, link, 2000);
+    // The pendant stops: no more segments, and no cancel either
+    double coasted = coast(link);
+    // The queued segments, the one still on the wire, and the distance
+    // the machine fell behind while it accelerated
+    double v       = FEED / 600000.0;
+    double bound   = (JOG_STREAM_DEPTH * s.segmentMs() + link.delay_ms) * v / 1000 + v * v / (2 * ACCEL_MM_S2);
+    printf("Lost release: coasted %.1f mm (bound %.1f mm); a single 5000 mm jog would run to its end\n", coasted, bound);
+    TEST_ASSERT_TRUE(coasted > 0);
+    TEST_ASSERT_TRUE(coasted <= bound);
+}
+
+void test_release_records_stop_distance() {
+    SimLink   link(20);
+    JogStream s(&link);
+    s.start(plus_x, 1, FEED, link.now);
+    hold(s, link, 1000);
+    s.stop(link.now, link.report_pos, link.reports);
+    link.cancel();
+    for (int i = 0; i < 2000; ++i) {
+        s.poll(link.now, link.lines, link.acks);
+        s.report(link.jogging, link.reports, link.report_pos);
+        link.step();
+    }
+    printf("Release: stopped %.2f mm after the last report, %.2f mm queued\n", s.stats.stop_e4 / 10000.0, s.stats.bound_e4 / 10000.0);
+    TEST_ASSERT_EQUAL_UINT32(1, s.stats.stops);
+    TEST_ASSERT_GREATER_THAN(0, s.stats.stop_e4);
+    TEST_ASSERT_EQUAL_UINT32(s.stats.stop_e4, s.stats.max_stop_e4);
+    TEST_ASSERT_FALSE(s.streaming());
+}
+
+void test_no_replies_limits_lines() {
+    SimLink link(20);
+    link.replies = false;
+    JogStream s(&link);
+    s.start(plus_x, 1, FEED, link.now);
+    hold(s, link, 500);
+    TEST_ASSERT_EQUAL_UINT32(JOG_STREAM_DEPTH, s.stats.segments);
+    TEST_ASSERT_EQUAL_UINT32(0, s.stats.acks);
+}
+
+void test_other_replies_are_not_acks() {
+    SimLink   link(20);
+    JogStream s(&link);
+    // The reply to $G arrives after the first segment has gone out
+    link.other_line();
+    while (link.now < 30) {
+        link.step();
+    }
+    s.start(plus_x, 1, FEED, link.now);
+    hold(s, link, 15);
+    TEST_ASSERT_EQUAL_UINT32(1, link.acks);
+    TEST_ASSERT_EQUAL_UINT32(0, s.stats.acks);
+
+    // More lines while streaming
+    for (int i = 0; i < 5; ++i) {
+        link.other_line();
+        hold(s, link, 100);
+    }
+    printf("Other lines while streaming: %u replies, %u segment acks, round trip %u ms, max %u ms\n",
+           (unsigned)link.acks,
+           (unsigned)s.stats.acks,
+           (unsigned)s.stats.latency_ms,
+           (unsigned)s.stats.max_latency_ms);
+    TEST_ASSERT_EQUAL_UINT32(link.acks - 6, s.stats.acks);
+    TEST_ASSERT_UINT32_WITHIN(5, 40, s.stats.latency_ms);
+}
+
+void test_lost_replies_recover() {
+    SimLink   link(20);
+    JogStream s(&link);
+    Counted   c;
+    s.start(plus_x, 1, FEED, link.now);
+    c.hold(s, link, 1000);
+    // Every segment in flight loses its reply, so replies lag the
+    // count by the whole queue
+    link.lose = JOG_STREAM_DEPTH;
+    c.hold(s, link, 3000);
+    uint32_t segments = s.stats.segments;
+    uint32_t acks     = s.stats.acks;
+    c.hold(s, link, 1000);
+    printf("%u replies lost while streaming: %u given up, then %u of %u segments acked, round trip %u ms\n",
+           (unsigned)JOG_STREAM_DEPTH,
+           (unsigned)c.counter.lost,
+           (unsigned)(s.stats.acks - acks),
+           (unsigned)(s.stats.segments - segments),
+           (unsigned)s.stats.latency_ms);
+    TEST_ASSERT_EQUAL_UINT32(JOG_STREAM_DEPTH, c.counter.lost);
+    TEST_ASSERT_UINT32_WITHIN(5, 40, s.stats.latency_ms);
+    TEST_ASSERT_UINT32_WITHIN(JOG_STREAM_DEPTH, s.stats.segments - segments, s.stats.acks - acks);
+    TEST_ASSERT_EQUAL_UINT32(JOG_STREAM_MIN_MS, s.segmentMs());
+}
+
+void test_lagging_reply_cleared_between_jogs() {
+    SimLink   link(20);
+    JogStream s(&link);
+    Counted   c;
+    s.start(plus_x, 1, FEED, link.now);
+    c.hold(s, link, 500);
+    // One lost reply makes each segment wait for the next one's reply
+    link.lose = 1;
+    c.hold(s, link, 1000);
+    uint32_t lagging_ms = s.stats.latency_ms;
+    s.stop(link.now, link.report_pos, link.reports);
+    link.cancel();
+    c.hold(s, link, LINE_REPLY_TIMEOUT_MS + 100);
+
+    s.start(plus_x, 1, FEED, link.now);
+    c.hold(s, link, 1000);
+    printf("1 reply lost: round trip %u ms while it lagged, %u ms on the next jog\n", (unsigned)lagging_ms, (unsigned)s.stats.latency_ms);
+    TEST_ASSERT_GREATER_THAN(60, lagging_ms);
+    TEST_ASSERT_EQUAL_UINT32(1, c.counter.lost);
+    TEST_ASSERT_UINT32_WITHIN(5, 40, s.stats.latency_ms);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_hold_runs_at_feed);
+    RUN_TEST(test_segments_follow_latency);
+    RUN_TEST(test_lost_release_stops_within_bound);
+    RUN_TEST(test_release_records_stop_distance);
+    RUN_TEST(test_no_replies_limits_lines);
+    RUN_TEST(test_other_replies_are_not_acks);
+    RUN_TEST(test_lost_replies_recover);
+    RUN_TEST(test_lagging_reply_cleared_between_jogs);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#    include <Arduino.h>
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(int argc, char** argv) {
+    return runUnityTests();
+}
+#endif
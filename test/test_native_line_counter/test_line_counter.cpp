@@ -0,0 +1,100 @@
+#include <unity.h>
+
+#include "LineCounter.h"
+
+// Host-side tests for matching FluidNC's replies to the lines sent.
+// Run with: pio test -e native_test
+
+static int transport_a, transport_b;  // Stand-ins for transports
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_replies_answer_lines_in_order() {
+    LineCounter c;
+    c.update(&transport_a, 3, 0);
+    TEST_ASSERT_EQUAL_UINT32(3, c.sent());
+    TEST_ASSERT_EQUAL_UINT32(0, c.replies());
+    c.update(&transport_a, 3, 10);
+    c.reply();
+    c.reply();
+    TEST_ASSERT_EQUAL_UINT32(2, c.replies());
+    c.reply();
+    c.reply();  // Nothing waiting for this one
+    TEST_ASSERT_EQUAL_UINT32(3, c.replies());
+    TEST_ASSERT_EQUAL_UINT32(1, c.stray);
+    TEST_ASSERT_EQUAL_UINT32(0, c.lost);
+}
+
+void test_lost_reply_times_out() {
+    LineCounter c;
+    c.update(&transport_a, 1, 0);
+    c.update(&transport_a, 2, 500);
+    c.update(&transport_a, 2, LINE_REPLY_TIMEOUT_MS);
+    TEST_ASSERT_EQUAL_UINT32(0, c.replies());
+    // The first line's reply never comes.  The second line's may have
+    // been lost with it, so neither is waited for any longer.
+    c.update(&transport_a, 2, LINE_REPLY_TIMEOUT_MS + 1);
+    TEST_ASSERT_EQUAL_UINT32(2, c.replies());
+    TEST_ASSERT_EQUAL_UINT32(2, c.lost);
+    c.reply();  // The second line's reply, late
+    TEST_ASSERT_EQUAL_UINT32(1, c.stray);
+    // Lines sent afterwards are matched as before
+    c.update(&transport_a, 3, LINE_REPLY_TIMEOUT_MS + 10);
+    c.reply();
+    TEST_ASSERT_EQUAL_UINT32(3, c.replies());
+    c.update(&transport_a, 3, LINE_REPLY_TIMEOUT_MS * 3);
+    TEST_ASSERT_EQUAL_UINT32(2, c.lost);
+}
+
+void test_new_transport_resyncs() {
+    LineCounter c;
+    c.update(&transport_a, 5, 0);
+    c.reply();
+    // The connection is replaced with lines in flight.  Its count of
+    // lines starts again, but sent() and replies() go on from where
+    // they were.
+    c.update(&transport_b, 0, 100);
+    TEST_ASSERT_EQUAL_UINT32(5, c.sent());
+    TEST_ASSERT_EQUAL_UINT32(5, c.replies());
+    TEST_ASSERT_EQUAL_UINT32(4, c.lost);
+    c.update(&transport_b, 2, 110);
+    c.reply();
+    TEST_ASSERT_EQUAL_UINT32(7, c.sent());
+    TEST_ASSERT_EQUAL_UINT32(6, c.replies());
+}
+
+void test_resync_gives_up_on_waiting_lines() {
+    LineCounter c;
+    c.update(&transport_a, 4, 0);
+    c.reply();
+    c.resync();  // FluidNC reset
+    TEST_ASSERT_EQUAL_UINT32(4, c.replies());
+    TEST_ASSERT_EQUAL_UINT32(3, c.lost);
+    c.reply();  // A late reply from before the reset
+    TEST_ASSERT_EQUAL_UINT32(4, c.replies());
+    TEST_ASSERT_EQUAL_UINT32(1, c.stray);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_replies_answer_lines_in_order);
+    RUN_TEST(test_lost_reply_times_out);
+    RUN_TEST(test_new_transport_resyncs);
+    RUN_TEST(test_resync_gives_up_on_waiting_lines);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#    include <Arduino.h>
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(int argc, char** argv) {
+    return runUnityTests();
+}
+#endif
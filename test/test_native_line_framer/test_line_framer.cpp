@@ -0,0 +1,213 @@
+#include <unity.h>
+
+#include "transport/line_framer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Host-side tests and benchmark for the receive-side line framing that
+// feeds the GrblParser.
+// Run with: pio test -e native_test
+
+static const char* recorded_traffic[] = {
+    "<Jog|MPos:12.340,-3.500,0.000|FS:1000,0|WCO:0.000,0.000,0.000>\r\n",
+    "<Jog|MPos:12.840,-3.500,0.000|FS:1000,0|Ov:100,100,100>\r\n",
+    "ok\r\n",
+    "[MSG:INFO: Homing done]\r\n",
+    "[GC:G0 G54 G17 G21 G90 G94 M5 M9 T0 F0 S0]\r\n",
+    "ok\r\n",
+    "<Idle|MPos:12.840,-3.500,0.000|FS:0,0>\r\n",
+};
+static const int n_recorded = sizeof(recorded_traffic) / sizeof(recorded_traffic[0]);
+
+static std::string traffic(size_t min_size) {
+    std::string s;
+    while (s.size() < min_size) {
+        for (auto line : recorded_traffic) {
+            s += line;
+        }
+    }
+    return s;
+}
+
+static LineFramer* framer;
+
+void setUp(void) {
+    framer = new LineFramer;
+}
+void tearDown(void) {
+    delete framer;
+}
+
+static std::string drain() {
+    std::string out;
+    int         c;
+    while ((c = framer->getChar()) >= 0) {
+        out += (char)c;
+    }
+    return out;
+}
+
+void test_partial_line_is_held() {
+    TEST_ASSERT_EQUAL(0, framer->push((const uint8_t*)"<Idle|MPos:", 11));
+    TEST_ASSERT_EQUAL(-1, framer->getChar());
+    TEST_ASSERT_EQUAL(11, framer->partial());
+
+    TEST_ASSERT_EQUAL(1, framer->push((const uint8_t*)"0,0,0>\r\nok", 10));
+    TEST_ASSERT_EQUAL_STRING("<Idle|MPos:0,0,0>\r\n", drain().c_str());
+    TEST_ASSERT_EQUAL(2, framer->partial());
+
+    TEST_ASSERT_EQUAL(1, framer->push((const uint8_t*)"\r\n", 2));
+    TEST_ASSERT_EQUAL_STRING("ok\r\n", drain().c_str());
+    TEST_ASSERT_EQUAL_UINT32(2, framer->lines);
+}
+
+void test_several_lines_in_one_block() {
+    std::string block = traffic(1);
+    TEST_ASSERT_EQUAL(n_recorded, framer->push((const uint8_t*)block.data(), block.size()));
+    TEST_ASSERT_EQUAL(block.size(), framer->ready());
+    TEST_ASSERT_TRUE(drain() == block);
+}
+
+void test_overlong_line_is_released() {
+    std::string junk(LineFramer::max_line + 10, 'x');
+    TEST_ASSERT_EQUAL(0, framer->push((const uint8_t*)junk.data(), junk.size()));
+    TEST_ASSERT_EQUAL_UINT32(1, framer->overlong);
+    TEST_ASSERT_TRUE(drain() == junk);
+
+    TEST_ASSERT_EQUAL(0, framer->push((const uint8_t*)"ok", 2));
+    TEST_ASSERT_EQUAL(-1, framer->getChar());
+    framer->release_partial();
+    TEST_ASSERT_EQUAL_STRING("ok", drain().c_str());
+}
+
+void test_random_blocks_round_trip() {
+    std::string input = traffic(100000);
+    std::string output;
+    srand(1);
+    size_t pos   = 0;
+    size_t lines = 0;
+    while (pos < input.size()) {
+        size_t   room;
+        uint8_t* dst = framer->reserve(room);
+        size_t   n   = 1 + rand() % 300;
+        if (n > room) {
+            n = room;
+        }
+        if (n > input.size() - pos) {
+            n = input.size() - pos;
+        }
+        memcpy(dst, input.data() + pos, n);
+        pos += n;
+        lines += framer->commit(n);
+        // Whatever the parser sees always ends at a line boundary
+        std::string got = drain();
+        TEST_ASSERT_TRUE(got.empty() || got.back() == '\n');
+        output += got;
+    }
+    TEST_ASSERT_TRUE(output == input);
+    TEST_ASSERT_EQUAL(lines, framer->lines);
+    TEST_ASSERT_EQUAL_UINT32(0, framer->overlong);
+}
+
+// What fnc_getchar() used to do: fetch one byte per call and note the
+// RX time for each one
+static const char* legacy_src;
+static size_t      legacy_len;
+static size_t      legacy_pos;
+static volatile uint32_t rx_time;
+
+static int __attribute__((noinline)) legacy_read_byte() {
+    return legacy_pos < legacy_len ? (uint8_t)legacy_src[legacy_pos++] : -1;
+}
+static uint32_t __attribute__((noinline)) fake_millis() {
+    return (uint32_t)legacy_pos;
+}
+static int legacy_getchar() {
+    int c = legacy_read_byte();
+    if (c >= 0) {
+        rx_time = fake_millis();
+    }
+    return c;
+}
+
+void test_benchmark_framing() {
+    std::string input  = traffic(1000000);
+    const int   rounds = 20;
+
+    auto     t0      = std::chrono::steady_clock::now();
+    uint32_t sum_old = 0;
+    for (int i = 0; i < rounds; ++i) {
+        legacy_src = input.data();
+        legacy_len = input.size();
+        legacy_pos = 0;
+        int c;
+        while ((c = legacy_getchar()) >= 0) {
+            sum_old += c;
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    uint32_t sum_new = 0;
+    uint32_t updates = 0;
+    for (int i = 0; i < rounds; ++i) {
+        size_t pos = 0;
+        while (pos < input.size()) {
+            size_t   room;
+            uint8_t* dst = framer->reserve(room);
+            size_t   n   = input.size() - pos < 256 ? input.size() - pos : 256;
+            if (n > room) {
+                n = room;
+            }
+            memcpy(dst, input.data() + pos, n);  // The UART driver's copy
+            pos += n;
+            framer->commit(n);
+            int c;
+            while ((c = framer->getChar()) >= 0) {
+                sum_new += c;
+                if (c == '\n') {
+                    rx_time = fake_millis();
+                    ++updates;
+                }
+            }
+        }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double old_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds / input.size();
+    double new_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / rounds / input.size();
+    printf("%u bytes: per-byte %.2f ns/byte, framed %.2f ns/byte, %u RX time updates instead of %u\n",
+           (unsigned)input.size(),
+           old_ns,
+           new_ns,
+           (unsigned)(updates / rounds),
+           (unsigned)input.size());
+
+    TEST_ASSERT_EQUAL_UINT32(sum_old, sum_new);
+    TEST_ASSERT_EQUAL_UINT32(framer->lines, updates);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_partial_line_is_held);
+    RUN_TEST(test_several_lines_in_one_block);
+    RUN_TEST(test_overlong_line_is_released);
+    RUN_TEST(test_random_blocks_round_trip);
+    RUN_TEST(test_benchmark_framing);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#    include <Arduino.h>
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(int argc, char** argv) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,107 @@
+#include <unity.h>
+
+#include "LoopTiming.h"
+#include <string>
+
+// Host-side tests for the main loop phase timing and stall records.
+// Times are passed in, so each iteration is built phase by phase.
+// Run with: pio test -e native_test
+
+static uint32_t now = 0;
+
+// One iteration with the given phase lengths in microseconds
+static const loop_stall_t* iteration(LoopTimer& t, uint32_t transport, uint32_t poll, uint32_t events, const char* scene = "Status") {
+    t.start(now);
+    now += transport;
+    t.mark(LP_TRANSPORT, now);
+    now += poll;
+    t.mark(LP_POLL, now);
+    now += events;
+    t.mark(LP_EVENTS, now);
+    t.mark(LP_FLUSH, now);
+    return t.finish(now, now / 1000, scene);
+}
+
+void setUp(void) {
+    now = 0;
+}
+
+void tearDown(void) {}
+
+void test_phases_are_counted() {
+    LoopTimer t;
+    for (int i = 0; i < 100; ++i) {
+        iteration(t, 10, 200, 3000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(100, t.iterations.count);
+    TEST_ASSERT_EQUAL_UINT32(3210, t.iterations.max_us);
+    TEST_ASSERT_EQUAL_UINT32(100, t.phases[LP_POLL].count);
+    TEST_ASSERT_EQUAL_UINT32(200, t.phases[LP_POLL].average_us());
+    TEST_ASSERT_EQUAL_UINT32(3000, t.phases[LP_EVENTS].max_us);
+    TEST_ASSERT_EQUAL_UINT32(0, t.phases[LP_WIFI].count);  // Never marked
+    TEST_ASSERT_EQUAL_UINT32(0, t.stall_count);
+}
+
+void test_stall_names_longest_phase_and_scene() {
+    LoopTimer t(250);
+    TEST_ASSERT_NULL(iteration(t, 100, 100, 100));
+    const loop_stall_t* s = iteration(t, 1800000, 500, 20000, "Jog");
+    TEST_ASSERT_NOT_NULL(s);
+    TEST_ASSERT_EQUAL(LP_TRANSPORT, s->phase);
+    TEST_ASSERT_EQUAL_UINT32(1800000, s->phase_us);
+    TEST_ASSERT_EQUAL_UINT32(1820500, s->total_us);
+    TEST_ASSERT_EQUAL_STRING("Jog", s->scene);
+    TEST_ASSERT_EQUAL_UINT32(1, t.stall_count);
+    TEST_ASSERT_EQUAL_UINT32(1, t.stalls());
+}
+
+void test_stall_ring_keeps_latest() {
+    LoopTimer t(1);
+    for (uint32_t i = 0; i < LOOP_STALL_RECORDS + 5; ++i) {
+        iteration(t, 0, 2000 + i, 0);
+    }
+    TEST_ASSERT_EQUAL_UINT32(LOOP_STALL_RECORDS + 5, t.stall_count);
+    TEST_ASSERT_EQUAL_UINT32(LOOP_STALL_RECORDS, t.stalls());
+    TEST_ASSERT_EQUAL_UINT32(2000 + LOOP_STALL_RECORDS + 4, t.stall(0).total_us);
+    TEST_ASSERT_EQUAL_UINT32(2005, t.stall(LOOP_STALL_RECORDS - 1).total_us);
+    TEST_ASSERT_EQUAL(LP_POLL, t.stall(0).phase);
+}
+
+static std::string dumped;
+static void collect(const char* line) {
+    dumped += line;
+}
+
+void test_dump() {
+    LoopTimer t(250);
+    iteration(t, 10, 10, 10);
+    iteration(t, 10, 10, 300000, "Files");
+    dumped.clear();
+    t.dump(collect);
+    TEST_ASSERT_TRUE(dumped.find("events") != std::string::npos);
+    TEST_ASSERT_TRUE(dumped.find("wifi") == std::string::npos);
+    TEST_ASSERT_TRUE(dumped.find("1 stalls over 250 ms") != std::string::npos);
+    TEST_ASSERT_TRUE(dumped.find("300 ms in events, scene Files") != std::string::npos);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_phases_are_counted);
+    RUN_TEST(test_stall_names_longest_phase_and_scene);
+    RUN_TEST(test_stall_ring_keeps_latest);
+    RUN_TEST(test_dump);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#    include <Arduino.h>
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(int argc, char** argv) {
+    return runUnityTests();
+}
+#endif
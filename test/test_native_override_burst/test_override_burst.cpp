@@ -0,0 +1,150 @@
+#include <unity.h>
+
+#include "OverrideBurst.h"
+#include "transport/tx_lanes.h"
+#include <cstdio>
+
+// Host-side tests for the override bursts sent from StatusScene, and
+// that the largest of them fits the urgent lane without a byte lost.
+// Run with: pio test -e native_test
+
+static const override_cmds_t feed = { 0x91, 0x92, 0x93, 0x94 };
+
+// Applies the commands as FluidNC does
+static int apply(int percent, const uint8_t* cmds, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        switch (cmds[i]) {
+            case 0x91:
+                percent += 10;
+                break;
+            case 0x92:
+                percent -= 10;
+                break;
+            case 0x93:
+                percent += 1;
+                break;
+            case 0x94:
+                percent -= 1;
+                break;
+        }
+        if (percent > OVERRIDE_MAX_PERCENT) {
+            percent = OVERRIDE_MAX_PERCENT;
+        } else if (percent < OVERRIDE_MIN_PERCENT) {
+            percent = OVERRIDE_MIN_PERCENT;
+        }
+    }
+    return percent;
+}
+
+class CountingSink : public TxSink {
+public:
+    size_t rt = 0;
+    void   sendRT(uint8_t) override { ++rt; }
+    void   sendLine(const char*) override {}
+    void   write(const uint8_t*, size_t) override {}
+};
+
+static uint32_t now_us() {
+    return 0;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_small_changes_are_fine_steps() {
+    uint8_t out[OVERRIDE_BURST_MAX];
+    size_t  n = override_burst(3, 100, feed, out, sizeof(out));
+    TEST_ASSERT_EQUAL(3, n);
+    TEST_ASSERT_EQUAL_HEX8(0x93, out[0]);
+    TEST_ASSERT_EQUAL(103, apply(100, out, n));
+
+    n = override_burst(-1, 100, feed, out, sizeof(out));
+    TEST_ASSERT_EQUAL(1, n);
+    TEST_ASSERT_EQUAL_HEX8(0x94, out[0]);
+}
+
+void test_large_changes_use_coarse_steps() {
+    uint8_t out[OVERRIDE_BURST_MAX];
+    size_t  n = override_burst(37, 100, feed, out, sizeof(out));
+    TEST_ASSERT_EQUAL(3 + 7, n);
+    TEST_ASSERT_EQUAL(137, apply(100, out, n));
+
+    n = override_burst(-45, 100, feed, out, sizeof(out));
+    TEST_ASSERT_EQUAL(4 + 5, n);
+    TEST_ASSERT_EQUAL(55, apply(100, out, n));
+}
+
+void test_changes_stop_at_the_limits() {
+    uint8_t out[OVERRIDE_BURST_MAX];
+    size_t  n = override_burst(50, 195, feed, out, sizeof(out));
+    TEST_ASSERT_EQUAL(5, n);
+    TEST_ASSERT_EQUAL(200, apply(195, out, n));
+
+    TEST_ASSERT_EQUAL(0, override_burst(1, 200, feed, out, sizeof(out)));
+    TEST_ASSERT_EQUAL(0, override_burst(-1, 10, feed, out, sizeof(out)));
+    for (int percent = OVERRIDE_MIN_PERCENT; percent <= OVERRIDE_MAX_PERCENT; ++percent) {
+        for (int delta = -300; delta <= 300; delta += 7) {
+            n = override_burst(delta, percent, feed, out, sizeof(out));
+            TEST_ASSERT_LESS_OR_EQUAL(OVERRIDE_BURST_MAX, n);
+            int want = percent + delta;
+            want     = want > OVERRIDE_MAX_PERCENT ? OVERRIDE_MAX_PERCENT : want < OVERRIDE_MIN_PERCENT ? OVERRIDE_MIN_PERCENT : want;
+            TEST_ASSERT_EQUAL(want, apply(percent, out, n));
+        }
+    }
+}
+
+void test_worst_bursts_fit_the_urgent_lane() {
+    // Full range in both directions and back, queued before the comms
+    // task gets to run, with a JogCancel and a FeedHold in among them
+    TxLanes lanes;
+    uint8_t out[OVERRIDE_BURST_MAX];
+    size_t  queued  = 0;
+    int     percent = OVERRIDE_MIN_PERCENT;
+    for (int delta : { 190, -190, 190, -190 }) {
+        size_t n = override_burst(delta, percent, feed, out, sizeof(out));
+        percent  = apply(percent, out, n);
+        for (size_t i = 0; i < n; ++i) {
+            TEST_ASSERT_TRUE(lanes.pushRT(out[i], now_us()));
+        }
+        queued += n;
+    }
+    TEST_ASSERT_TRUE(lanes.pushRT(TxLanes::jog_cancel, now_us()));
+    TEST_ASSERT_TRUE(lanes.pushRT(0x21, now_us()));
+    queued += 2;
+
+    CountingSink sink;
+    lanes.service(sink, now_us);
+    printf("Worst bursts: %u realtime bytes queued, %u sent, %u dropped\n", (unsigned)queued, (unsigned)sink.rt, (unsigned)lanes.rt_dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, lanes.rt_dropped);
+    TEST_ASSERT_EQUAL(queued, sink.rt);
+
+    // The full range as 1% steps, as it was once sent, fits as well
+    TxLanes fine;
+    for (int i = 0; i < OVERRIDE_MAX_PERCENT - OVERRIDE_MIN_PERCENT; ++i) {
+        TEST_ASSERT_TRUE(fine.pushRT(0x93, now_us()));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, fine.rt_dropped);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_small_changes_are_fine_steps);
+    RUN_TEST(test_large_changes_use_coarse_steps);
+    RUN_TEST(test_changes_stop_at_the_limits);
+    RUN_TEST(test_worst_bursts_fit_the_urgent_lane);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#    include <Arduino.h>
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(int argc, char** argv) {
+    return runUnityTests();
+}
+#endif
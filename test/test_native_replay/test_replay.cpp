@@ -0,0 +1,218 @@
+#include <unity.h>
+
+#include "transport/capture.h"
+#include "transport/replay_transport.h"
+#include "transport/line_framer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Host-side tests for the capture format and ReplayTransport, and a
+// benchmark that replays the corpus in test/corpus through the framer.
+// Run with: pio test -e native_test
+
+static uint32_t fake_now = 0;
+static uint32_t now_us() {
+    return fake_now;
+}
+
+class StringOutput : public CaptureOutput {
+public:
+    std::string text;
+    void        write(const char* s, size_t len) override { text.append(s, len); }
+};
+
+static const char* sample =
+    "# FluidDial capture v1: <us> <R|S> <bytes>\n"
+    "0 S $RI=200\\n\n"
+    "2500 R ok\\r\\n\n"
+    "200000 R <Run|MPos:1.000,2.000,3.000|FS:1200,0>\\r\\n\n"
+    "200300 S \\x91\n"
+    "400000 R [JSON:{\"path\":\"C:\\\\sd\"}]\\r\\n\n";
+
+void setUp(void) {
+    fake_now = 0;
+}
+void tearDown(void) {}
+
+void test_capture_round_trip() {
+    std::vector<CaptureRecord> records;
+    TEST_ASSERT_EQUAL(5, load_capture(sample, strlen(sample), records));
+    TEST_ASSERT_EQUAL('S', records[0].dir);
+    TEST_ASSERT_EQUAL_STRING("$RI=200\n", records[0].data.c_str());
+    TEST_ASSERT_EQUAL_UINT32(200300, records[3].t_us);
+    TEST_ASSERT_EQUAL_STRING("\x91", records[3].data.c_str());
+    TEST_ASSERT_EQUAL_STRING("[JSON:{\"path\":\"C:\\sd\"}]\r\n", records[4].data.c_str());
+
+    StringOutput* out = new StringOutput;
+    {
+        CaptureWriter writer(out);
+        for (auto& r : records) {
+            writer.record(r.t_us, r.dir, (const uint8_t*)r.data.data(), r.data.size());
+        }
+    }
+    TEST_ASSERT_EQUAL_STRING(sample, out->text.c_str());
+    delete out;
+}
+
+void test_timed_replay() {
+    std::vector<CaptureRecord> records;
+    load_capture(sample, strlen(sample), records);
+    ReplayTransport replay(records, ReplayTransport::TIMED, now_us);
+    fake_now = 1000000;
+    replay.begin();
+
+    uint8_t buf[256];
+    TEST_ASSERT_EQUAL(0, replay.read(buf, sizeof(buf)));
+    fake_now += 2500;
+    TEST_ASSERT_EQUAL(4, replay.read(buf, sizeof(buf)));
+    fake_now += 300000;
+    size_t n = replay.read(buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(records[2].data.size(), n);
+    TEST_ASSERT_FALSE(replay.finished());
+
+    replay.sendRT(0x91);
+    replay.sendLine("$J=G91 X1 F1000");
+    TEST_ASSERT_EQUAL(2, replay.sent.size());
+    TEST_ASSERT_EQUAL_UINT32(302500, replay.sent[0].t_us);
+    TEST_ASSERT_EQUAL_STRING("$J=G91 X1 F1000\n", replay.sent[1].data.c_str());
+
+    fake_now += 100000;
+    TEST_ASSERT_EQUAL(records[4].data.size(), replay.read(buf, sizeof(buf)));
+    TEST_ASSERT_TRUE(replay.finished());
+}
+
+void test_max_speed_small_reads() {
+    std::vector<CaptureRecord> records;
+    load_capture(sample, strlen(sample), records);
+    ReplayTransport replay(records, ReplayTransport::MAX_SPEED, now_us);
+    replay.begin();
+
+    std::string expected, got;
+    for (auto& r : records) {
+        if (r.dir == 'R') {
+            expected += r.data;
+        }
+    }
+    uint8_t buf[7];
+    size_t  n;
+    while ((n = replay.read(buf, sizeof(buf))) != 0) {
+        got.append((const char*)buf, n);
+    }
+    TEST_ASSERT_TRUE(got == expected);
+    TEST_ASSERT_TRUE(replay.finished());
+    TEST_ASSERT_EQUAL(-1, replay.getChar());
+}
+
+void test_capture_transport_records_both_ways() {
+    std::vector<CaptureRecord> records;
+    load_capture(sample, strlen(sample), records);
+
+    StringOutput*    out = new StringOutput;
+    CaptureTransport capture(new ReplayTransport(records, ReplayTransport::MAX_SPEED, now_us), true, out, now_us);
+    capture.begin();
+    uint8_t buf[256];
+    while (capture.read(buf, sizeof(buf))) {}
+    fake_now = 1234;
+    capture.sendRT(0x18);
+
+    std::vector<CaptureRecord> again;
+    load_capture(out->text.data(), out->text.size(), again);
+    TEST_ASSERT_EQUAL(2, again.size());  // One read took everything
+    TEST_ASSERT_EQUAL('R', again[0].dir);
+    TEST_ASSERT_EQUAL_UINT32(1234, again[1].t_us);
+    TEST_ASSERT_EQUAL_STRING("\x18", again[1].data.c_str());
+}
+
+static bool load_corpus(const char* name, std::vector<CaptureRecord>& records) {
+    std::string   path = std::string("test/corpus/") + name;
+    std::ifstream f(path, std::ios::binary);
+    if (!f) {
+        return false;
+    }
+    std::stringstream ss;
+    ss << f.rdbuf();
+    std::string text = ss.str();
+    return load_capture(text.data(), text.size(), records) != 0;
+}
+
+void test_benchmark_corpus() {
+    static const char* corpus[] = { "job_ri200.cap", "files_list.cap", "macros.cap" };
+    for (auto name : corpus) {
+        std::vector<CaptureRecord> records;
+        if (!load_corpus(name, records)) {
+            TEST_IGNORE_MESSAGE("Run from the project directory to find test/corpus");
+        }
+
+        // Everything the replay delivers, split into lines as the
+        // pendant would see them
+        const int rounds  = 20;
+        size_t    bytes   = 0;
+        size_t    reports = 0;
+        size_t    json    = 0;
+        auto      t0      = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i) {
+            ReplayTransport replay(records, ReplayTransport::MAX_SPEED, now_us);
+            LineFramer*     framer = new LineFramer;
+            replay.begin();
+            bool line_start = true;
+            while (true) {
+                size_t   room;
+                uint8_t* dst = framer->reserve(room);
+                size_t   n   = replay.read(dst, room < 256 ? room : 256);
+                if (!n) {
+                    break;
+                }
+                framer->commit(n);
+                bytes += n;
+                int c;
+                while ((c = framer->getChar()) >= 0) {
+                    if (line_start) {
+                        reports += c == '<';
+                        json += c == '[';
+                    }
+                    line_start = c == '\n';
+                }
+            }
+            TEST_ASSERT_TRUE(replay.finished());
+            delete framer;
+        }
+        auto   t1 = std::chrono::steady_clock::now();
+        double us = std::chrono::duration<double, std::micro>(t1 - t0).count() / rounds;
+        printf("%s: %u records, %u bytes, %u status reports, %u [ lines, %.3f s captured, replayed in %.1f us\n",
+               name,
+               (unsigned)records.size(),
+               (unsigned)(bytes / rounds),
+               (unsigned)(reports / rounds),
+               (unsigned)(json / rounds),
+               records.back().t_us / 1e6,
+               us);
+        TEST_ASSERT_TRUE(bytes > 0);
+    }
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_capture_round_trip);
+    RUN_TEST(test_timed_replay);
+    RUN_TEST(test_max_speed_small_reads);
+    RUN_TEST(test_capture_transport_records_both_ways);
+    RUN_TEST(test_benchmark_corpus);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#    include <Arduino.h>
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(int argc, char** argv) {
+    return runUnityTests();
+}
+#endif
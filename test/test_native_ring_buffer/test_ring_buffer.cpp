@@ -0,0 +1,158 @@
+#include <unity.h>
+
+#include "transport/ring_buffer.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Host-side tests and benchmark for the WebSocket receive buffer.
+// Run with: pio test -e native_test
+
+// Traffic captured from FluidNC: status reports while jogging, a
+// $Files/ListGCode reply and the start of a $File/ShowSome preview.
+static const char* recorded_traffic[] = {
+    "<Jog|MPos:12.340,-3.500,0.000|FS:1000,0|WCO:0.000,0.000,0.000>\r\n",
+    "<Jog|MPos:12.840,-3.500,0.000|FS:1000,0|Ov:100,100,100>\r\n",
+    "ok\r\n",
+    "[JSON:{\"files\":[{\"name\":\"calibration_cube.nc\",\"size\":\"48213\"},"
+    "{\"name\":\"logo_engrave.nc\",\"size\":\"216104\"},{\"name\":\"pocket_50x30.nc\",\"size\":\"7310\"},"
+    "{\"name\":\"drill_pattern.nc\",\"size\":\"2144\"},{\"name\":\"spoilboard_surface.gcode\",\"size\":\"90122\"}],"
+    "\"path\":\"/sd\",\"total\":\"29.7GB\",\"used\":\"4.1MB\",\"occupation\":\"1\",\"status\":\"Ok\"}]\r\n",
+    "ok\r\n",
+    "[MSG:Files changed]\r\n",
+    "[JSON:{\"cmd\":\"$File/ShowSome=0:8,/sd/pocket_50x30.nc\",\"status\":\"ok\",\"file_lines\":[\"G21\",\"G90\","
+    "\"G0 Z5.000\",\"G0 X0.000 Y0.000\",\"M3 S12000\",\"G1 Z-1.000 F300\",\"G1 X50.000 F800\",\"G1 Y30.000\"]}]\r\n",
+    "ok\r\n",
+    "<Idle|MPos:12.840,-3.500,0.000|FS:0,0>\r\n",
+};
+
+static std::string traffic() {
+    std::string s;
+    for (auto line : recorded_traffic) {
+        s += line;
+    }
+    return s;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_read_write_wraps() {
+    RingBuffer<16> ring;
+    uint8_t        out[16];
+    for (int round = 0; round < 10; ++round) {
+        uint8_t in[11];
+        for (int i = 0; i < 11; ++i) {
+            in[i] = round * 11 + i;
+        }
+        TEST_ASSERT_EQUAL(11, ring.write(in, 11));
+        TEST_ASSERT_EQUAL(11, ring.available());
+        TEST_ASSERT_EQUAL(11, ring.read(out, sizeof(out)));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(in, out, 11);
+    }
+    TEST_ASSERT_EQUAL(-1, ring.getChar());
+}
+
+void test_overflow_is_counted() {
+    RingBuffer<16> ring;
+    uint8_t        in[20] = { 0 };
+    TEST_ASSERT_EQUAL(16, ring.write(in, 20));
+    TEST_ASSERT_EQUAL_UINT32(4, ring.overflow_bytes);
+    TEST_ASSERT_EQUAL_UINT32(1, ring.overflow_events);
+    TEST_ASSERT_EQUAL(0, ring.space());
+    TEST_ASSERT_EQUAL(16, ring.high_water);
+
+    TEST_ASSERT_EQUAL(0, ring.write(in, 1));
+    TEST_ASSERT_EQUAL_UINT32(5, ring.overflow_bytes);
+    TEST_ASSERT_EQUAL_UINT32(2, ring.overflow_events);
+}
+
+void test_clear_discards() {
+    RingBuffer<16> ring;
+    ring.write((const uint8_t*)"abc", 3);
+    ring.clear();
+    TEST_ASSERT_EQUAL(0, ring.available());
+    TEST_ASSERT_EQUAL(16, ring.space());
+}
+
+// The old receive path: append each payload to a string and remove
+// the first character for every byte read.
+static std::string legacy_drain(const std::string& input, size_t burst) {
+    std::string buffer, out;
+    for (size_t pos = 0; pos < input.size(); pos += burst) {
+        buffer += input.substr(pos, burst);
+    }
+    while (buffer.length()) {
+        out += buffer[0];
+        buffer.erase(0, 1);
+    }
+    return out;
+}
+
+static std::string ring_drain(RingBuffer<8192>& ring, const std::string& input, size_t burst) {
+    std::string out;
+    uint8_t     block[128];
+    for (size_t pos = 0; pos < input.size(); pos += burst) {
+        size_t len = input.size() - pos < burst ? input.size() - pos : burst;
+        ring.write((const uint8_t*)input.data() + pos, len);
+    }
+    size_t n;
+    while ((n = ring.read(block, sizeof(block))) != 0) {
+        out.append((const char*)block, n);
+    }
+    return out;
+}
+
+void test_benchmark_recorded_traffic() {
+    std::string input;
+    while (input.size() < 7000) {
+        input += traffic();
+    }
+    const int    rounds = 50;
+    const size_t burst  = 1460;  // One TCP segment per WebSocket event
+
+    auto        t0 = std::chrono::steady_clock::now();
+    std::string legacy;
+    for (int i = 0; i < rounds; ++i) {
+        legacy = legacy_drain(input, burst);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    RingBuffer<8192> ring;
+    std::string      drained;
+    for (int i = 0; i < rounds; ++i) {
+        drained = ring_drain(ring, input, burst);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double legacy_us = std::chrono::duration<double, std::micro>(t1 - t0).count() / rounds;
+    double ring_us   = std::chrono::duration<double, std::micro>(t2 - t1).count() / rounds;
+    printf("%u byte burst: String %.1f us, ring %.1f us\n", (unsigned)input.size(), legacy_us, ring_us);
+
+    TEST_ASSERT_TRUE(drained == input);
+    TEST_ASSERT_TRUE(legacy == input);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.overflow_bytes);
+    TEST_ASSERT_TRUE(ring_us < legacy_us);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_read_write_wraps);
+    RUN_TEST(test_overflow_is_counted);
+    RUN_TEST(test_clear_discards);
+    RUN_TEST(test_benchmark_recorded_traffic);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#    include <Arduino.h>
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(int argc, char** argv) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,128 @@
+#include <unity.h>
+
+#include "TileDiff.h"
+#include <cstdio>
+#include <cstring>
+
+// Host-side tests and push-size benchmark for the tile-diff refresh.
+// Run with: pio test -e native_test
+
+static const int width  = 240;
+static const int height = 240;
+
+static uint8_t                   frame[width * height];
+static TileDiff                  tile_diff;
+static std::vector<dirty_rect_t> rects;
+
+static void fill(int x, int y, int w, int h, uint8_t color) {
+    for (int row = y; row < y + h; ++row) {
+        memset(frame + row * width + x, color, w);
+    }
+}
+
+// A DRO line like the ones in StatusScene and MultiJogScene
+static void draw_dro_line(int y, uint8_t digit_color) {
+    fill(16, y, 210, 32, 0x02);             // Navy stripe
+    fill(186, y + 6, 14, 20, digit_color);  // Last digit
+}
+
+void setUp(void) {
+    memset(frame, 0, sizeof(frame));
+    tile_diff.begin(width, height);
+}
+
+void tearDown(void) {}
+
+void test_first_frame_is_full() {
+    TEST_ASSERT_EQUAL_UINT32(width * height, tile_diff.diff(frame, width, 1, rects));
+    TEST_ASSERT_EQUAL(1, rects.size());
+}
+
+void test_unchanged_frame_sends_nothing() {
+    tile_diff.diff(frame, width, 1, rects);
+    TEST_ASSERT_EQUAL_UINT32(0, tile_diff.diff(frame, width, 1, rects));
+    TEST_ASSERT_EQUAL(0, rects.size());
+    TEST_ASSERT_EQUAL_UINT32(1, tile_diff.skipped);
+}
+
+void test_invalidate_forces_full_frame() {
+    tile_diff.diff(frame, width, 1, rects);
+    tile_diff.invalidate();
+    TEST_ASSERT_EQUAL_UINT32(width * height, tile_diff.diff(frame, width, 1, rects));
+}
+
+void test_single_digit_change_is_small() {
+    draw_dro_line(68, 0xff);
+    tile_diff.diff(frame, width, 1, rects);
+
+    fill(186, 74, 14, 20, 0xe0);
+    uint32_t pixels = tile_diff.diff(frame, width, 1, rects);
+    TEST_ASSERT_EQUAL(1, rects.size());
+    TEST_ASSERT_TRUE(pixels * 10 <= width * height);
+}
+
+void test_vertical_runs_merge() {
+    tile_diff.diff(frame, width, 1, rects);
+    fill(32, 32, 48, 100, 0x1c);
+    tile_diff.diff(frame, width, 1, rects);
+    TEST_ASSERT_EQUAL(1, rects.size());
+    TEST_ASSERT_EQUAL(32, rects[0].x);
+    TEST_ASSERT_EQUAL(32, rects[0].y);
+    TEST_ASSERT_EQUAL(48, rects[0].w);
+    TEST_ASSERT_EQUAL(112, rects[0].h);
+}
+
+void test_partial_edge_tiles() {
+    TileDiff odd(16);
+    odd.begin(100, 50);
+    static uint8_t small[100 * 50] = {};
+    odd.diff(small, 100, 1, rects);
+    small[49 * 100 + 99] = 1;
+    TEST_ASSERT_EQUAL_UINT32(4 * 2, odd.diff(small, 100, 1, rects));
+    TEST_ASSERT_EQUAL(96, rects[0].x);
+    TEST_ASSERT_EQUAL(48, rects[0].y);
+}
+
+// Bytes on the wire per frame for a DRO-only update of 3 axes,
+// assuming an RGB565 panel, versus a full-canvas pushSprite().
+void test_benchmark_dro_update_bytes() {
+    for (int axis = 0; axis < 3; ++axis) {
+        draw_dro_line(68 + axis * 33, 0xff);
+    }
+    tile_diff.diff(frame, width, 1, rects);
+
+    const int n_frames = 100;
+    uint64_t  start    = tile_diff.total_pixels;
+    for (int i = 0; i < n_frames; ++i) {
+        fill(186, 68 + 6 + (i % 3) * 33, 14, 20, (uint8_t)i);
+        tile_diff.diff(frame, width, 1, rects);
+    }
+    uint32_t bytes_per_frame = (uint32_t)((tile_diff.total_pixels - start) * 2 / n_frames);
+    printf("DRO update: %u bytes/frame (full frame %u)\n", bytes_per_frame, width * height * 2);
+    TEST_ASSERT_TRUE(bytes_per_frame * 10 <= width * height * 2);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_frame_is_full);
+    RUN_TEST(test_unchanged_frame_sends_nothing);
+    RUN_TEST(test_invalidate_forces_full_frame);
+    RUN_TEST(test_single_digit_change_is_small);
+    RUN_TEST(test_vertical_runs_merge);
+    RUN_TEST(test_partial_edge_tiles);
+    RUN_TEST(test_benchmark_dro_update_bytes);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#    include <Arduino.h>
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(int argc, char** argv) {
+    return runUnityTests();
+}
+#endif
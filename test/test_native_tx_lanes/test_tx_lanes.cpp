@@ -0,0 +1,203 @@
+#include <unity.h>
+
+#include "transport/tx_lanes.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Host-side tests for the realtime and line lanes used by CommsTask.
+// A fake sink stands in for the transport and advances a fake clock by
+// the wire time of what it sends, so latencies are deterministic.
+// Run with: pio test -e native_test
+
+static uint32_t fake_now = 0;
+static uint32_t now_us() {
+    return fake_now;
+}
+
+static const uint32_t us_per_byte = 10;  // 1 Mbaud
+
+class FakeSink : public TxSink {
+public:
+    std::vector<std::string> sent;  // "RT:xx" or the line text
+    TxLanes*                 lanes = nullptr;
+
+    // Realtime bytes to queue while a given line is on the wire, as if
+    // a button were pressed during the send
+    int     press_during_line = -1;
+    uint8_t press_byte        = 0;
+    int     lines_sent        = 0;
+
+    void sendRT(uint8_t c) override {
+        char s[8];
+        snprintf(s, sizeof(s), "RT:%02x", c);
+        sent.push_back(s);
+        fake_now += us_per_byte;
+    }
+    void sendLine(const char* line) override {
+        if (lines_sent++ == press_during_line) {
+            fake_now += us_per_byte;
+            lanes->pushRT(press_byte, fake_now);
+        }
+        sent.push_back(line);
+        fake_now += (strlen(line) + 2) * us_per_byte;
+    }
+    void write(const uint8_t* buf, size_t len) override {
+        sent.push_back(std::string((const char*)buf, len));
+        fake_now += len * us_per_byte;
+    }
+};
+
+static TxLanes* lanes;
+static FakeSink sink;
+
+void setUp(void) {
+    fake_now   = 0;
+    lanes      = new TxLanes;
+    sink       = FakeSink();
+    sink.lanes = lanes;
+}
+void tearDown(void) {
+    delete lanes;
+}
+
+static std::string macro_line(int n) {
+    std::string line = "G1 X" + std::to_string(n) + " Y" + std::to_string(n);
+    while (line.size() < 200) {
+        line += " (comment)";
+    }
+    return line.substr(0, 200);
+}
+
+void test_rt_goes_before_queued_lines() {
+    for (int i = 0; i < 5; ++i) {
+        std::string line = macro_line(i);
+        TEST_ASSERT_TRUE(lanes->pushLine(TxLanes::LINE, (const uint8_t*)line.data(), line.size(), now_us()));
+    }
+    TEST_ASSERT_TRUE(lanes->pushRT(0x85, now_us()));  // JogCancel
+    lanes->service(sink, now_us);
+
+    TEST_ASSERT_EQUAL(6, sink.sent.size());
+    TEST_ASSERT_EQUAL_STRING("RT:85", sink.sent[0].c_str());
+    TEST_ASSERT_EQUAL_STRING(macro_line(0).c_str(), sink.sent[1].c_str());
+}
+
+void test_rt_waits_for_at_most_one_line_under_load() {
+    // Keep the line lane full and press a button in the middle of it,
+    // so the realtime byte has to overtake the lines queued behind
+    int      presses = 0;
+    uint32_t bound   = (200 + 2) * us_per_byte + 2 * us_per_byte;
+    for (int round = 0; round < 50; ++round) {
+        int queued = 0;
+        while (true) {
+            std::string line = macro_line(round * 100 + queued);
+            if (!lanes->pushLine(TxLanes::LINE, (const uint8_t*)line.data(), line.size(), now_us())) {
+                break;
+            }
+            ++queued;
+        }
+        sink.press_during_line = sink.lines_sent + queued / 2;
+        sink.press_byte        = 0x18;  // Reset
+        lanes->service(sink, now_us);
+        ++presses;
+    }
+    printf("RT latency: n=%u max=%u us p99<=%u us; line latency max=%u us\n",
+           lanes->rt_latency.count,
+           lanes->rt_latency.max_us,
+           lanes->rt_latency.percentile_us(99),
+           lanes->line_latency.max_us);
+    TEST_ASSERT_EQUAL_UINT32(presses, lanes->rt_latency.count);
+    TEST_ASSERT_TRUE(lanes->rt_latency.max_us <= bound);
+    TEST_ASSERT_TRUE(lanes->line_latency.max_us > 5 * bound);
+}
+
+void test_normal_lane_is_bounded() {
+    std::string line = macro_line(0);
+    int         n    = 0;
+    while (lanes->pushLine(TxLanes::LINE, (const uint8_t*)line.data(), line.size(), now_us())) {
+        ++n;
+    }
+    TEST_ASSERT_EQUAL(TX_NORMAL_QUEUE_SIZE / (line.size() + 7), n);
+    TEST_ASSERT_EQUAL_UINT32(1, lanes->line_dropped);
+
+    // Realtime bytes still get through when the line lane is full
+    TEST_ASSERT_TRUE(lanes->pushRT(0x21, now_us()));  // FeedHold
+    lanes->service(sink, now_us);
+    TEST_ASSERT_EQUAL_STRING("RT:21", sink.sent[0].c_str());
+}
+
+static void push_line(const char* line) {
+    TEST_ASSERT_TRUE(lanes->pushLine(TxLanes::LINE, (const uint8_t*)line, strlen(line), now_us()));
+}
+
+void test_jog_cancel_drops_queued_jogs() {
+    push_line("$J=G91G21X1.0000F3000");
+    push_line("$G");
+    push_line("$J=G91G21X1.0000F3000");
+    TEST_ASSERT_TRUE(lanes->pushRT(TxLanes::jog_cancel, now_us()));
+    push_line("$J=G91G21X-1.0000F3000");  // A new jog after the cancel
+    lanes->service(sink, now_us);
+
+    TEST_ASSERT_EQUAL(3, sink.sent.size());
+    TEST_ASSERT_EQUAL_STRING("RT:85", sink.sent[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("$G", sink.sent[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("$J=G91G21X-1.0000F3000", sink.sent[2].c_str());
+    TEST_ASSERT_EQUAL_UINT32(2, lanes->jog_dropped);
+
+    // Other realtime bytes leave jogs alone
+    push_line("$J=G91G21X1.0000F3000");
+    TEST_ASSERT_TRUE(lanes->pushRT(0x21, now_us()));  // FeedHold
+    lanes->service(sink, now_us);
+    TEST_ASSERT_EQUAL(5, sink.sent.size());
+    TEST_ASSERT_EQUAL_UINT32(2, lanes->jog_dropped);
+}
+
+void test_drop_jog_lines_from_staged_text() {
+    char     text[] = "1.0000F3000\n$J=G91X1F100\n$G\n$J=G91X2F100\n$J=G9";
+    uint32_t dropped = 0;
+    size_t   len     = drop_jog_lines((uint8_t*)text, strlen(text), dropped);
+    // The tail of a line already partly sent, and the unfinished one, stay
+    TEST_ASSERT_EQUAL_STRING("1.0000F3000\n$G\n$J=G9", std::string(text, len).c_str());
+    TEST_ASSERT_EQUAL_UINT32(2, dropped);
+}
+
+void test_histogram_buckets() {
+    LatencyHistogram h;
+    for (int i = 0; i < 98; ++i) {
+        h.add(10);
+    }
+    h.add(1000);
+    h.add(100000000);
+    TEST_ASSERT_EQUAL_UINT32(100, h.count);
+    TEST_ASSERT_EQUAL_UINT32(98, h.buckets[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, h.buckets[4]);  // 512..1023 us
+    TEST_ASSERT_EQUAL_UINT32(1, h.buckets[LatencyHistogram::n_buckets - 1]);
+    TEST_ASSERT_EQUAL_UINT32(64, h.percentile_us(50));
+    TEST_ASSERT_EQUAL_UINT32(1024, h.percentile_us(99));
+    TEST_ASSERT_EQUAL_UINT32(100000000, h.percentile_us(100));
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rt_goes_before_queued_lines);
+    RUN_TEST(test_rt_waits_for_at_most_one_line_under_load);
+    RUN_TEST(test_normal_lane_is_bounded);
+    RUN_TEST(test_jog_cancel_drops_queued_jogs);
+    RUN_TEST(test_drop_jog_lines_from_staged_text);
+    RUN_TEST(test_histogram_buckets);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#    include <Arduino.h>
+void setup() {
+    delay(2000);  // Wait for serial monitor
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(int argc, char** argv) {
+    return runUnityTests();
+}
+#endif
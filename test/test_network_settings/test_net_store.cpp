@@ -146,6 +146,70 @@ void test_clear_removes_file() {
     TEST_ASSERT_EQUAL_STRING("ws", transport);
 }
 
+static wifi_rejoin_t sample_rejoin() {
+    wifi_rejoin_t r;
+    const uint8_t bssid[6] = { 0x24, 0x0a, 0xc4, 0x12, 0xab, 0xef };
+    memcpy(r.bssid, bssid, sizeof(r.bssid));
+    r.channel = 11;
+    r.ip = IPAddress(192, 168, 1, 50);
+    r.gateway = IPAddress(192, 168, 1, 1);
+    r.mask = IPAddress(255, 255, 255, 0);
+    r.dns = IPAddress(192, 168, 1, 1);
+    return r;
+}
+
+void test_rejoin_round_trip() {
+    NetStore::netSave("shop", "pass", "fluidnc.local", 81, "ws");
+    wifi_rejoin_t saved = sample_rejoin();
+    TEST_ASSERT_TRUE(NetStore::saveRejoin("shop", saved));
+    
+    wifi_rejoin_t loaded;
+    TEST_ASSERT_TRUE(NetStore::loadRejoin("shop", loaded));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(saved.bssid, loaded.bssid, 6);
+    TEST_ASSERT_EQUAL_INT32(11, loaded.channel);
+    TEST_ASSERT_EQUAL_UINT32(saved.ip, loaded.ip);
+    TEST_ASSERT_EQUAL_UINT32(saved.gateway, loaded.gateway);
+    TEST_ASSERT_EQUAL_UINT32(saved.mask, loaded.mask);
+    
+    // The record belongs to the network it was made on
+    TEST_ASSERT_FALSE(NetStore::loadRejoin("office", loaded));
+}
+
+void test_netSave_keeps_rejoin_for_same_ssid_only() {
+    NetStore::netSave("shop", "pass", "fluidnc.local", 81, "ws");
+    NetStore::saveRejoin("shop", sample_rejoin());
+    
+    // A host change keeps the cache
+    NetStore::saveFluidNCHost("cnc.local", 23);
+    wifi_rejoin_t loaded;
+    TEST_ASSERT_TRUE(NetStore::loadRejoin("shop", loaded));
+    
+    // A new network drops it
+    NetStore::saveWifiCredentials("office", "pass");
+    NetStore::saveWifiCredentials("shop", "pass");
+    TEST_ASSERT_FALSE(NetStore::loadRejoin("shop", loaded));
+}
+
+void test_static_ip_is_optional() {
+    NetStore::netSave("shop", "pass", "fluidnc.local", 81, "ws");
+    wifi_static_ip_t config;
+    TEST_ASSERT_FALSE(NetStore::loadStaticIp(config));
+    TEST_ASSERT_FALSE(config.enabled);
+    
+    File file = LittleFS.open("/net.json", "w");
+    file.print("{\"ssid\":\"shop\",\"pass\":\"pass\",\"reuse_lease\":true,"
+               "\"static_ip\":{\"ip\":\"10.0.0.20\",\"gateway\":\"10.0.0.1\"}}");
+    file.close();
+    TEST_ASSERT_TRUE(NetStore::loadStaticIp(config));
+    TEST_ASSERT_TRUE(config.reuse_lease);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)IPAddress(10, 0, 0, 20), config.ip);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)IPAddress(255, 255, 255, 0), config.mask);
+    
+    // Settings saved from the UI leave it alone
+    NetStore::saveFluidNCHost("cnc.local", 23);
+    TEST_ASSERT_TRUE(NetStore::loadStaticIp(config));
+}
+
 void setup() {
     // NOTE!!! Wait for >2 secs
     // if board doesn't support software reset via Serial.DTR/RTS
@@ -159,6 +223,9 @@ void setup() {
     RUN_TEST(test_saveWifiCredentials_preserves_host_settings);
     RUN_TEST(test_saveFluidNCHost_preserves_wifi_settings);
     RUN_TEST(test_clear_removes_file);
+    RUN_TEST(test_rejoin_round_trip);
+    RUN_TEST(test_netSave_keeps_rejoin_for_same_ssid_only);
+    RUN_TEST(test_static_ip_is_optional);
     
     UNITY_END(); // stop unit testing
 }
@@ -0,0 +1,730 @@
+# This script is a stand-in for a FluidNC controller, for exercising the
+# pendant without a machine.  It speaks the part of the FluidNC protocol
+# that FluidDial uses: status reports, $G, $A, $I, $RI=, $J= jogs with a
+# simulated planner, $Files/ListGCode, $File/ShowSome, $File/SendJSON,
+# $/axes/... settings, $SD/Run jobs, and the realtime bytes.
+#
+# It serves the same simulated machine on any of:
+#   --pty          a pseudo-terminal, for the UART path (prints its name)
+#   --tcp PORT     raw TCP, for TelnetTransport (FluidNC uses 23)
+#   --ws PORT      WebSocket, for WSTransport (FluidNC uses 81)
+#
+# Link knobs apply to each direction of every connection:
+#   --latency MS   one-way delay
+#   --jitter MS    extra random delay, 0..MS
+#   --loss PCT     chance that a chunk is lost.  TCP and WebSocket stall
+#                  for --rto MS as a retransmit would; the pty drops it.
+#
+# Load knobs:
+#   --rate HZ      status report rate, overriding $RI (hundreds of Hz work)
+#   --sd DIR       serve real G-code files instead of generated ones
+#
+# Only the Python standard library is needed.  See docs/FLUIDNC_SIMULATOR.md.
+
+import argparse
+import asyncio
+import base64
+import collections
+import hashlib
+import json
+import math
+import os
+import random
+import re
+import socket
+import struct
+import sys
+import time
+import tty
+
+AXIS_LETTERS = "XYZABC"
+PLANNER_BLOCKS = 16
+JSON_CHUNK = 120
+
+MACROS = [
+    ("Home", "/macro0.g", "$H"),
+    ("Probe Z", "/macro1.g", "G21\nG91\nG38.2 Z-20 F100\nG0 Z2\nG90"),
+    ("Park", "/macro2.g", "G53 G0 Z-1\nG53 G0 X-5 Y-5"),
+    ("Spindle warmup", "/macro3.g", "M3 S8000\nG4 P30\nM5"),
+    ("Zero XY", "/macro4.g", "G10 L20 P0 X0 Y0"),
+]
+
+
+def now():
+    return time.monotonic()
+
+
+class Move:
+    def __init__(self, start, target, feed):
+        self.target = target
+        self.feed = feed  # mm/min
+        delta = [t - s for s, t in zip(start, target)]
+        self.length = math.sqrt(sum(d * d for d in delta))
+
+
+class Machine:
+    """One simulated controller, shared by every connection"""
+
+    def __init__(self, args):
+        self.args = args
+        self.n_axis = args.axes
+        self.mpos = [0.0] * self.n_axis
+        self.wco = [0.0] * self.n_axis
+        self.state = "Idle"
+        self.alarm = 0
+        self.planner = collections.deque()
+        self.velocity = 0.0  # mm/s along the current move
+        self.stopping = None  # "cancel" or "hold" while decelerating
+        self.feed_ovr, self.rapid_ovr, self.spindle_ovr = 100, 100, 100
+        self.spindle = 0
+        self.absolute = True
+        self.job = None
+        self.job_name = ""
+        self.job_lines = 0
+        self.job_done = 0
+        self.homing_until = 0
+        self.settings = {}
+        for letter in AXIS_LETTERS[: self.n_axis].lower():
+            self.settings["/axes/%s/homing/cycle" % letter] = "2" if letter in "xy" else ("1" if letter == "z" else "0")
+            self.settings["/axes/%s/homing/allow_single_axis" % letter] = "true"
+            self.settings["/axes/%s/max_travel_mm" % letter] = "300.000"
+        self.files = self.load_files(args.sd)
+        self.channels = set()
+
+    # Files
+
+    def load_files(self, sd):
+        files = collections.OrderedDict()
+        if sd:
+            for name in sorted(os.listdir(sd)):
+                path = os.path.join(sd, name)
+                if os.path.isfile(path):
+                    with open(path, errors="replace") as f:
+                        files[name] = f.read().splitlines()
+            return files
+        rng = random.Random(1)
+        for i in range(self.args.files):
+            lines = ["G21", "G90", "G0 Z5", "M3 S12000"]
+            for row in range(40 + rng.randint(0, 200)):
+                y = row * 0.5
+                lines.append("G1 X%.3f Y%.3f F%d" % (0 if row % 2 else 80, y, 800 + rng.randint(0, 4) * 100))
+            lines += ["G0 Z5", "M5", "G0 X0 Y0"]
+            files["job_%03d.nc" % i] = lines
+        return files
+
+    def file_lines(self, path):
+        name = path.split("/")[-1]
+        if path.startswith("/localfs"):
+            for _, filename, text in MACROS:
+                if filename == "/" + name:
+                    return text.splitlines()
+            return None
+        return self.files.get(name)
+
+    # Motion
+
+    def tail_position(self):
+        return list(self.planner[-1].target) if self.planner else list(self.mpos)
+
+    def planner_full(self):
+        return len(self.planner) >= PLANNER_BLOCKS
+
+    def plan(self, words, kind, machine_coords=False):
+        target = self.tail_position()
+        feed = words.get("F", self.args.rapid)
+        for i, letter in enumerate(AXIS_LETTERS[: self.n_axis]):
+            if letter in words:
+                value = words[letter]
+                if self.absolute and not machine_coords:
+                    target[i] = value + self.wco[i]
+                elif machine_coords:
+                    target[i] = value
+                else:
+                    target[i] += value
+        move = Move(self.tail_position(), target, feed)
+        if move.length > 0:
+            self.planner.append(move)
+            if self.state in ("Idle", "Jog", "Run"):
+                self.state = kind
+        return True
+
+    def tick(self, dt):
+        if self.state == "Home":
+            if now() >= self.homing_until:
+                self.mpos = [0.0] * self.n_axis
+                self.state = "Idle"
+                self.broadcast("[MSG:Homed:%s]\r\n" % AXIS_LETTERS[: self.n_axis])
+            return
+
+        while self.job and not self.planner_full():
+            try:
+                words, kind = next(self.job)
+            except StopIteration:
+                self.job = None
+                break
+            self.plan(words, kind)
+            self.job_done += 1
+
+        accel = self.args.accel
+        if self.stopping:
+            self.velocity = max(0.0, self.velocity - accel * dt)
+            self.advance(self.velocity * dt)
+            if self.velocity == 0.0:
+                if self.stopping == "cancel":
+                    self.planner.clear()
+                    self.state = "Idle"
+                else:
+                    self.state = "Hold:0"
+                self.stopping = None
+            return
+
+        if self.state.startswith("Hold") or self.state == "Alarm":
+            return
+
+        if not self.planner:
+            self.velocity = 0.0
+            if self.state in ("Jog", "Run") and not self.job:
+                if self.state == "Run" and self.job_name:
+                    self.broadcast("[MSG:INFO: %s file job succeeded]\r\n" % self.job_name)
+                    self.job_name = ""
+                self.state = "Idle"
+            return
+
+        head = self.planner[0]
+        ovr = self.feed_ovr if self.state == "Run" else 100
+        wanted = head.feed / 60.0 * ovr / 100.0
+        remaining = self.distance_to(head.target) + sum(m.length for m in list(self.planner)[1:])
+        braking = math.sqrt(2 * accel * remaining)
+        self.velocity = min(self.velocity + accel * dt, wanted, braking)
+        # Never stall short of the end of the queue
+        self.advance(max(self.velocity * dt, 1e-4))
+
+    def distance_to(self, target):
+        return math.sqrt(sum((t - p) ** 2 for p, t in zip(self.mpos, target)))
+
+    def advance(self, step):
+        while step > 0 and self.planner:
+            head = self.planner[0]
+            left = self.distance_to(head.target)
+            if left <= step:
+                self.mpos = list(head.target)
+                self.planner.popleft()
+                step -= left
+            else:
+                f = step / left
+                self.mpos = [p + (t - p) * f for p, t in zip(self.mpos, head.target)]
+                step = 0
+
+    # Reports
+
+    def feed_rate(self):
+        return int(round(self.velocity * 60))
+
+    def status_report(self, channel):
+        axes = ",".join("%.3f" % p for p in self.mpos)
+        report = "<%s|MPos:%s|FS:%d,%d" % (self.state, axes, self.feed_rate(), self.spindle)
+        channel.report_count += 1
+        if channel.report_count % 10 == 1 or channel.wco_changed:
+            report += "|WCO:" + ",".join("%.3f" % w for w in self.wco)
+            channel.wco_changed = False
+        elif channel.report_count % 10 == 6:
+            report += "|Ov:%d,%d,%d" % (self.feed_ovr, self.rapid_ovr, self.spindle_ovr)
+        if self.job_name and self.job_lines:
+            report += "|SD:%.2f,/sd/%s" % (100.0 * self.job_done / self.job_lines, self.job_name)
+        return report + ">\r\n"
+
+    def broadcast(self, text):
+        for channel in self.channels:
+            channel.send(text)
+
+    # Realtime bytes
+
+    def realtime(self, c, channel):
+        if c == 0x18:
+            aborted = self.state in ("Jog", "Run") and self.velocity > 0
+            self.planner.clear()
+            self.job = None
+            self.job_name = ""
+            self.velocity = 0.0
+            self.stopping = None
+            self.state = "Alarm" if aborted else ("Alarm" if self.alarm else "Idle")
+            if aborted:
+                self.alarm = 3
+            self.broadcast("\r\nGrbl 3.7 [FluidNC v3.7.8 (simulator) '$' for help]\r\n")
+            if aborted:
+                self.broadcast("ALARM:3\r\n")
+        elif c == ord("?"):
+            channel.send(self.status_report(channel))
+        elif c == ord("!"):
+            if self.state in ("Run", "Jog"):
+                self.stopping = "cancel" if self.state == "Jog" else "hold"
+                if self.stopping == "hold":
+                    self.state = "Hold:1"
+        elif c == ord("~"):
+            if self.state.startswith("Hold"):
+                self.state = "Run"
+        elif c == 0x85:
+            if self.state == "Jog":
+                self.stopping = "cancel"
+        elif 0x90 <= c <= 0x94:
+            self.feed_ovr = {0x90: 100, 0x91: self.feed_ovr + 10, 0x92: self.feed_ovr - 10, 0x93: self.feed_ovr + 1, 0x94: self.feed_ovr - 1}[c]
+            self.feed_ovr = min(200, max(10, self.feed_ovr))
+        elif 0x95 <= c <= 0x97:
+            self.rapid_ovr = {0x95: 100, 0x96: 50, 0x97: 25}[c]
+        elif 0x99 <= c <= 0x9D:
+            self.spindle_ovr = {0x99: 100, 0x9A: self.spindle_ovr + 10, 0x9B: self.spindle_ovr - 10, 0x9C: self.spindle_ovr + 1, 0x9D: self.spindle_ovr - 1}[c]
+            self.spindle_ovr = min(200, max(10, self.spindle_ovr))
+        # 0xB2 acknowledges a [JSON: line; nothing waits for it
+
+    # Lines
+
+    def execute(self, line, channel):
+        """Returns False if the line must wait for room in the planner"""
+        if line.startswith("$J="):
+            return self.jog(line[3:], channel)
+        if line.startswith("$"):
+            self.command(line, channel)
+            return True
+        return self.gcode(line, channel)
+
+    def words(self, text):
+        words = {}
+        for letter, value in re.findall(r"([A-Z])\s*([-+]?[0-9]*\.?[0-9]+)", text.upper()):
+            words.setdefault(letter, []).append(float(value))
+        return words
+
+    def jog(self, text, channel):
+        if self.state not in ("Idle", "Jog"):
+            channel.send("error:8\r\n")  # Not idle
+            return True
+        if self.planner_full():
+            return False
+        words = self.words(text)
+        gcodes = [int(g) for g in words.get("G", [])]
+        saved = self.absolute
+        if 90 in gcodes:
+            self.absolute = True
+        if 91 in gcodes:
+            self.absolute = False
+        flat = {k: v[-1] for k, v in words.items() if k != "G"}
+        if "F" not in flat:
+            channel.send("error:22\r\n")  # Undefined feed rate
+        else:
+            self.plan(flat, "Jog", machine_coords=53 in gcodes)
+            channel.send("ok\r\n")
+        self.absolute = saved
+        return True
+
+    def gcode(self, line, channel):
+        if self.state == "Alarm":
+            channel.send("error:9\r\n")  # Locked out
+            return True
+        words = self.words(line.split(";")[0].split("(")[0])
+        gcodes = [int(g) if g == int(g) else g for g in words.get("G", [])]
+        flat = {k: v[-1] for k, v in words.items() if k not in "GM"}
+        for g in gcodes:
+            if g == 90:
+                self.absolute = True
+            elif g == 91:
+                self.absolute = False
+        if 10 in gcodes and flat.get("L") == 20:
+            pos = self.tail_position()
+            for i, letter in enumerate(AXIS_LETTERS[: self.n_axis]):
+                if letter in flat:
+                    self.wco[i] = pos[i] - flat[letter]
+            for c in self.channels:
+                c.wco_changed = True
+        elif any(g in (0, 1) for g in gcodes) or (any(a in flat for a in AXIS_LETTERS) and not gcodes):
+            if self.planner_full():
+                return False
+            if 0 in gcodes:
+                flat["F"] = self.args.rapid * self.rapid_ovr / 100.0
+            self.plan(flat, "Run", machine_coords=53 in gcodes)
+        for m in words.get("M", []):
+            if m in (3, 4):
+                self.spindle = int(flat.get("S", 10000))
+            elif m == 5:
+                self.spindle = 0
+        channel.send("ok\r\n")
+        return True
+
+    def command(self, line, channel):
+        name, _, value = line.partition("=")
+        upper = name.upper()
+        if upper == "$G":
+            mode = "G90" if self.absolute else "G91"
+            channel.send("[GC:G0 G54 G17 G21 %s G94 M%d M9 T0 F0 S%d]\r\nok\r\n" % (mode, 3 if self.spindle else 5, self.spindle))
+        elif upper == "$I":
+            channel.send("[VER:3.7.8 FluidNC v3.7.8 (simulator):]\r\n[OPT:PHS]\r\n[MSG: Machine: Simulator]\r\nok\r\n")
+        elif upper == "$A":
+            if self.alarm:
+                channel.send("ALARM:%d\r\n" % self.alarm)
+            channel.send("ok\r\n")
+        elif upper == "$X":
+            if self.state == "Alarm":
+                self.state = "Idle"
+                self.alarm = 0
+                channel.send("[MSG:Caution: Unlocked]\r\n")
+            channel.send("ok\r\n")
+        elif upper.startswith("$H"):
+            self.state = "Home"
+            self.homing_until = now() + self.args.homing_time
+            self.alarm = 0
+            channel.send("ok\r\n")
+        elif upper == "$RI":
+            if value and not self.args.rate:
+                channel.report_interval = int(value) / 1000.0
+            else:
+                channel.send("$RI=%d\r\n" % int(channel.report_interval * 1000))
+            channel.send("ok\r\n")
+        elif upper == "$ALARM/SEND":
+            self.alarm = int(value or 1)
+            self.state = "Alarm"
+            self.planner.clear()
+            self.job = None
+            self.broadcast("ALARM:%d\r\n" % self.alarm)
+            channel.send("ok\r\n")
+        elif upper == "$FILES/LISTGCODE":
+            files = [{"name": name, "size": str(sum(len(l) + 1 for l in lines))} for name, lines in self.files.items()]
+            channel.json({"files": files, "path": value or "/sd", "total": "29.7GB", "used": "61.4MB", "occupation": "1", "status": "Ok"})
+        elif upper == "$FILE/SHOWSOME":
+            self.show_some(value, channel)
+        elif upper == "$FILE/SENDJSON":
+            self.send_json(value, channel)
+        elif upper == "$SD/RUN":
+            self.run_file(value, channel)
+        elif name.startswith("$/"):
+            key = name[1:].lower()
+            if key not in self.settings:
+                channel.send("error:3\r\n")
+            elif value:
+                self.settings[key] = value
+                channel.send("ok\r\n")
+            else:
+                channel.send("%s=%s\r\nok\r\n" % (name, self.settings[key]))
+        else:
+            channel.send("ok\r\n")
+
+    def show_some(self, value, channel):
+        rng, _, path = value.partition(",")
+        first, _, last = rng.partition(":")
+        lines = self.file_lines(path)
+        cmd = "$File/ShowSome=" + value
+        if lines is None:
+            channel.json({"cmd": cmd, "status": "error", "error": "Cannot open %s" % path})
+            return
+        first, last = int(first or 0), int(last or 0)
+        channel.json({"cmd": cmd, "status": "ok", "firstline": str(first), "file_lines": lines[first:last]})
+
+    def send_json(self, value, channel):
+        cmd = {"cmd": "$File/SendJSON", "argument": value}
+        if value.endswith("macrocfg.json"):
+            result = [{"name": name, "filename": fn, "target": "ESP", "class": "", "index": str(i)} for i, (name, fn, _) in enumerate(MACROS)]
+            cmd.update({"status": "ok", "result": result})
+        else:
+            cmd.update({"status": "error", "error": "Cannot open %s" % value})
+        channel.json(cmd)
+
+    def run_file(self, value, channel):
+        lines = self.file_lines(value)
+        if lines is None:
+            channel.send("error:60\r\n")  # SD failed to open file
+            return
+        if self.state != "Idle":
+            channel.send("error:8\r\n")
+            return
+
+        def moves():
+            for line in lines:
+                words = self.words(line)
+                gcodes = [int(g) for g in words.get("G", [])]
+                flat = {k: v[-1] for k, v in words.items() if k not in "GM"}
+                if any(a in flat for a in AXIS_LETTERS):
+                    if 0 in gcodes:
+                        flat["F"] = self.args.rapid
+                    yield flat, "Run"
+
+        self.job = moves()
+        self.job_name = value.split("/")[-1]
+        self.job_lines = max(1, len(lines))
+        self.job_done = 0
+        self.state = "Run"
+        channel.send("ok\r\n")
+
+
+class Link:
+    """Delays, jitters and loses traffic in one direction"""
+
+    def __init__(self, args, deliver, stream):
+        self.args = args
+        self.deliver = deliver
+        self.stream = stream
+        self.last = 0.0
+        self.lost = 0
+
+    def __call__(self, data):
+        a = self.args
+        if not (a.latency or a.jitter or a.loss):
+            self.deliver(data)
+            return
+        t = now() + (a.latency + random.uniform(0, a.jitter)) / 1000.0
+        if a.loss and random.uniform(0, 100) < a.loss:
+            self.lost += 1
+            if not self.stream:
+                return
+            t += a.rto / 1000.0
+        # A stream never reorders, so a late chunk holds up the ones after it
+        t = max(t, self.last)
+        self.last = t
+        loop = asyncio.get_running_loop()
+        loop.call_at(loop.time() + (t - now()), self.deliver, data)
+
+
+class Channel:
+    """One connection to the simulated controller"""
+
+    def __init__(self, machine, name, write, stream):
+        self.machine = machine
+        self.name = name
+        self.out = Link(machine.args, write, stream)
+        self.into = Link(machine.args, self.receive, stream)
+        self.line = bytearray()
+        self.pending = collections.deque()
+        self.report_interval = 1.0 / machine.args.rate if machine.args.rate else 0
+        self.next_report = now()
+        self.report_count = 0
+        self.wco_changed = True
+        self.xoff = False
+        self.held = bytearray()
+        self.stats = collections.Counter()
+        machine.channels.add(self)
+
+    def close(self):
+        self.machine.channels.discard(self)
+
+    def send(self, text):
+        data = text.encode("latin-1")
+        self.stats["bytes out"] += len(data)
+        if self.xoff:
+            self.held += data
+        else:
+            self.out(data)
+
+    def json(self, obj):
+        text = json.dumps(obj, separators=(",", ":"))
+        for i in range(0, len(text), JSON_CHUNK):
+            self.send("[JSON:" + text[i : i + JSON_CHUNK] + "]\r\n")
+        self.send("ok\r\n")
+
+    def receive(self, data):
+        self.stats["bytes in"] += len(data)
+        for c in data:
+            if c == 0x13:
+                self.xoff = True
+            elif c == 0x11:
+                self.xoff = False
+                if self.held:
+                    self.out(bytes(self.held))
+                    self.held.clear()
+            elif c in b"?!~" or c >= 0x80 or c == 0x18:
+                self.stats["realtime"] += 1
+                self.machine.realtime(c, self)
+            elif c == 0x0A:
+                self.pending.append(self.line.decode("latin-1").strip())
+                self.line.clear()
+            elif c != 0x0D:
+                self.line.append(c)
+        self.service()
+
+    def service(self):
+        while self.pending:
+            line = self.pending[0]
+            if line and not self.machine.execute(line, self):
+                self.stats["planner waits"] += 1
+                return
+            self.stats["lines"] += 1
+            if line.startswith("$J="):
+                self.stats["jogs"] += 1
+            self.pending.popleft()
+
+    def tick(self):
+        self.service()
+        interval = self.report_interval
+        if interval and now() >= self.next_report:
+            self.send(self.machine.status_report(self))
+            self.stats["reports"] += 1
+            self.next_report += interval
+            if self.next_report < now():
+                self.next_report = now() + interval
+
+
+async def run_machine(machine):
+    last = now()
+    while True:
+        await asyncio.sleep(0.001)
+        t = now()
+        machine.tick(t - last)
+        last = t
+        for channel in list(machine.channels):
+            channel.tick()
+
+
+def log(*args):
+    print(*args, file=sys.stderr, flush=True)
+
+
+def serve_pty(machine):
+    master, slave = os.openpty()
+    tty.setraw(slave)
+    os.set_blocking(master, False)
+    log("pty: %s" % os.ttyname(slave))
+
+    def write(data):
+        try:
+            os.write(master, data)
+        except (BlockingIOError, OSError):
+            channel.stats["dropped"] += len(data)
+
+    channel = Channel(machine, "pty", write, stream=False)
+
+    def readable():
+        try:
+            data = os.read(master, 4096)
+        except OSError:
+            return
+        channel.into(data)
+
+    asyncio.get_running_loop().add_reader(master, readable)
+    channel.send("\r\nGrbl 3.7 [FluidNC v3.7.8 (simulator) '$' for help]\r\n")
+    return slave  # Keep the slave open so the pty survives reconnects
+
+
+async def serve_tcp(machine, port):
+    async def client(reader, writer):
+        peer = writer.get_extra_info("peername")
+        sock = writer.get_extra_info("socket")
+        if sock is not None:
+            sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        log("tcp: %s connected" % (peer,))
+        def write(data):
+            if not writer.is_closing():
+                writer.write(data)
+
+        channel = Channel(machine, "tcp %s" % (peer,), write, stream=True)
+        try:
+            while True:
+                data = await reader.read(4096)
+                if not data:
+                    break
+                channel.into(data)
+        except ConnectionError:
+            pass
+        channel.close()
+        log("tcp: %s closed %s" % (peer, dict(channel.stats)))
+
+    server = await asyncio.start_server(client, "0.0.0.0", port)
+    log("tcp: listening on %d" % port)
+    return server
+
+
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+
+def ws_frame(opcode, payload):
+    header = bytes([0x80 | opcode])
+    n = len(payload)
+    if n < 126:
+        header += bytes([n])
+    elif n < 65536:
+        header += bytes([126]) + struct.pack(">H", n)
+    else:
+        header += bytes([127]) + struct.pack(">Q", n)
+    return header + payload
+
+
+async def serve_ws(machine, port):
+    async def client(reader, writer):
+        peer = writer.get_extra_info("peername")
+        try:
+            request = await reader.readuntil(b"\r\n\r\n")
+        except (asyncio.IncompleteReadError, asyncio.LimitOverrunError):
+            writer.close()
+            return
+        key = re.search(rb"Sec-WebSocket-Key:\s*(\S+)", request, re.I)
+        if not key:
+            writer.write(b"HTTP/1.1 400 Bad Request\r\n\r\n")
+            writer.close()
+            return
+        accept = base64.b64encode(hashlib.sha1(key.group(1) + WS_GUID.encode()).digest())
+        writer.write(b"HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n" b"Sec-WebSocket-Accept: " + accept + b"\r\n\r\n")
+        log("ws: %s connected" % (peer,))
+        # FluidNC sends its output as binary frames
+        def write(data):
+            if not writer.is_closing():
+                writer.write(ws_frame(0x2, data))
+
+        channel = Channel(machine, "ws %s" % (peer,), write, stream=True)
+        try:
+            while True:
+                head = await reader.readexactly(2)
+                opcode = head[0] & 0x0F
+                n = head[1] & 0x7F
+                if n == 126:
+                    n = struct.unpack(">H", await reader.readexactly(2))[0]
+                elif n == 127:
+                    n = struct.unpack(">Q", await reader.readexactly(8))[0]
+                mask = await reader.readexactly(4) if head[1] & 0x80 else b"\0\0\0\0"
+                payload = bytes(b ^ mask[i % 4] for i, b in enumerate(await reader.readexactly(n)))
+                if opcode == 0x8:
+                    writer.write(ws_frame(0x8, payload[:2]))
+                    break
+                if opcode == 0x9:
+                    writer.write(ws_frame(0xA, payload))
+                elif opcode in (0x0, 0x1, 0x2):
+                    channel.into(payload)
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        channel.close()
+        writer.close()
+        log("ws: %s closed %s" % (peer, dict(channel.stats)))
+
+    server = await asyncio.start_server(client, "0.0.0.0", port)
+    log("ws: listening on %d" % port)
+    return server
+
+
+async def main(args):
+    machine = Machine(args)
+    keep = []
+    if args.pty:
+        keep.append(serve_pty(machine))
+    if args.tcp:
+        keep.append(await serve_tcp(machine, args.tcp))
+    if args.ws:
+        keep.append(await serve_ws(machine, args.ws))
+    if not keep:
+        log("Nothing to serve; use --pty, --tcp PORT or --ws PORT")
+        return
+    await run_machine(machine)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="FluidNC stand-in for testing FluidDial")
+    parser.add_argument("--pty", action="store_true", help="serve on a pseudo-terminal")
+    parser.add_argument("--tcp", type=int, metavar="PORT", help="serve raw TCP, as FluidNC's telnet port")
+    parser.add_argument("--ws", type=int, metavar="PORT", help="serve WebSocket, as FluidNC's port 81")
+    parser.add_argument("--rate", type=float, default=0, metavar="HZ", help="status report rate, overriding $RI")
+    parser.add_argument("--latency", type=float, default=0, metavar="MS", help="one-way delay")
+    parser.add_argument("--jitter", type=float, default=0, metavar="MS", help="extra random delay")
+    parser.add_argument("--loss", type=float, default=0, metavar="PCT", help="chance a chunk is lost")
+    parser.add_argument("--rto", type=float, default=200, metavar="MS", help="stall for a lost TCP chunk")
+    parser.add_argument("--axes", type=int, default=3, choices=range(1, 7), help="number of axes")
+    parser.add_argument("--accel", type=float, default=500, metavar="MM/S2", help="acceleration")
+    parser.add_argument("--rapid", type=float, default=5000, metavar="MM/MIN", help="G0 and default jog feed")
+    parser.add_argument("--homing-time", type=float, default=1.0, metavar="S", help="how long $H takes")
+    parser.add_argument("--sd", metavar="DIR", help="serve the files in DIR as /sd")
+    parser.add_argument("--files", type=int, default=40, help="number of generated files without --sd")
+    try:
+        asyncio.run(main(parser.parse_args()))
+    except KeyboardInterrupt:
+        pass